@@ -0,0 +1,45 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+
+#define BENCH_ROUNDS 5
+
+/// @brief Best wall time of `rounds` runs of `run`, in nanoseconds.
+/// @details The fastest run is the one the rest of the system disturbed least.
+template <typename Function>
+double bench_best_ns(Function run, int rounds = BENCH_ROUNDS) {
+	double best = 0;
+	for (int round = 0; round < rounds; ++round) {
+		auto start = std::chrono::steady_clock::now();
+		run();
+		double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		if (round == 0 || elapsed < best)
+			best = elapsed;
+	}
+	return (best);
+}
+
+/// @brief Keep the compiler from dropping a result only the benchmark looks at.
+template <typename T>
+inline void bench_keep(const T &value) {
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+/// @brief Print one line with a measurement that has nothing to be compared with.
+inline void bench_print(const std::string &name, double value, const std::string &unit) {
+	std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(12) << "" << "    " << std::setw(10) << value << " " << unit << std::endl;
+}
+
+/// @brief Print one line comparing the implementation a change replaced with the current one.
+/// @param isRate Whether the unit is a rate, higher is better then.
+inline void bench_report(const std::string &name, double before, double after, const std::string &unit, bool isRate = false) {
+	std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(12) << before << " -> " << std::setw(10) << after << " " << unit;
+	if (before > 0 && after > 0)
+		std::cout << "  (" << std::setprecision(1) << (isRate ? after / before : before / after) << "x)";
+	std::cout << std::endl;
+}
@@ -0,0 +1,54 @@
+#include "bench.hpp"
+#include "readBuffer.hpp"
+
+#include <cstring>
+#include <string>
+
+#define BUFFER_BENCH_STREAM_SIZE (256UL * 1024 * 1024)
+#define BUFFER_BENCH_READ_SIZE (64 * 1024)
+#define BUFFER_BENCH_CONSUME_SIZE (8 * 1024)
+
+/// @brief Stream bytes through a buffer that reads 64 KiB at a time and hands out 8 KiB pieces,
+/// keeping `backlog` bytes buffered, like a body arriving faster than it is written out.
+/// The legacy buffer is the std::string FDReader used before ReadBuffer: every piece is
+/// copied out with substr and erased from the front, moving the whole backlog.
+static void benchStream(size_t backlog) {
+	std::string chunk(BUFFER_BENCH_READ_SIZE, 'x');
+
+	double legacy = bench_best_ns([&]() {
+		std::string buffer;
+		for (size_t read = 0; read < BUFFER_BENCH_STREAM_SIZE; read += chunk.size()) {
+			buffer.append(chunk);
+			while (buffer.size() > backlog) {
+				std::string piece = buffer.substr(0, BUFFER_BENCH_CONSUME_SIZE);
+				buffer.erase(0, BUFFER_BENCH_CONSUME_SIZE);
+				bench_keep(piece);
+			}
+		}
+	});
+
+	double current = bench_best_ns([&]() {
+		ReadBuffer buffer;
+		for (size_t read = 0; read < BUFFER_BENCH_STREAM_SIZE; read += chunk.size()) {
+			std::memcpy(buffer.prepareWrite(chunk.size()), chunk.data(), chunk.size());
+			buffer.commitWrite(chunk.size());
+			while (buffer.size() > backlog) {
+				std::string_view piece = buffer.view(BUFFER_BENCH_CONSUME_SIZE);
+				bench_keep(piece);
+				buffer.consume(piece.size());
+			}
+		}
+	});
+
+	double gigabytes = BUFFER_BENCH_STREAM_SIZE / 1e9;
+	bench_report("256 MiB in 8 KiB pieces, " + std::to_string(backlog / 1024) + " KiB buffered",
+		gigabytes / (legacy / 1e9), gigabytes / (current / 1e9), "GB/s", true);
+}
+
+int main() {
+	std::cout << "bufferBench: std::string erase(0, n) -> ReadBuffer" << std::endl;
+	benchStream(64 * 1024);
+	benchStream(1024 * 1024);
+	benchStream(4 * 1024 * 1024);
+	return (0);
+}
@@ -0,0 +1,79 @@
+#include "bench.hpp"
+#include "ioUring.hpp"
+
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <stdexcept>
+#include <vector>
+
+#define IO_ENGINE_BENCH_TICKS 2000
+#define IO_ENGINE_BENCH_BATCH 64
+
+/// @brief The descriptor bookkeeping of a tick in which IO_ENGINE_BENCH_BATCH connections come and go:
+/// each is added to epoll, switched to writing and finally removed and closed. The epoll engine pays a
+/// syscall for every step, the io_uring engine queues them and submits once per step of the batch.
+static void benchBookkeeping() {
+	int epollFd = epoll_create1(EPOLL_CLOEXEC);
+	std::vector<int> fds(IO_ENGINE_BENCH_BATCH);
+
+	auto open_batch = [&fds]() {
+		for (int &fd : fds)
+			fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	};
+
+	double epoll = bench_best_ns([&]() {
+		for (int tick = 0; tick < IO_ENGINE_BENCH_TICKS; ++tick) {
+			open_batch();
+			for (int fd : fds) {
+				epoll_event event{};
+				event.events = EPOLLIN;
+				event.data.fd = fd;
+				epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+			}
+			for (int fd : fds) {
+				epoll_event event{};
+				event.events = EPOLLOUT;
+				event.data.fd = fd;
+				epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+			}
+			for (int fd : fds) {
+				epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+				close(fd);
+			}
+		}
+	});
+
+	double ring = 0;
+	try {
+		IOUring uring;
+		ring = bench_best_ns([&]() {
+			for (int tick = 0; tick < IO_ENGINE_BENCH_TICKS; ++tick) {
+				open_batch();
+				for (int fd : fds)
+					uring.queueEpollCtl(epollFd, EPOLL_CTL_ADD, fd, EPOLLIN);
+				uring.submit();
+				for (int fd : fds)
+					uring.queueEpollCtl(epollFd, EPOLL_CTL_MOD, fd, EPOLLOUT);
+				uring.submit();
+				for (int fd : fds)
+					uring.queueClose(fd, epollFd);
+				uring.submit();
+				uring.processCompletions([](const IOUring::Completion &) {});
+			}
+		});
+	} catch (const std::runtime_error &e) {
+		std::cout << "ioEngineBench: " << e.what() << ", skipping the io_uring engine" << std::endl;
+	}
+	close(epollFd);
+
+	int operations = IO_ENGINE_BENCH_TICKS * IO_ENGINE_BENCH_BATCH;
+	bench_report("add, modify, remove and close a descriptor", epoll / operations, ring / operations, "ns/descriptor");
+}
+
+int main() {
+	std::cout << "ioEngineBench: epoll_ctl and close syscalls -> batched io_uring submissions, "
+		<< IO_ENGINE_BENCH_BATCH << " descriptors per tick" << std::endl;
+	benchBookkeeping();
+	return (0);
+}
@@ -0,0 +1,156 @@
+#include "bench.hpp"
+#include "requestParser.hpp"
+#include "request.hpp"
+#include "cookie.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <map>
+
+#define PARSER_BENCH_ITERATIONS 200000
+
+/// @brief A browser-like head with 12 fields.
+static const std::string g_head =
+	"GET /search/index.html?q=web%20server&page=2 HTTP/1.1\r\n"
+	"Host: localhost:8080\r\n"
+	"User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+	"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+	"Accept-Language: en-US,en;q=0.5\r\n"
+	"Accept-Encoding: gzip, deflate, br, zstd\r\n"
+	"Connection: keep-alive\r\n"
+	"Cookie: session=3f2a9c1e7b5d4a60; theme=dark\r\n"
+	"Upgrade-Insecure-Requests: 1\r\n"
+	"Sec-Fetch-Dest: document\r\n"
+	"Sec-Fetch-Mode: navigate\r\n"
+	"Sec-Fetch-Site: none\r\n"
+	"Priority: u=0, i\r\n"
+	"\r\n";
+
+/// @brief The request head handling before the resumable parser: the head is copied into an
+/// istringstream, the request line is read with operator>> and every field line with getline,
+/// trimmed and split into substrings that go into a multimap.
+struct LegacyRequest {
+	std::string method;
+	std::string url;
+	std::string version;
+	std::multimap<std::string, std::string> headers;
+	size_t contentLength;
+	std::vector<Cookie> cookies;
+
+	static std::string urlDecode(const std::string &str) {
+		std::string result;
+		for (size_t i = 0; i < str.length(); ++i) {
+			if (str[i] == '%' && i + 2 < str.length()) {
+				int high = hexValue(str[i + 1]);
+				int low = hexValue(str[i + 2]);
+				if (high != -1 && low != -1) {
+					result += static_cast<char>((high << 4) | low);
+					i += 2;
+				} else
+					result += str[i];
+			} else if (str[i] == '+')
+				result += ' ';
+			else
+				result += str[i];
+		}
+		return (result);
+	}
+
+	static int hexValue(char c) {
+		if ('0' <= c && c <= '9') return (c - '0');
+		if ('a' <= c && c <= 'f') return (c - 'a' + 10);
+		if ('A' <= c && c <= 'F') return (c - 'A' + 10);
+		return (-1);
+	}
+
+	const std::string &getHeader(const std::string &key, const std::string &defaultValue) const {
+		auto it = headers.find(key);
+		return (it != headers.end() ? it->second : defaultValue);
+	}
+
+	explicit LegacyRequest(std::string &buffer) : contentLength(0) {
+		std::istringstream stream(buffer);
+		stream >> method >> url >> version;
+		url = urlDecode(Utils::trim(url));
+		version = Utils::trim(version);
+		method = Utils::trim(method);
+		std::transform(method.begin(), method.end(), method.begin(), ::tolower);
+
+		std::string line;
+		bool firstLine = true;
+		while (std::getline(stream, line, '\n')) {
+			line = Utils::trim(line);
+			if (line.empty()) {
+				if (!firstLine)
+					break;
+				firstLine = false;
+				continue;
+			}
+			size_t colon = line.find(':');
+			if (colon == std::string::npos)
+				continue;
+			std::string key = Utils::trim(line.substr(0, colon));
+			std::string value = Utils::trim(line.substr(colon + 1));
+			if (key == "Host")
+				value = value.substr(0, value.find(':'));
+			headers.insert(std::make_pair(key, value));
+		}
+
+		if (getHeader("Content-Length", "") != "") {
+			try { contentLength = std::stoul(getHeader("Content-Length", "")); }
+			catch (...) { contentLength = 0; }
+		}
+		cookies = Cookie::createAllFromHeader(getHeader("Cookie", ""));
+	}
+};
+
+/// @brief A 12-field head turned into a Request, per request.
+static void benchHead() {
+	std::string buffer = g_head;
+
+	double legacy = bench_best_ns([&]() {
+		for (int i = 0; i < PARSER_BENCH_ITERATIONS; ++i) {
+			LegacyRequest request(buffer);
+			bench_keep(request);
+		}
+	});
+
+	RequestParser parser;
+	double current = bench_best_ns([&]() {
+		for (int i = 0; i < PARSER_BENCH_ITERATIONS; ++i) {
+			parser.reset();
+			if (parser.parse(buffer) != RequestParserStatus::Complete)
+				std::abort();
+			Request request(parser, buffer);
+			bench_keep(request);
+		}
+	});
+
+	bench_report("12-field head into a Request", legacy / PARSER_BENCH_ITERATIONS / 1000,
+		current / PARSER_BENCH_ITERATIONS / 1000, "us/request");
+}
+
+/// @brief Only finding the tokens, without building a Request from them.
+static void benchParseOnly() {
+	RequestParser parser;
+	double current = bench_best_ns([&]() {
+		for (int i = 0; i < PARSER_BENCH_ITERATIONS; ++i) {
+			parser.reset();
+			RequestParserStatus status = parser.parse(g_head);
+			bench_keep(status);
+		}
+	});
+
+	bench_print("12-field head, RequestParser::parse only", current / PARSER_BENCH_ITERATIONS / 1000, "us/request");
+}
+
+int main() {
+	std::cout << "parserBench: legacy istringstream parsing -> RequestParser, "
+		<< PARSER_BENCH_ITERATIONS << " iterations" << std::endl;
+	benchHead();
+	benchParseOnly();
+	return (0);
+}
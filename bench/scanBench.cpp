@@ -0,0 +1,135 @@
+#include "bench.hpp"
+#include "readBuffer.hpp"
+#include "byteScan.hpp"
+
+#include <string_view>
+#include <charconv>
+#include <string>
+
+#define SCAN_BENCH_SIZE (8 * 1024 * 1024)
+#define SCAN_BENCH_REPEATS 20
+#define SCAN_BENCH_HEAD_SIZE (16 * 1024)
+#define SCAN_BENCH_TRICKLE_SIZE 16
+#define SCAN_BENCH_UPLOAD_SIZE (64 * 1024 * 1024)
+#define SCAN_BENCH_UPLOAD_CHUNK_SIZE (8 * 1024)
+#define SCAN_BENCH_UPLOAD_READ_SIZE (64 * 1024)
+
+/// @brief Fill 8 MiB with `line` over and over, ending in `delimiter`.
+static std::string makeHaystack(std::string_view line, std::string_view delimiter) {
+	std::string data;
+	data.reserve(SCAN_BENCH_SIZE);
+	while (data.size() < SCAN_BENCH_SIZE - delimiter.size())
+		data += line;
+	data.resize(SCAN_BENCH_SIZE - delimiter.size());
+	data.append(delimiter);
+	return (data);
+}
+
+/// @brief Search 8 MiB for a delimiter found only at its very end.
+static void benchThroughput(const std::string &name, std::string_view haystack, std::string_view delimiter) {
+	double legacy = bench_best_ns([&]() {
+		for (int i = 0; i < SCAN_BENCH_REPEATS; ++i) {
+			size_t pos = haystack.find(delimiter);
+			bench_keep(pos);
+		}
+	});
+	double current = bench_best_ns([&]() {
+		for (int i = 0; i < SCAN_BENCH_REPEATS; ++i) {
+			size_t pos = ByteScan::find(haystack, delimiter);
+			bench_keep(pos);
+		}
+	});
+
+	double gigabytes = static_cast<double>(SCAN_BENCH_SIZE) * SCAN_BENCH_REPEATS / 1e9;
+	bench_report(name, gigabytes / (legacy / 1e9), gigabytes / (current / 1e9), "GB/s", true);
+}
+
+/// @brief A 16 KiB head arriving in 16 byte reads, searched for its end after every read.
+/// Before ReadBuffer::scan, every read searched the whole buffer again from its start.
+static void benchTrickle() {
+	std::string head;
+	while (head.size() < SCAN_BENCH_HEAD_SIZE - 4)
+		head += "X-Padding: " + std::string(50, 'p') + "\r\n";
+	head.resize(SCAN_BENCH_HEAD_SIZE - 4);
+	head += "\r\n\r\n";
+
+	double legacy = bench_best_ns([&]() {
+		ReadBuffer buffer;
+		for (size_t read = 0; read < head.size(); read += SCAN_BENCH_TRICKLE_SIZE) {
+			buffer.append(std::string_view(head).substr(read, SCAN_BENCH_TRICKLE_SIZE));
+			size_t pos = buffer.view().find("\r\n\r\n");
+			bench_keep(pos);
+		}
+	});
+	double current = bench_best_ns([&]() {
+		ReadBuffer buffer;
+		for (size_t read = 0; read < head.size(); read += SCAN_BENCH_TRICKLE_SIZE) {
+			buffer.append(std::string_view(head).substr(read, SCAN_BENCH_TRICKLE_SIZE));
+			size_t pos = buffer.scan("\r\n\r\n");
+			bench_keep(pos);
+		}
+	});
+
+	bench_report("16 KiB head in 16 byte reads", legacy / 1e6, current / 1e6, "ms");
+}
+
+/// @brief Decode a chunked upload from a buffer filled in 64 KiB reads, the way FDReader takes
+/// every complete chunk out after a read: find the end of the size line, then skip the data.
+template <typename FindSizeLine>
+static size_t decodeUpload(std::string_view upload, FindSizeLine findSizeLine) {
+	ReadBuffer buffer;
+	size_t decoded = 0;
+	for (size_t read = 0; read < upload.size(); read += SCAN_BENCH_UPLOAD_READ_SIZE) {
+		buffer.append(upload.substr(read, SCAN_BENCH_UPLOAD_READ_SIZE));
+		while (true) {
+			size_t lineEnd = findSizeLine(buffer);
+			if (lineEnd == std::string_view::npos)
+				break ;
+			size_t chunkSize = 0;
+			std::string_view line = buffer.view(lineEnd);
+			std::from_chars(line.data(), line.data() + line.size(), chunkSize, 16);
+			if (buffer.size() < lineEnd + 4 + chunkSize)
+				break ;
+			decoded += chunkSize;
+			buffer.consume(lineEnd + 4 + chunkSize);
+		}
+	}
+	return (decoded);
+}
+
+/// @brief A 64 MiB chunked upload in 8 KiB chunks with a chunk extension on every size line.
+static void benchChunkedUpload() {
+	std::string chunk(SCAN_BENCH_UPLOAD_CHUNK_SIZE, 'u');
+	std::string upload;
+	upload.reserve(SCAN_BENCH_UPLOAD_SIZE + SCAN_BENCH_UPLOAD_SIZE / 64);
+	while (upload.size() < SCAN_BENCH_UPLOAD_SIZE)
+		upload += "2000;name=upload\r\n" + chunk + "\r\n";
+	upload += "0\r\n\r\n";
+
+	double legacy = bench_best_ns([&]() {
+		size_t decoded = decodeUpload(upload, [](ReadBuffer &buffer) { return (buffer.view().find("\r\n")); });
+		bench_keep(decoded);
+	});
+	double current = bench_best_ns([&]() {
+		size_t decoded = decodeUpload(upload, [](ReadBuffer &buffer) { return (buffer.scan("\r\n")); });
+		bench_keep(decoded);
+	});
+
+	double gigabytes = upload.size() / 1e9;
+	bench_report("64 MiB chunked upload in 8 KiB chunks", gigabytes / (legacy / 1e9), gigabytes / (current / 1e9), "GB/s", true);
+}
+
+int main() {
+	std::cout << "scanBench: std::string_view::find -> ByteScan (" << ByteScan::getImplementationName() << ")" << std::endl;
+	// Without a \r before the end, std::string_view::find runs at memchr speed
+	std::string sparse = makeHaystack("X-Forwarded-For: 192.168.100.23, 10.0.0.1;", "\r\n\r\n");
+	benchThroughput("8 MiB without \\r for \\r\\n", sparse, "\r\n");
+	benchThroughput("8 MiB without \\r for \\r\\n\\r\\n", sparse, "\r\n\r\n");
+
+	// The end of a head, behind a \r\n every 42 bytes
+	std::string lines = makeHaystack("X-Forwarded-For: 192.168.100.23, 10.0.0.1\r\n", "\r\n\r\n");
+	benchThroughput("8 MiB of header lines for \\r\\n\\r\\n", lines, "\r\n\r\n");
+	benchTrickle();
+	benchChunkedUpload();
+	return (0);
+}
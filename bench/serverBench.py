@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""Requests per second over sequential connection-per-request GETs, with each io engine."""
+
+import os
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+WEBSERV = os.environ.get("WEBSERV", os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "webserv"))
+REQUESTS = int(os.environ.get("REQUESTS", "5000"))
+ROUNDS = 5
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def fetch(port):
+    """One GET on its own connection, read until the server closes it."""
+    with socket.create_connection(("127.0.0.1", port), timeout=5) as sock:
+        sock.sendall(b"GET /page.html HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n")
+        response = b""
+        while True:
+            data = sock.recv(65536)
+            if not data:
+                break
+            response += data
+    if not response.startswith(b"HTTP/1.1 200"):
+        raise RuntimeError(f"unexpected response: {response[:64]!r}")
+
+
+def start_server(root, engine):
+    """Start webserv on a free port with `engine`, returns the process and the port."""
+    port = free_port()
+    config = os.path.join(root, f"{engine}.conf")
+    with open(config, "w") as f:
+        f.write(f"""http {{
+    io_engine {engine};
+
+    server {{
+        listen {port} default;
+        server_name localhost;
+
+        location / {{
+            alias {root}/www;
+            allowed_methods GET;
+        }}
+    }}
+}}
+""")
+
+    # Every request gets a session, keep them out of the sessions directory of the tree
+    server = subprocess.Popen([WEBSERV, config], cwd=root, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    for _ in range(50):
+        try:
+            socket.create_connection(("127.0.0.1", port), timeout=1).close()
+            break
+        except OSError:
+            time.sleep(0.1)
+    return server, port
+
+
+def measure(port):
+    """Requests per second of REQUESTS sequential GETs."""
+    start = time.perf_counter()
+    for _ in range(REQUESTS):
+        fetch(port)
+    return REQUESTS / (time.perf_counter() - start)
+
+
+def main():
+    with tempfile.TemporaryDirectory() as root:
+        os.mkdir(os.path.join(root, "www"))
+        with open(os.path.join(root, "www", "page.html"), "w") as f:
+            f.write("<html>" + "hello bench " * 40 + "</html>")
+
+        print(f"serverBench: {REQUESTS} sequential connection-per-request GETs, best of {ROUNDS} alternating rounds")
+        servers = [start_server(root, "epoll"), start_server(root, "io_uring")]
+        try:
+            # Alternating keeps a machine that speeds up or slows down during the run from favouring either engine
+            best = [0, 0]
+            for _ in range(ROUNDS):
+                for index, (_, port) in enumerate(servers):
+                    best[index] = max(best[index], measure(port))
+        finally:
+            for server, _ in servers:
+                server.send_signal(signal.SIGINT)
+                server.wait(timeout=10)
+
+        epoll, uring = best
+        print(f"{'epoll -> io_uring':<48}{epoll:12.0f} -> {uring:10.0f} req/s  ({uring / epoll:.2f}x)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,86 @@
+#include "bench.hpp"
+#include "timer.hpp"
+
+#include <functional>
+#include <chrono>
+#include <vector>
+#include <set>
+
+/// @brief The Timer before the timing wheel: events ordered by deadline in a multiset,
+/// deleted by a linear search for their ID.
+class LegacyTimer {
+private:
+	struct Event {
+		std::chrono::steady_clock::duration interval;
+		std::chrono::steady_clock::time_point time;
+		std::function<void()> callback;
+		int id;
+
+		bool operator<(const Event &other) const { return time < other.time; }
+	};
+
+	std::multiset<Event> _events;
+	int _nextId = 1;
+
+public:
+	int addEvent(std::chrono::steady_clock::duration delay, std::function<void()> callback, bool isRecurring = false) {
+		std::chrono::steady_clock::duration interval = isRecurring ? delay : std::chrono::steady_clock::duration::max();
+		auto it = _events.insert(Event{interval, std::chrono::steady_clock::now() + delay, callback, _nextId++});
+		return (it->id);
+	}
+
+	int deleteEvent(int eventId) {
+		for (auto it = _events.begin(); it != _events.end(); ++it) {
+			if (it->id == eventId) {
+				_events.erase(it);
+				return (0);
+			}
+		}
+		return (-1);
+	}
+};
+
+/// @brief Add `count` events with spread out deadlines, then delete them newest first, the
+/// order connections that are all answered before their timeout cancel them in the worst case.
+template <typename TimerType>
+static double addAndDelete(int count) {
+	return (bench_best_ns([count]() {
+		TimerType timer;
+		std::vector<int> ids;
+		ids.reserve(count);
+		for (int i = 0; i < count; ++i)
+			ids.push_back(timer.addEvent(std::chrono::milliseconds(1000 + i % 60000), []() {}));
+		for (int i = count - 1; i >= 0; --i)
+			timer.deleteEvent(ids[i]);
+		bench_keep(timer);
+	}));
+}
+
+/// @brief Keep a constant amount of events and push one back, the way a keep-alive
+/// connection renews its timeout on every request.
+template <typename TimerType>
+static double renew(int count, int renewals) {
+	return (bench_best_ns([count, renewals]() {
+		TimerType timer;
+		std::vector<int> ids;
+		for (int i = 0; i < count; ++i)
+			ids.push_back(timer.addEvent(std::chrono::milliseconds(1000 + i % 60000), []() {}));
+		for (int i = 0; i < renewals; ++i) {
+			int &id = ids[(i * 7919) % count];
+			timer.deleteEvent(id);
+			id = timer.addEvent(std::chrono::milliseconds(5000), []() {});
+		}
+		bench_keep(timer);
+	}));
+}
+
+int main() {
+	std::cout << "timerBench: multiset Timer -> timing wheel" << std::endl;
+	for (int count : {1000, 20000}) {
+		bench_report("add + reverse delete, " + std::to_string(count) + " events",
+			addAndDelete<LegacyTimer>(count) / 1e6, addAndDelete<Timer>(count) / 1e6, "ms");
+	}
+	bench_report("20k renewals among 10k events",
+		renew<LegacyTimer>(10000, 20000) / 1e6, renew<Timer>(10000, 20000) / 1e6, "ms");
+	return (0);
+}
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include <ctime>
 
 namespace Utils {
     std::string trim(const std::string& str);
@@ -11,4 +12,7 @@ namespace Utils {
     std::string getFileExtension(const std::string& path);
     std::string intToString(int value);
     std::string toLower(const std::string& str);
+    const char *getMimeType(const std::string& path);
+    std::string formatHttpDate(std::time_t time);
+    bool parseHttpDate(const std::string& value, std::time_t &time);
 }
@@ -1,8 +1,14 @@
+#pragma once
+
 #include "fd.hpp"
 
+#include <initializer_list>
+#include <string_view>
 #include <functional>
+#include <algorithm>
 
 # define DEFAULT_CHUNK_SIZE 1024 * 8
+# define BODY_WRITER_MAX_PARTS 3
 
 template <typename From, typename To>
 class BodyWriter {
@@ -10,93 +16,232 @@ class BodyWriter {
     static_assert(std::is_base_of<FDWriter, To>::value, "To must inherit from WritableFD");
 
 private:
-    std::string _failedBuffer;
+    /// @brief Bytes queued or refused by the peer, sent from `_pendingOffset` on, ahead of anything else.
+    std::string _pending;
+    size_t _pendingOffset;
+
+    /// @brief What is left of a chunk from a reader that the peer took only part of. Its data stays at
+    /// the front of the reader's buffer and is consumed as it goes out, the framing is kept by offset.
+    From *_chunkSource;
+    char _chunkHeader[HTTP_CHUNK_HEADER_SIZE];
+    size_t _chunkHeaderOffset;
+    size_t _chunkHeaderLength;
+    size_t _chunkDataLeft;
+    size_t _chunkTrailerOffset;
+
+    bool _isStalled;
+
+    static constexpr std::string_view _chunkTrailer = "\r\n";
+    static constexpr std::string_view _lastChunk = "0\r\n\r\n";
+    static constexpr std::string_view _chunkTrailerAndLastChunk = "\r\n0\r\n\r\n";
+
+    bool _hasChunkInFlight() const {
+        return (_chunkHeaderOffset < _chunkHeaderLength || _chunkDataLeft > 0 || _chunkTrailerOffset < _chunkTrailer.size());
+    }
+
+    void _clearChunk() {
+        _chunkSource = nullptr;
+        _chunkHeaderOffset = _chunkHeaderLength = 0;
+        _chunkDataLeft = 0;
+        _chunkTrailerOffset = _chunkTrailer.size();
+    }
 
-    ssize_t _safeWriteAsHTTPChunk(To &to, const std::string &data) {
-        std::stringstream chunkStream;
+    /// @brief The data left of the chunk in flight, as far as the reader still has it.
+    std::string_view _chunkData() {
+        if (_chunkDataLeft == 0)
+            return (std::string_view());
+        std::string_view data = _chunkSource->peekReadBuffer(_chunkDataLeft);
+        // Only if the reader was cleared under it, which ends the response anyway
+        _chunkDataLeft = data.size();
+        return (data);
+    }
 
-        chunkStream << std::hex << data.size() << "\r\n";
-        chunkStream << data << "\r\n";
+    /// @brief Copy what is left of the chunk in flight to the pending bytes, so new bytes can queue behind it.
+    void _materializeChunk() {
+        _pending.append(_chunkHeader + _chunkHeaderOffset, _chunkHeaderLength - _chunkHeaderOffset);
+        std::string_view data = _chunkData();
+        _pending.append(data);
+        if (!data.empty())
+            _chunkSource->consumeReadBuffer(data.size());
+        _pending.append(_chunkTrailer.substr(_chunkTrailerOffset));
+        _clearChunk();
+    }
 
-        return (_safeWrite(to, chunkStream.str()));
+    void _appendPending(std::string_view data) {
+        if (_hasChunkInFlight())
+            _materializeChunk();
+        if (_pendingOffset > 0) {
+            _pending.erase(0, _pendingOffset);
+            _pendingOffset = 0;
+        }
+        _pending.append(data);
     }
 
-    ssize_t _safeWrite(To &to, const std::string &data) {
-        if (data.empty())
+    /// @brief Write the pending bytes, the rest of the chunk in flight and then `parts`, with a single writev.
+    /// @param keepsUnsent Whether the part of `parts` the peer didn't take is queued, or left to the caller.
+    /// @param hasMore Whether more data follows right away, see FDWriter::writeAsVector.
+    /// @param partsWritten Set to the amount of bytes of `parts` that went out.
+    /// @return The amount of bytes written in total, or -1 on error.
+    ssize_t _write(To &to, std::initializer_list<std::string_view> parts, bool keepsUnsent, bool hasMore, size_t &partsWritten) {
+        std::string_view pending = std::string_view(_pending).substr(std::min(_pendingOffset, _pending.size()));
+        std::string_view header(_chunkHeader + _chunkHeaderOffset, _chunkHeaderLength - _chunkHeaderOffset);
+        std::string_view data = _chunkData();
+        std::string_view trailer = _chunkTrailer.substr(_chunkTrailerOffset);
+
+        iovec vectors[4 + BODY_WRITER_MAX_PARTS];
+        int count = 0;
+        size_t total = 0;
+        for (std::string_view buffer : {pending, header, data, trailer}) {
+            if (buffer.empty())
+                continue ;
+            vectors[count++] = iovec{const_cast<char *>(buffer.data()), buffer.size()};
+            total += buffer.size();
+        }
+        for (std::string_view part : parts) {
+            if (part.empty() || count >= static_cast<int>(sizeof(vectors) / sizeof(vectors[0])))
+                continue ;
+            vectors[count++] = iovec{const_cast<char *>(part.data()), part.size()};
+            total += part.size();
+        }
+
+        partsWritten = 0;
+        // A partial write that kept nothing back leaves nothing to wait for either
+        if (count == 0) {
+            _isStalled = false;
             return (0);
+        }
 
-        ssize_t bytesWritten = to.writeAsString(data);
-        if (bytesWritten < 0) {
-            _failedBuffer = data;
-            return -1;
+        ssize_t bytesWritten = to.writeAsVector(vectors, count, hasMore);
+        size_t left = bytesWritten > 0 ? static_cast<size_t>(bytesWritten) : 0;
+        amountOfBytesWritten += static_cast<ssize_t>(left);
+        _isStalled = left < total;
+
+        // Hand the written bytes out in the order they were sent
+        size_t step = std::min(left, pending.size());
+        _pendingOffset += step;
+        left -= step;
+        if (_pendingOffset >= _pending.size()) {
+            _pending.clear();
+            _pendingOffset = 0;
         }
 
-        if (static_cast<size_t>(bytesWritten) < data.size()) {
-            _failedBuffer = data.substr(bytesWritten) + _failedBuffer;
-			amountOfBytesWritten += bytesWritten;
-            return (bytesWritten);
+        step = std::min(left, header.size());
+        _chunkHeaderOffset += step;
+        left -= step;
+
+        step = std::min(left, data.size());
+        if (step > 0)
+            _chunkSource->consumeReadBuffer(step);
+        _chunkDataLeft -= step;
+        left -= step;
+
+        step = std::min(left, trailer.size());
+        _chunkTrailerOffset += step;
+        left -= step;
+
+        if (!_hasChunkInFlight())
+            _clearChunk();
+
+        partsWritten = left;
+        if (keepsUnsent) {
+            for (std::string_view part : parts) {
+                if (left >= part.size()) {
+                    left -= part.size();
+                    continue ;
+                }
+                _appendPending(part.substr(left));
+                left = 0;
+            }
         }
 
-        _failedBuffer.clear();
-		amountOfBytesWritten += bytesWritten;
-        return (bytesWritten);
+        return (bytesWritten < 0 ? -1 : bytesWritten);
+    }
+
+    ssize_t _write(To &to, std::initializer_list<std::string_view> parts, bool hasMore = false) {
+        size_t partsWritten;
+        return (_write(to, parts, true, hasMore, partsWritten));
     }
 
 public:
-    BodyWriter() = default;
+    BodyWriter() : _pending(), _pendingOffset(0), _chunkSource(nullptr), _chunkHeader(), _chunkHeaderOffset(0),
+        _chunkHeaderLength(0), _chunkDataLeft(0), _chunkTrailerOffset(_chunkTrailer.size()), _isStalled(false), amountOfBytesWritten(0) {}
     BodyWriter(const BodyWriter &other) = default;
     BodyWriter& operator=(const BodyWriter &other) = default;
     ~BodyWriter() = default;
 
 	ssize_t amountOfBytesWritten;
 
+    /// @brief Queue bytes without writing them, they are sent along with whatever is sent next.
+    /// @details Lets a response hand over its head and have it go out in the same write as the first body bytes.
+    void queue(std::string_view data) {
+        _appendPending(data);
+    }
+
+    /// @brief Send the front of the reader's buffer as one chunk, framed without copying it.
+    /// @details The chunk is consumed from the reader as the peer takes it, not before.
     ssize_t sendBodyAsHTTPChunk(From &from, To &to) {
-        if (!_failedBuffer.empty())
-            return (_safeWrite(to, _failedBuffer));
-        
-        size_t bytesToSend = std::min(from.getReadBufferSize(), static_cast<size_t>(DEFAULT_CHUNK_SIZE));
-        if (bytesToSend == 0)
-            return (0);
+        if (_isStalled)
+            return (tick(to));
 
-        return (_safeWriteAsHTTPChunk(to, from.extractChunkFromReadBuffer(bytesToSend)));
+        std::string_view data = from.peekReadBuffer(DEFAULT_CHUNK_SIZE);
+        if (data.empty())
+            return (tick(to));
+
+        _chunkSource = &from;
+        _chunkHeaderOffset = 0;
+        _chunkHeaderLength = FDWriter::formatChunkHeader(_chunkHeader, data.size());
+        _chunkDataLeft = data.size();
+        _chunkTrailerOffset = 0;
+        return (tick(to));
     }
 
-    ssize_t sendBodyAsString(From &from, To &to) {
-        if (!_failedBuffer.empty())
-            return (_safeWrite(to, _failedBuffer));
+    ssize_t sendBodyAsString(From &from, To &to, size_t maxSize = DEFAULT_CHUNK_SIZE) {
+        if (_isStalled)
+            return (tick(to));
 
-        size_t bytesToSend = std::min(from.getReadBufferSize(), static_cast<size_t>(DEFAULT_CHUNK_SIZE));
-        if (bytesToSend == 0)
-            return (0);
+        // Write straight out of the reader's buffer and only consume what the peer accepted
+        std::string_view data = from.peekReadBuffer(std::min<size_t>(maxSize, DEFAULT_CHUNK_SIZE));
+        if (data.empty())
+            return (tick(to));
+
+        size_t partsWritten;
+        ssize_t bytesWritten = _write(to, {data}, false, false, partsWritten);
+        if (bytesWritten <= 0)
+            return (bytesWritten < 0 ? -1 : 0);
 
-        return (_safeWrite(to, from.extractChunkFromReadBuffer(bytesToSend)));
+        from.consumeReadBuffer(partsWritten);
+        return (bytesWritten);
     }
 
-    ssize_t sendBodyAsHTTPChunk(std::string &data, To &to) {
-        if (!_failedBuffer.empty()) {
-            _failedBuffer += data;
-            return (_safeWrite(to, _failedBuffer));
-        }
+    /// @brief Send data as one chunk, optionally followed by the last chunk ending the body.
+    ssize_t sendBodyAsHTTPChunk(std::string_view data, To &to, bool isLastChunk = false) {
+        if (data.empty())
+            return (_write(to, {isLastChunk ? _lastChunk : std::string_view()}));
 
-        return (_safeWriteAsHTTPChunk(to, data));
+        char header[HTTP_CHUNK_HEADER_SIZE];
+        std::string_view headerView(header, FDWriter::formatChunkHeader(header, data.size()));
+        return (_write(to, {headerView, data, isLastChunk ? _chunkTrailerAndLastChunk : _chunkTrailer}));
     }
 
-    ssize_t sendBodyAsString(std::string &data, To &to) {
-        if (!_failedBuffer.empty()) {
-            _failedBuffer += data;
-            return (_safeWrite(to, _failedBuffer));
-        }
+    ssize_t sendBodyAsString(std::string_view data, To &to, bool hasMore = false) {
+        return (_write(to, {data}, hasMore));
+    }
+
+    ssize_t tick(To &to, bool hasMore = false) {
+        return (_write(to, {}, hasMore));
+    }
 
-        return (_safeWrite(to, data));
+    /// @brief Whether the last write left bytes behind, nothing new should be produced until tick() sent them.
+    bool isStalled() const {
+        return _isStalled;
     }
 
-    ssize_t tick(To &to) {
-        if (!_failedBuffer.empty())
-            return (_safeWrite(to, _failedBuffer));
-        return (0);
+    /// @brief Amount of queued bytes the peer didn't take yet.
+    size_t getPendingSize() const {
+        return (_pending.size() - std::min(_pendingOffset, _pending.size()));
     }
 
     bool isEmpty() const {
-        return _failedBuffer.empty();
+        return (_pendingOffset >= _pending.size() && !_hasChunkInFlight());
     }
 };
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <sys/types.h>
+#include <string>
+#include <vector>
+
+/// @brief Ranges beyond this in a single request make the whole header be ignored, they are mostly used to amplify work.
+#define BYTE_RANGE_MAX_RANGES 16
+
+enum class RangeRequest {
+    /// @brief No usable Range header, the full representation is sent.
+    Ignored,
+    Satisfiable,
+    /// @brief Every range starts past the end of the file, answered with a 416.
+    Unsatisfiable,
+};
+
+/// @brief An inclusive range of bytes of a file, as in "Content-Range: bytes first-last/size".
+struct ByteRange {
+    off_t first;
+    off_t last;
+
+    inline off_t length() const { return last - first + 1; }
+    std::string toContentRange(off_t size) const;
+
+    static RangeRequest parse(const std::string &value, off_t size, std::vector<ByteRange> &ranges);
+};
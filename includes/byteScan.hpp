@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+
+/// @brief Vectorized search for the delimiters of HTTP framing ("\r\n", "\r\n\r\n").
+/// @details Compares a whole vector of positions at a time with AVX2 or SSE2, picked once at runtime
+/// from what the CPU supports. Other CPUs use std::string_view::find.
+namespace ByteScan {
+    size_t find(std::string_view haystack, std::string_view needle, size_t from = 0);
+    const char *getImplementationName();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "fd.hpp"
+
+#include <sys/types.h>
+#include <string>
+#include <vector>
+
+#define CGI_POOL_MAX_MESSAGE_SIZE (1024 * 128) // script, directory and environment of one request
+
+class Server;
+
+/// @brief CGI processes forked ahead of the requests that run them, so fork() is off the request path.
+/// @details The processes come from a zygote, forked once when the pool is configured, before the
+/// server grew its caches and connections, so the server itself never forks on the event loop. On
+/// request the zygote creates one with clone(CLONE_PARENT), a child of the server rather than of the
+/// zygote, and sends back its pid and the server's end of its socket pair. Every process waits on
+/// that socket. A request hands one the script, its directory and environment, along with the two
+/// pipe ends it talks through (passed as SCM_RIGHTS); the process then changes into the directory
+/// and executes the script, becoming the CGI process of the response. Each process serves exactly
+/// one request, a timer asks the zygote for replacements at the configured spawn rate until max idle
+/// processes are waiting again. Requests that find the pool empty spawn their process on their own,
+/// as without the pool.
+class CGIPool {
+private:
+    struct Worker {
+        pid_t pid;
+        int controlFd;
+    };
+
+    Server &_server;
+    std::vector<Worker> _idle;
+    size_t _maxIdle;
+    size_t _pendingSpawns;
+    int _timerId;
+    pid_t _zygotePid;
+    ReadableFD _zygoteFd;
+
+    bool _startZygote();
+    void _stopZygote();
+    bool _requestSpawn();
+    bool _receiveWorker(int flags);
+    static void _retire(const Worker &worker);
+    [[noreturn]] static void _runZygote(int controlFd);
+    [[noreturn]] static void _runWorker(int controlFd);
+
+public:
+    CGIPool(Server &server);
+    CGIPool(const CGIPool &other) = delete;
+    CGIPool &operator=(const CGIPool &other) = delete;
+    ~CGIPool() = default;
+
+    void configure(size_t maxIdle, size_t spawnRate);
+    pid_t launch(const std::string &directory, const std::string &program,
+        const std::vector<std::string> &environment, int stdinFd, int stdoutFd);
+    void clear();
+
+    inline bool isEnabled() const { return _maxIdle != 0; }
+};
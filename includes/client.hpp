@@ -1,11 +1,15 @@
 #pragma once
 
 #include "response.hpp"
+#include "requestParser.hpp"
 #include "request.hpp"
 #include "server.hpp"
 #include "print.hpp"
 #include "fd.hpp"
 
+#include <chrono>
+#include <deque>
+
 // class CGIClient;
 class Server;
 class Response;
@@ -26,6 +30,15 @@ private:
     bool _chunkedRequestBodyRead;
     bool _isFirstRequest;
 
+    /// @brief Requests that arrived behind the current one on the connection, answered in order.
+    std::deque<Request> _pipeline;
+    RequestParser _parser;
+    bool _isReadingPaused;
+
+    int _timeoutEventId;
+    ClientHTTPState _timeoutState;
+    std::chrono::steady_clock::time_point _stateChangeTime;
+
     std::string _clientIP;
     std::string _clientPort;
 
@@ -40,6 +53,20 @@ private:
     Response *_createReturnRuleResponse(const ReturnRule &returnRule);
     Response *_createCGIResponse(SocketFD &fd, const ServerConfig &config, const LocationRule &route);
     Response *_createResponseFromRequest(SocketFD &fd, Request &request);
+    Response *_createNotModifiedResponse(const LocationRule &route, const OpenFile &file, ContentEncoding encoding, bool isVarying);
+
+    void _setValidatorHeaders(Response &response, const OpenFile &file, ContentEncoding encoding);
+    void _setCachingHeaders(Response &response, const LocationRule &route, bool isVarying);
+
+    RequestParserStatus _parseRequestHead(SocketFD &fd, Request &into);
+    void _beginRequest(SocketFD &fd);
+    void _queuePipelinedRequests(SocketFD &fd);
+    bool _isPipelineBlocked(const SocketFD &fd) const;
+
+    void _setState(ClientHTTPState state, SocketFD &fd);
+    std::chrono::steady_clock::duration _getStateTimeout() const;
+    void _cancelTimeout();
+    void _handleTimeout(SocketFD &fd);
 
 public:
     const LocationRule *route;
@@ -57,12 +84,15 @@ public:
     void switchResponseToErrorResponse(HttpStatusCode statusCode, SocketFD &fd);
 
     bool isFullRequestBodyReceived(SocketFD &fd) const;
-    bool isTimedOut(const HTTPRule &httpRule, const SocketFD &fd) const;
-    bool shouldBeClosed(const HTTPRule &httpRule, const SocketFD &fd) const;
+    void armTimeout(SocketFD &fd);
     bool setEpollWriteNotification(SocketFD &fd);
     bool unsetEpollWriteNotification(SocketFD &fd);
+    bool isReadingSocketDirectly() const;
     ClientHTTPState getState() const;
 
+    /// @brief Leave EPOLLIN out of the socket's events from the next notification change on, or put it back.
+    inline void setReadingPaused(bool isPaused) { _isReadingPaused = isPaused; }
+
     inline std::string &getClientIP() { return _clientIP; }
     inline std::string &getClientPort() { return _clientPort; }
     inline Server &getServer() { return _server; }
@@ -82,6 +82,21 @@ enum Key {
     CLIENT_BODY_TIMEOUT = 1 << 19,
     CLIENT_KEEPALIVE_READ_TIMEOUT = 1 << 20,
     HTTP = 1 << 21,
+    WORKER_PROCESSES = 1 << 22,
+    WORKER_CPU_AFFINITY = 1 << 23,
+    IO_ENGINE = 1 << 24,
+    TIMER_RESOLUTION = 1 << 25,
+    OPEN_FILE_CACHE = 1 << 26,
+    MEMORY_CACHE = 1 << 27,
+    GZIP = 1 << 28,
+    GZIP_TYPES = 1 << 29,
+    GZIP_MIN_LENGTH = 1 << 30,
+    GZIP_COMP_LEVEL = 1LL << 31,
+    GZIP_STATIC = 1LL << 32,
+    CACHE_CONTROL = 1LL << 33,
+    PIPELINE_DEPTH = 1LL << 34,
+    FASTCGI_PASS = 1LL << 35,
+    CGI_PREFORK = 1LL << 36,
 };
 
 enum ArgumentType {
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+/// @brief Lets clients store files but makes them revalidate every use, which is cheap with ETag/Last-Modified.
+#define CACHE_CONTROL_DEFAULT "no-cache"
+
+class CacheControlRule : public BaseRule {
+private:
+    bool _isSet;
+    bool _isEnabled;
+    std::string _value;
+
+public:
+    constexpr static Key getKey() { return Key::CACHE_CONTROL; }
+    constexpr static const char* getRuleName() { return "cache_control"; }
+    constexpr static const char* getRuleFormat() { return "cache_control <directive> [<directive> ...] | off"; }
+
+    CacheControlRule(const CacheControlRule &other) = default;
+    CacheControlRule& operator=(const CacheControlRule &other) = default;
+    ~CacheControlRule() = default;
+
+    CacheControlRule();
+    CacheControlRule(Rule *rule);
+
+    bool isSet() const;
+    bool isEnabled() const;
+    const std::string &getValue() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const CacheControlRule &rule);
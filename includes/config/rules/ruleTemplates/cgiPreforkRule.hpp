@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define DEFAULT_CGI_PREFORK_MAX_IDLE 0
+#define DEFAULT_CGI_PREFORK_SPAWN_RATE 16
+
+class CgiPreforkRule : public BaseRule {
+private:
+    bool _isSet = false;
+    int _maxIdle;
+    int _spawnRate;
+
+public:
+    constexpr static Key getKey() { return Key::CGI_PREFORK; }
+    constexpr static const char* getRuleName() { return "cgi_prefork"; }
+    constexpr static const char* getRuleFormat() { return "cgi_prefork <max_idle|off> [spawn_rate]"; }
+
+    CgiPreforkRule(const CgiPreforkRule &other) = default;
+    CgiPreforkRule& operator=(const CgiPreforkRule &other) = default;
+    ~CgiPreforkRule() = default;
+
+    CgiPreforkRule();
+    CgiPreforkRule(Rule *rule);
+
+    bool isSet() const;
+    size_t getMaxIdle() const;
+    size_t getSpawnRate() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const CgiPreforkRule &rule);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+class FastCGIPassRule : public BaseRule {
+private:
+    std::string _address;
+    std::string _socketPath;
+    std::string _host;
+    std::string _port;
+
+public:
+    constexpr static Key getKey() { return Key::FASTCGI_PASS; }
+    constexpr static const char* getRuleName() { return "fastcgi_pass"; }
+    constexpr static const char* getRuleFormat() { return "fastcgi_pass <unix:path|host:port>"; }
+
+    FastCGIPassRule(const FastCGIPassRule &other) = default;
+    FastCGIPassRule& operator=(const FastCGIPassRule &other) = default;
+    ~FastCGIPassRule() = default;
+
+    FastCGIPassRule();
+    FastCGIPassRule(Rule *rule);
+
+    bool isSet() const;
+    bool isUnixSocket() const;
+    const std::string &getAddress() const;
+    const std::string &getSocketPath() const;
+    const std::string &getHost() const;
+    const std::string &getPort() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const FastCGIPassRule &rule);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define GZIP_COMP_LEVEL_DEFAULT 1
+
+class GzipCompLevelRule : public BaseRule {
+private:
+    bool _isSet;
+    int _level;
+
+public:
+    constexpr static Key getKey() { return Key::GZIP_COMP_LEVEL; }
+    constexpr static const char* getRuleName() { return "gzip_comp_level"; }
+    constexpr static const char* getRuleFormat() { return "gzip_comp_level <1-9>"; }
+
+    GzipCompLevelRule(const GzipCompLevelRule &other) = default;
+    GzipCompLevelRule& operator=(const GzipCompLevelRule &other) = default;
+    ~GzipCompLevelRule() = default;
+
+    GzipCompLevelRule();
+    GzipCompLevelRule(Rule *rule);
+
+    bool isSet() const;
+    int getLevel() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const GzipCompLevelRule &rule);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define GZIP_MIN_LENGTH_DEFAULT 20
+
+class GzipMinLengthRule : public BaseRule {
+private:
+    bool _isSet;
+    Size _minLength;
+
+public:
+    constexpr static Key getKey() { return Key::GZIP_MIN_LENGTH; }
+    constexpr static const char* getRuleName() { return "gzip_min_length"; }
+    constexpr static const char* getRuleFormat() { return "gzip_min_length <size>"; }
+
+    GzipMinLengthRule(const GzipMinLengthRule &other) = default;
+    GzipMinLengthRule& operator=(const GzipMinLengthRule &other) = default;
+    ~GzipMinLengthRule() = default;
+
+    GzipMinLengthRule();
+    GzipMinLengthRule(Rule *rule);
+
+    bool isSet() const;
+    size_t getMinLength() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const GzipMinLengthRule &rule);
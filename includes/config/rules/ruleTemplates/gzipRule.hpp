@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define GZIP_DEFAULT false
+
+class GzipRule : public BaseRule {
+private:
+    bool _isSet;
+    bool _isEnabled;
+
+public:
+    constexpr static Key getKey() { return Key::GZIP; }
+    constexpr static const char* getRuleName() { return "gzip"; }
+    constexpr static const char* getRuleFormat() { return "gzip <on|off>"; }
+
+    GzipRule(const GzipRule &other) = default;
+    GzipRule& operator=(const GzipRule &other) = default;
+    ~GzipRule() = default;
+
+    GzipRule();
+    GzipRule(Rule *rule);
+
+    bool isSet() const;
+    bool isEnabled() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const GzipRule &rule);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define GZIP_STATIC_DEFAULT false
+
+class GzipStaticRule : public BaseRule {
+private:
+    bool _isSet;
+    bool _isEnabled;
+
+public:
+    constexpr static Key getKey() { return Key::GZIP_STATIC; }
+    constexpr static const char* getRuleName() { return "gzip_static"; }
+    constexpr static const char* getRuleFormat() { return "gzip_static <on|off>"; }
+
+    GzipStaticRule(const GzipStaticRule &other) = default;
+    GzipStaticRule& operator=(const GzipStaticRule &other) = default;
+    ~GzipStaticRule() = default;
+
+    GzipStaticRule();
+    GzipStaticRule(Rule *rule);
+
+    bool isSet() const;
+    bool isEnabled() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const GzipStaticRule &rule);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <string_view>
+#include <ostream>
+#include <vector>
+#include <string>
+
+#define GZIP_TYPES_DEFAULT {"text/html", "text/css", "text/plain", "text/javascript", "application/javascript", \
+    "application/json", "application/xml", "image/svg+xml"}
+
+class GzipTypesRule : public BaseRule {
+private:
+    bool _isSet;
+    std::vector<std::string> _types;
+
+public:
+    constexpr static Key getKey() { return Key::GZIP_TYPES; }
+    constexpr static const char* getRuleName() { return "gzip_types"; }
+    constexpr static const char* getRuleFormat() { return "gzip_types <mime_type|*> [<mime_type> ...]"; }
+
+    GzipTypesRule(const GzipTypesRule &other) = default;
+    GzipTypesRule& operator=(const GzipTypesRule &other) = default;
+    ~GzipTypesRule() = default;
+
+    GzipTypesRule();
+    GzipTypesRule(Rule *rule);
+
+    bool isSet() const;
+    bool matches(std::string_view contentType) const;
+    const std::vector<std::string>& getTypes() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const GzipTypesRule &rule);
@@ -1,6 +1,14 @@
 #pragma once
 
 #include "keepaliveReadTimeoutRule.hpp"
+#include "workerCpuAffinityRule.hpp"
+#include "workerProcessesRule.hpp"
+#include "timerResolutionRule.hpp"
+#include "openFileCacheRule.hpp"
+#include "memoryCacheRule.hpp"
+#include "pipelineDepthRule.hpp"
+#include "cgiPreforkRule.hpp"
+#include "ioEngineRule.hpp"
 #include "../../types/customTypes.hpp"
 #include "serverconfigRule.hpp"
 #include "../../config.hpp"
@@ -15,6 +23,14 @@ class HTTPRule : public BaseRule {
 public:
 	ClientHeaderTimeoutRule clientHeaderTimeout;
 	ClientKeepAliveReadTimeoutRule clientKeepAliveReadTimeout;
+	WorkerProcessesRule workerProcesses;
+	WorkerCpuAffinityRule workerCpuAffinity;
+	IOEngineRule ioEngine;
+	TimerResolutionRule timerResolution;
+	OpenFileCacheRule openFileCache;
+	MemoryCacheRule memoryCache;
+	PipelineDepthRule pipelineDepth;
+	CgiPreforkRule cgiPrefork;
     std::vector<ServerConfig> servers;
 
     constexpr static Key getKey() { return Key::HTTP; }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+/// @brief Engine behind the event loop's descriptor bookkeeping.
+/// @details IOUring keeps epoll for readiness and socket I/O, and moves accepts,
+/// epoll_ctl calls and closes onto an io_uring. Reads and writes never go through the ring.
+enum class IOEngine {
+    Epoll,
+    IOUring,
+};
+
+#define IO_ENGINE_DEFAULT IOEngine::Epoll
+
+class IOEngineRule : public BaseRule {
+private:
+    bool _isSet;
+    IOEngine _engine;
+
+public:
+    constexpr static Key getKey() { return Key::IO_ENGINE; }
+    constexpr static const char* getRuleName() { return "io_engine"; }
+    constexpr static const char* getRuleFormat() { return "io_engine <epoll|io_uring>"; }
+
+    IOEngineRule(const IOEngineRule &other) = default;
+    IOEngineRule& operator=(const IOEngineRule &other) = default;
+    ~IOEngineRule() = default;
+
+    IOEngineRule();
+    IOEngineRule(Rule *rule);
+
+    bool isSet() const;
+    IOEngine getEngine() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const IOEngineRule &rule);
@@ -17,6 +17,13 @@
 #include "cgiRule.hpp"
 #include "cgiTimeoutRule.hpp"
 #include "cgiExtensionRule.hpp"
+#include "fastcgiPassRule.hpp"
+#include "gzipRule.hpp"
+#include "gzipTypesRule.hpp"
+#include "gzipMinLengthRule.hpp"
+#include "gzipCompLevelRule.hpp"
+#include "gzipStaticRule.hpp"
+#include "cacheControlRule.hpp"
 
 #include <ostream>
 #include <string>
@@ -41,7 +48,14 @@ public:
     CgiRule cgi;
     CgiTimeoutRule cgiTimeout;
     CgiExtensionRule cgiExtension;
+    FastCGIPassRule fastcgiPass;
     ClientBodyReadTimeoutRule clientBodyReadTimeout;
+    GzipRule gzip;
+    GzipTypesRule gzipTypes;
+    GzipMinLengthRule gzipMinLength;
+    GzipCompLevelRule gzipCompLevel;
+    GzipStaticRule gzipStatic;
+    CacheControlRule cacheControl;
 
     constexpr static Key getKey() { return Key::LOCATION; }
     constexpr static const char* getRuleName() { return "location"; }
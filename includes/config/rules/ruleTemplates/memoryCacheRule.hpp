@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define DEFAULT_MEMORY_CACHE_MAX_MEMORY 0
+#define DEFAULT_MEMORY_CACHE_MAX_FILE_SIZE (64 * 1024)
+
+class MemoryCacheRule : public BaseRule {
+private:
+    bool _isSet = false;
+    Size _maxMemory;
+    Size _maxFileSize;
+
+public:
+    constexpr static Key getKey() { return Key::MEMORY_CACHE; }
+    constexpr static const char* getRuleName() { return "memory_cache"; }
+    constexpr static const char* getRuleFormat() { return "memory_cache <max_memory|off> [max_file_size]"; }
+
+    MemoryCacheRule(const MemoryCacheRule &other) = default;
+    MemoryCacheRule& operator=(const MemoryCacheRule &other) = default;
+    ~MemoryCacheRule() = default;
+
+    MemoryCacheRule();
+    MemoryCacheRule(Rule *rule);
+
+    bool isSet() const;
+    size_t getMaxMemory() const;
+    size_t getMaxFileSize() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const MemoryCacheRule &rule);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define DEFAULT_OPEN_FILE_CACHE_MAX_ENTRIES 0
+#define DEFAULT_OPEN_FILE_CACHE_VALIDITY 60.0
+
+class OpenFileCacheRule : public BaseRule {
+private:
+    bool _isSet = false;
+    int _maxEntries;
+
+public:
+    Timespan validity;
+
+    constexpr static Key getKey() { return Key::OPEN_FILE_CACHE; }
+    constexpr static const char* getRuleName() { return "open_file_cache"; }
+    constexpr static const char* getRuleFormat() { return "open_file_cache <max_entries|off> [validity]"; }
+
+    OpenFileCacheRule(const OpenFileCacheRule &other) = default;
+    OpenFileCacheRule& operator=(const OpenFileCacheRule &other) = default;
+    ~OpenFileCacheRule() = default;
+
+    OpenFileCacheRule();
+    OpenFileCacheRule(Rule *rule);
+
+    bool isSet() const;
+    size_t getMaxEntries() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const OpenFileCacheRule &rule);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define DEFAULT_PIPELINE_DEPTH 8
+
+class PipelineDepthRule : public BaseRule {
+private:
+    bool _isSet;
+    int _depth;
+
+public:
+    constexpr static Key getKey() { return Key::PIPELINE_DEPTH; }
+    constexpr static const char* getRuleName() { return "pipeline_depth"; }
+    constexpr static const char* getRuleFormat() { return "pipeline_depth <count>"; }
+
+    PipelineDepthRule(const PipelineDepthRule &other) = default;
+    PipelineDepthRule& operator=(const PipelineDepthRule &other) = default;
+    ~PipelineDepthRule() = default;
+
+    PipelineDepthRule();
+    PipelineDepthRule(Rule *rule);
+
+    bool isSet() const;
+    size_t getDepth() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const PipelineDepthRule &rule);
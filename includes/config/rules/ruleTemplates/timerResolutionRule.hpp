@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define DEFAULT_TIMER_RESOLUTION 0.0
+
+class TimerResolutionRule : public BaseRule {
+private:
+    bool _isSet = false;
+
+public:
+    Timespan resolution;
+
+    constexpr static Key getKey() { return Key::TIMER_RESOLUTION; }
+    constexpr static const char* getRuleName() { return "timer_resolution"; }
+    constexpr static const char* getRuleFormat() { return "timer_resolution <interval>"; }
+
+    TimerResolutionRule(const TimerResolutionRule &other) = default;
+    TimerResolutionRule& operator=(const TimerResolutionRule &other) = default;
+    ~TimerResolutionRule() = default;
+
+    TimerResolutionRule();
+    TimerResolutionRule(Rule *rule);
+
+    bool isSet() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const TimerResolutionRule &rule);
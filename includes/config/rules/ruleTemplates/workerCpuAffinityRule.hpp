@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define WORKER_CPU_AFFINITY_DEFAULT false
+
+class WorkerCpuAffinityRule : public BaseRule {
+private:
+    bool _isSet;
+    bool _enabled;
+
+public:
+    constexpr static Key getKey() { return Key::WORKER_CPU_AFFINITY; }
+    constexpr static const char* getRuleName() { return "worker_cpu_affinity"; }
+    constexpr static const char* getRuleFormat() { return "worker_cpu_affinity <on|off>"; }
+
+    WorkerCpuAffinityRule(const WorkerCpuAffinityRule &other) = default;
+    WorkerCpuAffinityRule& operator=(const WorkerCpuAffinityRule &other) = default;
+    ~WorkerCpuAffinityRule() = default;
+
+    WorkerCpuAffinityRule();
+    WorkerCpuAffinityRule(Rule *rule);
+
+    bool isSet() const;
+    bool isEnabled() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const WorkerCpuAffinityRule &rule);
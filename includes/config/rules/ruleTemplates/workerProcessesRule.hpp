@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../types/customTypes.hpp"
+#include "../../config.hpp"
+#include "../baserule.hpp"
+
+#include <ostream>
+#include <string>
+
+#define DEFAULT_WORKER_PROCESSES 1
+
+class WorkerProcessesRule : public BaseRule {
+private:
+    bool _isSet;
+    int _workerCount;
+
+public:
+    constexpr static Key getKey() { return Key::WORKER_PROCESSES; }
+    constexpr static const char* getRuleName() { return "worker_processes"; }
+    constexpr static const char* getRuleFormat() { return "worker_processes <count|auto>"; }
+
+    WorkerProcessesRule(const WorkerProcessesRule &other) = default;
+    WorkerProcessesRule& operator=(const WorkerProcessesRule &other) = default;
+    ~WorkerProcessesRule() = default;
+
+    WorkerProcessesRule();
+    WorkerProcessesRule(Rule *rule);
+
+    bool isSet() const;
+    int getWorkerCount() const;
+};
+
+std::ostream& operator<<(std::ostream &os, const WorkerProcessesRule &rule);
@@ -3,23 +3,38 @@
 #include "ruleTemplates/aliasRule.hpp"
 #include "ruleTemplates/autoindexRule.hpp"
 #include "ruleTemplates/bodyReadTimeoutRule.hpp"
+#include "ruleTemplates/cacheControlRule.hpp"
 #include "ruleTemplates/cgiExtensionRule.hpp"
+#include "ruleTemplates/cgiPreforkRule.hpp"
 #include "ruleTemplates/cgiRule.hpp"
 #include "ruleTemplates/cgiTimeoutRule.hpp"
 #include "ruleTemplates/defineRule.hpp"
 #include "ruleTemplates/errorpageRule.hpp"
+#include "ruleTemplates/fastcgiPassRule.hpp"
+#include "ruleTemplates/gzipCompLevelRule.hpp"
+#include "ruleTemplates/gzipMinLengthRule.hpp"
+#include "ruleTemplates/gzipRule.hpp"
+#include "ruleTemplates/gzipStaticRule.hpp"
+#include "ruleTemplates/gzipTypesRule.hpp"
 #include "ruleTemplates/headerReadTimeoutRule.hpp"
 #include "ruleTemplates/httpRule.hpp"
 #include "ruleTemplates/includeRule.hpp"
 #include "ruleTemplates/indexRule.hpp"
+#include "ruleTemplates/ioEngineRule.hpp"
 #include "ruleTemplates/keepaliveReadTimeoutRule.hpp"
 #include "ruleTemplates/maxBodySizeRule.hpp"
+#include "ruleTemplates/memoryCacheRule.hpp"
 #include "ruleTemplates/methodsRule.hpp"
+#include "ruleTemplates/openFileCacheRule.hpp"
+#include "ruleTemplates/pipelineDepthRule.hpp"
 #include "ruleTemplates/portRule.hpp"
 #include "ruleTemplates/returnRule.hpp"
 #include "ruleTemplates/rootRule.hpp"
 #include "ruleTemplates/servernameRule.hpp"
+#include "ruleTemplates/timerResolutionRule.hpp"
 #include "ruleTemplates/uploadstoreRule.hpp"
+#include "ruleTemplates/workerCpuAffinityRule.hpp"
+#include "ruleTemplates/workerProcessesRule.hpp"
 
 #include "ruleTemplates/locationRule.hpp"
 #include "ruleTemplates/serverconfigRule.hpp"
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "config/types/customTypes.hpp"
 
+#include <string_view>
+#include <cstdint>
 #include <string>
 
 enum Method {
@@ -17,7 +19,7 @@ enum Method {
 #define ALL_METHODS (GET | POST | DELETE | PUT | HEAD | OPTIONS)
 
 Method operator|(Method lhs, Method rhs);
-Method stringToMethod(const std::string &str);
+Method stringToMethod(std::string_view str);
 std::string methodToStr(const Method &method);
 
 std::ostream &operator<<(std::ostream &os, const Method &method);
@@ -178,6 +180,9 @@ constexpr const char* getDefaultBodyForCode(HttpStatusCode code)
     }
 }
 
+/// @brief Slots of the table stringToHeaderKey() looks names up in, a power of two above twice the known keys.
+#define HEADER_KEY_TABLE_SIZE 64
+
 enum class HeaderKey {
     ContentType,
     ContentLength,
@@ -198,7 +203,21 @@ enum class HeaderKey {
     ContentDisposition,
     RetryAfter,
     CacheControl,
+    ETag,
+    ContentEncoding,
+    Vary,
+    LastModified,
+    IfNoneMatch,
+    IfModifiedSince,
+    Range,
+    IfRange,
+    AcceptRanges,
+    ContentRange,
+    Unknown,
 };
 
-std::string headerKeyToString(HeaderKey key);
+std::string_view headerKeyToString(HeaderKey key);
+uint32_t hashHeaderName(std::string_view name);
+HeaderKey stringToHeaderKey(std::string_view name);
+HeaderKey stringToHeaderKey(std::string_view name, uint32_t nameHash);
 std::ostream &operator<<(std::ostream &os, HeaderKey key);
\ No newline at end of file
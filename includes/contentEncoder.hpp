@@ -0,0 +1,53 @@
+#pragma once
+
+#include <zlib.h>
+
+#include <string_view>
+#include <memory>
+#include <string>
+
+#define CONTENT_ENCODER_WINDOW_BITS 15
+#define CONTENT_ENCODER_MEMORY_LEVEL 8
+#define CONTENT_ENCODER_OUTPUT_BLOCK_SIZE (16 * 1024)
+
+enum class ContentEncoding {
+    Identity,
+    Gzip,
+    Deflate,
+};
+
+enum class EncoderFlush {
+    /// @brief Let zlib hold on to output until it has a full block.
+    None,
+    /// @brief Emit everything compressed so far, so the client can decode it without the rest of the body.
+    Sync,
+    /// @brief End the stream, nothing can be written afterwards.
+    Finish,
+};
+
+/// @brief Streaming compressor for response bodies, one instance per response.
+class ContentEncoder {
+private:
+    z_stream _stream;
+    ContentEncoding _encoding;
+    bool _isFinished;
+
+    ContentEncoder(ContentEncoding encoding);
+
+public:
+    ContentEncoder(const ContentEncoder &other) = delete;
+    ContentEncoder &operator=(const ContentEncoder &other) = delete;
+    ~ContentEncoder();
+
+    static std::unique_ptr<ContentEncoder> create(ContentEncoding encoding, int level);
+
+    bool write(std::string_view input, std::string &output, EncoderFlush flush);
+
+    inline ContentEncoding getEncoding() const { return _encoding; }
+    inline bool isFinished() const { return _isFinished; }
+
+    static double getQuality(const std::string &acceptEncoding, ContentEncoding encoding);
+    static ContentEncoding negotiate(const std::string &acceptEncoding);
+    static const char *getName(ContentEncoding encoding);
+    static std::string getVariantETag(const std::string &etag, ContentEncoding encoding);
+};
@@ -3,6 +3,7 @@
 #include "config/rules/rules.hpp"
 #include "request.hpp"
 
+#include <string_view>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -23,7 +24,7 @@ public:
 	~Cookie() = default;
 
 	static Cookie create(const std::string &name, const std::string &value);
-	static std::vector<Cookie> createAllFromHeader(const std::string &header_value);
+	static std::vector<Cookie> createAllFromHeader(std::string_view header_value);
 
 	inline Cookie &setPath(const Path &path) {
 		_path = path;
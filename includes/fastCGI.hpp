@@ -0,0 +1,122 @@
+#pragma once
+
+#include "config/rules/rules.hpp"
+#include "fastCGIRecord.hpp"
+#include "body.hpp"
+#include "fd.hpp"
+
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FASTCGI_MAX_CONNECTIONS 64 // per application
+#define FASTCGI_MAX_REQUESTS 32 // per connection, when the application multiplexes
+#define FASTCGI_MAX_BACKLOG (1024 * 256) // queued bytes before request bodies wait for the connection
+#define FASTCGI_MAX_PENDING_OUTPUT (READ_BUFFER_SIZE * 2) // output a request's handler refused, as much as it holds itself
+
+class Server;
+
+/// @brief Receives what the application sends back for one request.
+class FastCGIRequestHandler {
+public:
+    virtual ~FastCGIRequestHandler() = default;
+
+    /// @brief Bytes of the application's output (FCGI_STDOUT).
+    /// @return false to have the connection keep them, until resume() is called with the request's ID.
+    virtual bool handleFastCGIOutput(std::string_view data) = 0;
+
+    /// @brief The request ended, completely or because the connection was lost.
+    /// @details The request's ID is released before the call, the handler must forget it.
+    virtual void handleFastCGIEnd(bool isComplete) = 0;
+
+    /// @brief The connection caught up on what was queued on it and takes more request body.
+    virtual void handleFastCGIWritable() = 0;
+};
+
+/// @brief Persistent connection to a FastCGI application, shared by the requests sent over it.
+/// @details Requests are opened with FCGI_KEEP_CONN, so the connection outlives them and is handed
+/// to the next one. It carries a single request at a time, unless the application answers the
+/// FCGI_GET_VALUES sent on connect with FCGI_MPXS_CONNS, then records of several requests are
+/// interleaved on it and told apart by their request ID. Output a handler refuses waits in its
+/// request's slot, up to FASTCGI_MAX_PENDING_OUTPUT, and the connection stops reading once that is
+/// full. A connection with such a stalled request takes no new ones, they go to another connection.
+class FastCGIConnection {
+private:
+    struct Slot {
+        FastCGIRequestHandler *handler = nullptr;
+        bool isActive = false;
+        std::string pendingOutput;
+        bool isEnded = false; // FCGI_END_REQUEST came in while output was still pending
+        bool isComplete = false;
+
+        bool hasPendingOutput() const { return (!pendingOutput.empty()); }
+    };
+
+    Server &_server;
+    std::string _address;
+    ReadableFD _fd;
+    FDWriter _writer;
+    BodyWriter<FDReader, FDWriter> _output;
+    uint32_t _events;
+
+    std::vector<Slot> _slots;
+    size_t _activeRequests;
+    size_t _maxRequests;
+
+    bool _isConnecting;
+    bool _isPaused;
+    bool _isHungUp;
+    bool _isClosed;
+
+    bool _connect(const FastCGIPassRule &rule);
+    void _handleEvent(short revents);
+    void _handleRecords();
+    bool _handleOutput(size_t index, std::string_view content);
+    void _dropPendingOutput(Slot &slot);
+    void _handleValues(std::string_view content);
+    void _endRequest(uint16_t requestId, bool isComplete);
+    void _notifyWritable();
+    void _wake();
+    bool _hasPendingOutput() const;
+    void _updateEvents(uint32_t extraEvents = 0);
+
+    void _queueRecord(FastCGIRecordType type, uint16_t requestId, std::string_view content);
+    void _sendRecord(FastCGIRecordType type, uint16_t requestId, std::string_view content);
+
+public:
+    FastCGIConnection(Server &server, const FastCGIPassRule &rule);
+    FastCGIConnection(const FastCGIConnection &other) = delete;
+    FastCGIConnection &operator=(const FastCGIConnection &other) = delete;
+    ~FastCGIConnection();
+
+    uint16_t beginRequest(FastCGIRequestHandler &handler, const std::vector<std::string> &environment);
+    void sendStdin(uint16_t requestId, std::string_view data);
+    void abortRequest(uint16_t requestId);
+    void resume(uint16_t requestId);
+    void close();
+
+    bool canTakeRequest() const;
+    bool isBacklogged() const;
+    bool isClosed() const;
+};
+
+/// @brief Connections to the FastCGI applications of the configuration, by address.
+/// @details Connections are opened on demand, up to FASTCGI_MAX_CONNECTIONS per application, and
+/// kept for the next requests. Ones the application closed are dropped when it's next looked up.
+class FastCGIPool {
+private:
+    Server &_server;
+    std::unordered_map<std::string, std::vector<std::unique_ptr<FastCGIConnection>>> _connections;
+
+public:
+    FastCGIPool(Server &server);
+    FastCGIPool(const FastCGIPool &other) = delete;
+    FastCGIPool &operator=(const FastCGIPool &other) = delete;
+    ~FastCGIPool() = default;
+
+    FastCGIConnection *acquire(const FastCGIPassRule &rule);
+    void clear();
+};
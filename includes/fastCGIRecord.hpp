@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#define FASTCGI_VERSION 1
+#define FASTCGI_HEADER_SIZE 8
+#define FASTCGI_MAX_CONTENT_LENGTH 65535
+
+/// @brief Record types of the FastCGI protocol, https://fastcgi-archives.github.io/FastCGI_Specification.html
+enum class FastCGIRecordType : uint8_t {
+    BeginRequest = 1,
+    AbortRequest = 2,
+    EndRequest = 3,
+    Params = 4,
+    Stdin = 5,
+    Stdout = 6,
+    Stderr = 7,
+    Data = 8,
+    GetValues = 9,
+    GetValuesResult = 10,
+    UnknownType = 11,
+};
+
+enum class FastCGIProtocolStatus : uint8_t {
+    RequestComplete = 0,
+    CantMultiplex = 1,
+    Overloaded = 2,
+    UnknownRole = 3,
+};
+
+/// @brief The wire format of FastCGI records and of the name-value pairs of FCGI_PARAMS and FCGI_GET_VALUES.
+namespace FastCGIRecord {
+    void formatHeader(char (&header)[FASTCGI_HEADER_SIZE], FastCGIRecordType type, uint16_t requestId, size_t contentLength);
+
+    void appendPairLength(std::string &buffer, size_t length);
+    void appendPair(std::string &buffer, std::string_view name, std::string_view value);
+    bool readPairLength(std::string_view content, size_t &offset, size_t &length);
+
+    /// @brief Cut content into records of at most FASTCGI_MAX_CONTENT_LENGTH bytes, empty content into
+    /// one empty record, and hand each one's header and content to `record`.
+    template <typename Function>
+    void split(FastCGIRecordType type, uint16_t requestId, std::string_view content, Function record) {
+        do {
+            std::string_view part = content.substr(0, FASTCGI_MAX_CONTENT_LENGTH);
+            content.remove_prefix(part.size());
+
+            char header[FASTCGI_HEADER_SIZE];
+            formatHeader(header, type, requestId, part.size());
+            record(std::string_view(header, sizeof(header)), part);
+        } while (!content.empty());
+    }
+}
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <sys/epoll.h>
+#include <sys/uio.h>
+#include "readBuffer.hpp"
+
+#include <string_view>
 #include <functional>
 #include <unistd.h>
 #include <chrono>
@@ -14,6 +18,10 @@
 #define DEFAULT_MAX_BUFFER_SIZE (1024 * 1024 * 5) // 1 mb
 #define READ_BUFFER_SIZE (1024 * 64) // 64 kb
 #define MAX_ACCEPT_CHUNK_SIZE (1024 * 1024)
+#define MAX_CHUNK_SIZE_LINE 4096
+#define HTTP_CHUNK_HEADER_SIZE 24 // 16 hex digits and CRLF, rounded up
+
+class IOUring;
 
 enum class FDState {
     /// @brief The file descriptor is in an invalid state (e.g., not initialized).
@@ -37,6 +45,9 @@ private:
     int _fd;
     int _epollFd;
 
+    /// @brief When set, epoll updates and closes are queued on this ring instead of issued directly.
+    static IOUring *_submissionRing;
+
 protected:
     int p_cleanUp();
     int p_setEpollEvents(uint32_t events);
@@ -83,13 +94,16 @@ public:
 
     /// @brief Check if the file descriptor is valid (open).
     bool isValidFd() const { return _fd != -1; }
+
+    static void useSubmissionRing(IOUring *ring);
+    static void flushSubmissionRing();
 };
 
 class FDReader {
 private:
     int _fd;
     size_t _maxBufferSize;
-    std::string _readBuffer;
+    ReadBuffer _readBuffer;
     FDState _state;
     std::chrono::steady_clock::time_point _lastReadTime;
     
@@ -133,12 +147,18 @@ public:
     FDState getReaderFDState() const;
 
     std::string extractHeadersFromReadBuffer();
+    bool hasHeadersInReadBuffer();
     HTTPChunk extractHTTPChunkFromReadBuffer();
-    HTTPChunkStatus returnHTTPChunkStatus() const;
+    HTTPChunkStatus returnHTTPChunkStatus();
     std::string extractChunkFromReadBuffer(size_t chunkSize);
     std::string extractFullBuffer();
 
-    const std::string &peekReadBuffer() const;
+    std::string_view peekReadBuffer() const;
+    std::string_view peekReadBuffer(size_t maxSize) const;
+    void consumeReadBuffer(size_t size);
+    void appendToReadBuffer(std::string_view data);
+    void countBypassedBodyBytes(size_t size);
+    void skipReadBuffer(size_t size);
     std::chrono::steady_clock::time_point getLastReadTime() const;
 
     void resetCounter();
@@ -156,8 +176,11 @@ public:
     FDWriter& operator=(const FDWriter &other) = default;
     ~FDWriter() = default;
 
-    ssize_t writeAsString(const std::string &data);
-    ssize_t writeAsChunk(const std::string &data);
+    ssize_t writeAsString(std::string_view data);
+    ssize_t writeFromFile(int fileFd, off_t &offset, size_t count);
+    ssize_t writeAsVector(const iovec *vectors, int count, bool hasMore = false);
+
+    static size_t formatChunkHeader(char (&buffer)[HTTP_CHUNK_HEADER_SIZE], size_t size);
 
     void setWriterFDState(FDState state);
 
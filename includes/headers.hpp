@@ -1,37 +1,83 @@
 #pragma once
 
 #include "config/types/consts.hpp"
+#include "requestParser.hpp"
 
+#include <string_view>
 #include <sstream>
+#include <cstdint>
 #include <string>
-#include <map>
+#include <vector>
 
+#define HEADERS_INITIAL_FIELDS 16
+#define HEADERS_INITIAL_ARENA_SIZE 512
+
+/// @brief The header fields of a request or response, in the order they were added.
+/// @details Fields live in a small flat vector: the ones with a HeaderKey are stored and found by
+/// that ID, any other by its name, compared case-insensitively behind a hash. Names and values are
+/// copied into one arena string, so adding a field allocates at most when the arena grows.
+/// Values are returned as views into the arena, they stay valid until the next change to the headers.
 class Headers {
 private:
-    std::multimap<std::string, std::string> _headers;
+    struct Field {
+        HeaderKey key;
+        uint32_t nameHash;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t valueOffset;
+        uint32_t valueLength;
+    };
+
+    std::vector<Field> _fields;
+    std::string _arena;
+
+    uint32_t _store(std::string_view text);
+    void _add(HeaderKey key, std::string_view name, std::string_view value, uint32_t nameHash);
+    void _removeAll(HeaderKey key);
+    std::vector<Field>::const_iterator _find(HeaderKey key) const;
+    std::vector<Field>::const_iterator _find(std::string_view name) const;
+
+    inline std::string_view _nameOf(const Field &field) const {
+        if (field.key != HeaderKey::Unknown)
+            return (headerKeyToString(field.key));
+        return (std::string_view(_arena).substr(field.nameOffset, field.nameLength));
+    }
+    inline std::string_view _valueOf(const Field &field) const {
+        return (std::string_view(_arena).substr(field.valueOffset, field.valueLength));
+    }
 
 public:
     Headers();
     Headers(std::istringstream &source);
+    Headers(const RequestParser &parser, std::string_view buffer);
     Headers(const Headers &other);
     Headers &operator=(const Headers &other);
     ~Headers();
 
     bool isValid() const;
 
-    void add(const std::string &key, const std::string &value);
-    void add(HeaderKey key, const std::string &value);
-    void replace(HeaderKey key, const std::string &value);
+    void add(std::string_view name, std::string_view value);
+    void add(HeaderKey key, std::string_view value);
+    void replace(HeaderKey key, std::string_view value);
     void remove(HeaderKey key);
 
     void merge(const Headers &other);
+    size_t getSerializedLength() const;
+    void appendTo(std::string &buffer) const;
+
+    std::string_view getHeader(HeaderKey key) const;
+    std::string_view getHeader(HeaderKey key, std::string_view default_value) const;
+    std::string_view getHeader(std::string_view name, std::string_view default_value) const;
+    std::string getAndRemoveHeader(HeaderKey key, std::string_view default_value);
 
-    const std::string &getHeader(HeaderKey key) const;
-    const std::string &getHeader(HeaderKey key, const std::string &default_value) const;
-    const std::string getAndRemoveHeader(HeaderKey key, const std::string &default_value);
+    inline size_t size() const { return (_fields.size()); }
 
-    const std::multimap<std::string, std::string>& getHeaders() const;
+    /// @brief Call `visit(name, value)` for every field, in order.
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const Field &field : _fields)
+            visit(_nameOf(field), _valueOf(field));
+    }
 };
 
 std::ostream &operator<<(std::ostream &os, const Headers &headers);
-std::ostringstream &operator<<(std::ostringstream &os, const Headers &headers);
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#define IO_URING_QUEUE_DEPTH 256
+
+/// @brief Kind of operation a submission belongs to, stored in the upper half of its user data.
+enum class IOUringOperation : uint32_t {
+    EpollCtl = 1,
+    Close,
+    Accept,
+};
+
+/// @brief Minimal io_uring wrapper on top of the raw syscalls.
+/// @details The ring is used next to epoll: descriptor bookkeeping (epoll_ctl, close)
+/// and accepts are queued as submissions and flushed once per event loop tick,
+/// while the ring fd itself is polled through epoll to pick up completions.
+/// Socket reads and writes are not routed through the ring, they stay readiness based.
+class IOUring {
+private:
+    int _ringFd;
+
+    void *_sqRing;
+    size_t _sqRingSize;
+    void *_cqRing;
+    size_t _cqRingSize;
+    io_uring_sqe *_sqes;
+    size_t _sqesSize;
+
+    unsigned *_sqHead;
+    unsigned *_sqTail;
+    unsigned _sqMask;
+    unsigned _sqEntries;
+    unsigned *_sqArray;
+
+    unsigned *_cqHead;
+    unsigned *_cqTail;
+    unsigned _cqMask;
+    io_uring_cqe *_cqes;
+
+    unsigned _pendingSubmissions;
+
+    /// @brief IOSQE_CQE_SKIP_SUCCESS if the kernel supports it, set on submissions whose success needs no handling.
+    uint8_t _skipSuccessFlag;
+
+    /// @brief epoll_event payloads for queued EPOLL_CTL submissions, indexed like the sqes.
+    std::vector<epoll_event> _epollEvents;
+
+    io_uring_sqe *_getSubmissionEntry(unsigned &index);
+    void _unmap();
+
+public:
+    struct Completion {
+        IOUringOperation operation;
+        int fd;
+        int32_t result;
+        uint32_t flags;
+    };
+
+    IOUring(unsigned entries = IO_URING_QUEUE_DEPTH);
+    IOUring(const IOUring &other) = delete;
+    IOUring &operator=(const IOUring &other) = delete;
+    ~IOUring();
+
+    bool queueEpollCtl(int epollFd, int operation, int fd, uint32_t events);
+    bool queueClose(int fd, int epollFd = -1);
+    bool queueMultishotAccept(int listenFd);
+
+    int submit();
+    size_t processCompletions(const std::function<void(const Completion&)> &handler);
+
+    inline int getFd() const { return _ringFd; }
+    inline unsigned getPendingSubmissions() const { return _pendingSubmissions; }
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "contentEncoder.hpp"
+#include "openFileCache.hpp"
+
+#include <sys/types.h>
+#include <unordered_map>
+#include <memory>
+#include <string>
+#include <ctime>
+#include <list>
+
+/// @brief A small file kept in memory along with the part of its response that only depends on the file.
+struct CachedFile {
+    /// @brief Status line and file headers (Content-Type, Content-Length, ETag, Last-Modified, and Content-Encoding
+    /// for compressed variants), each ending in CRLF.
+    std::string head;
+    std::string body;
+
+    ino_t inode;
+    off_t size;
+    timespec modificationTime;
+
+    bool matches(const OpenFile &file) const;
+};
+
+/// @brief Memory-budgeted LRU cache of small regular files, keyed by path.
+/// @details Entries are checked against the OpenFile of every lookup, so a file that changed on
+/// disk is reloaded as soon as the open file cache (or a fresh open, when it's off) reports it.
+/// Compressed variants are entries of their own, so a popular file is only compressed once per version.
+class MemoryCache {
+private:
+    struct Entry {
+        std::shared_ptr<const CachedFile> file;
+        std::list<std::string>::iterator lruPosition;
+        size_t cost;
+    };
+
+    size_t _maxMemory;
+    size_t _maxFileSize;
+    size_t _usedMemory;
+
+    std::unordered_map<std::string, Entry> _entries;
+    std::list<std::string> _lru;
+
+    size_t _hits;
+    size_t _misses;
+    size_t _evictions;
+
+    void _erase(std::unordered_map<std::string, Entry>::iterator it);
+    static std::shared_ptr<const CachedFile> _load(const std::string &path, const OpenFile &file, ContentEncoding encoding, int level);
+
+public:
+    MemoryCache();
+    MemoryCache(const MemoryCache &other) = delete;
+    MemoryCache &operator=(const MemoryCache &other) = delete;
+    ~MemoryCache() = default;
+
+    void configure(size_t maxMemory, size_t maxFileSize);
+    std::shared_ptr<const CachedFile> lookup(const std::string &path, const OpenFile &file,
+        ContentEncoding encoding = ContentEncoding::Identity, int level = 0);
+    void clear();
+
+    inline bool isEnabled() const { return _maxMemory > 0; }
+    inline size_t getUsedMemory() const { return _usedMemory; }
+    inline size_t getHits() const { return _hits; }
+    inline size_t getMisses() const { return _misses; }
+    inline size_t getEvictions() const { return _evictions; }
+};
@@ -10,7 +10,6 @@
 typedef struct stat PathStat;
 
 bool tryCreateResponseFromFile(const Path &filepath, Response &response);
-std::string getMimeType(const std::string &filename);
 
 class GetMethod {
 private:
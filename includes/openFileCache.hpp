@@ -0,0 +1,87 @@
+#pragma once
+
+#include <sys/types.h>
+#include <unordered_map>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <ctime>
+#include <list>
+
+#define OPEN_FILE_CACHE_NOTIFY_BUFFER_SIZE 4096
+
+/// @brief Outcome of opening a path: its metadata and, for regular files, an open descriptor.
+/// @details The descriptor stays open for the lifetime of the object and is only ever read at
+/// explicit offsets (sendfile, pread), so a single one can serve any amount of responses at once.
+struct OpenFile {
+    int fd;
+    bool exists;
+    bool isDirectory;
+    bool isRegular;
+    off_t size;
+    ino_t inode;
+    timespec modificationTime;
+
+    OpenFile();
+    OpenFile(const OpenFile &other) = delete;
+    OpenFile &operator=(const OpenFile &other) = delete;
+    ~OpenFile();
+
+    std::string getETag() const;
+    std::string getLastModified() const;
+
+    static std::shared_ptr<const OpenFile> open(const std::string &path);
+    static std::shared_ptr<const OpenFile> stat(const std::string &path);
+    static std::shared_ptr<const OpenFile> withDescriptor(const std::string &path, const std::shared_ptr<const OpenFile> &file);
+};
+
+/// @brief Cache of OpenFile results keyed by path, including paths that don't exist.
+/// @details Entries are dropped on the first of: being the least recently used one when the cache
+/// is full, outliving their validity, or an inotify event on their parent directory reporting a
+/// change to them. When disabled, every lookup stats the path again and nothing is kept, files are
+/// only opened once a response reads them (see OpenFile::withDescriptor).
+class OpenFileCache {
+private:
+    struct Entry {
+        std::shared_ptr<const OpenFile> file;
+        std::chrono::steady_clock::time_point validUntil;
+        std::list<std::string>::iterator lruPosition;
+        int watch;
+    };
+
+    struct Watch {
+        std::string directory;
+        size_t entries;
+    };
+
+    size_t _maxEntries;
+    std::chrono::steady_clock::duration _validity;
+
+    std::unordered_map<std::string, Entry> _entries;
+    std::list<std::string> _lru;
+
+    int _notifyFd;
+    std::unordered_map<int, Watch> _watches;
+    std::unordered_map<std::string, int> _directoryWatches;
+
+    int _watchParentDirectory(const std::string &path);
+    void _releaseWatch(int watch);
+    void _erase(std::unordered_map<std::string, Entry>::iterator it);
+    void _invalidate(const std::string &path);
+    void _invalidateDirectory(int watch);
+
+public:
+    OpenFileCache();
+    OpenFileCache(const OpenFileCache &other) = delete;
+    OpenFileCache &operator=(const OpenFileCache &other) = delete;
+    ~OpenFileCache();
+
+    void configure(size_t maxEntries, std::chrono::steady_clock::duration validity);
+    std::shared_ptr<const OpenFile> lookup(const std::string &path);
+    void handleNotifications();
+    void clear();
+
+    inline bool isEnabled() const { return _maxEntries > 0; }
+    inline int getNotifyFd() const { return _notifyFd; }
+    inline size_t size() const { return _entries.size(); }
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+#include <vector>
+
+/// @brief Contiguous byte buffer with separate read and write cursors.
+/// @details Consuming bytes only advances the read cursor. Unread bytes are moved back to
+/// the front lazily, when the consumed prefix is at least as large as the unread data,
+/// so every byte is moved at most a constant amount of times. Unread data is always one
+/// contiguous span that can be handed out as a view.
+class ReadBuffer {
+private:
+    std::vector<char> _data;
+    size_t _readPos;
+    size_t _writePos;
+
+    /// @brief Unread bytes already searched for `_scanDelimiter` without a match, see scan().
+    std::string_view _scanDelimiter;
+    size_t _scanned;
+
+    void _compact();
+
+public:
+    ReadBuffer();
+    ReadBuffer(const ReadBuffer &other) = default;
+    ReadBuffer &operator=(const ReadBuffer &other) = default;
+    ~ReadBuffer() = default;
+
+    /// @brief Amount of unread bytes.
+    size_t size() const { return _writePos - _readPos; }
+    bool empty() const { return _writePos == _readPos; }
+
+    /// @brief View of the unread bytes, valid until the next write or consume.
+    std::string_view view() const { return std::string_view(_data.data() + _readPos, size()); }
+    std::string_view view(size_t maxSize) const;
+
+    size_t find(std::string_view needle, size_t from = 0) const;
+    size_t scan(std::string_view delimiter);
+
+    char *prepareWrite(size_t size);
+    void commitWrite(size_t size);
+    void append(std::string_view data);
+
+    void consume(size_t size);
+    void clear();
+};
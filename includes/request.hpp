@@ -2,6 +2,7 @@
 
 #include "config/types/consts.hpp"
 #include "sessionManager.hpp"
+#include "requestParser.hpp"
 #include "requestline.hpp"
 #include "headers.hpp"
 #include "cookie.hpp"
@@ -31,11 +32,12 @@ public:
     std::shared_ptr<SessionMetaData> session;
     ReceivingBodyMode receivingBodyMode;
 
-    Request() = default;
-    Request(std::string &buffer);
+    Request();
+    Request(const RequestParser &parser, std::string_view buffer);
     Request(const Request &other) = default;
     Request &operator=(const Request &other) = default;
     ~Request() = default;
 
-
+    bool hasBody() const;
+    size_t getRemainingBodyLength(size_t receivedBytes) const;
 };
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+#include <vector>
+
+#define REQUEST_PARSER_MAX_HEAD_SIZE (16 * 1024)
+#define REQUEST_PARSER_MAX_FIELDS 100
+
+/// @brief Position of a token in the parsed buffer, relative to its first unread byte.
+/// @details Offsets survive the buffer growing or compacting between two parse calls, pointers wouldn't.
+struct ParserSpan {
+    size_t offset;
+    size_t length;
+
+    inline std::string_view in(std::string_view buffer) const { return buffer.substr(offset, length); }
+};
+
+enum class RequestParserStatus {
+    Incomplete,
+    Complete,
+    Invalid,
+    TooLarge,
+};
+
+/// @brief Resumable parser for the head of an HTTP/1.1 request: the request line and the header fields.
+/// @details Works on the unread part of a connection's buffer without copying it, and only records
+/// where the tokens are. Every call continues where the previous one stopped, so a head arriving in
+/// pieces is scanned once, and a head that outgrows the limit is rejected as soon as it does.
+/// The parsed tokens are read through the getters with the same buffer, until it is consumed.
+class RequestParser {
+public:
+    struct Field {
+        ParserSpan name;
+        ParserSpan value;
+    };
+
+private:
+    enum class State {
+        RequestLine,
+        HeaderLine,
+        Done,
+    };
+
+    State _state;
+    RequestParserStatus _status;
+    size_t _maxSize;
+    size_t _lineStart;
+    size_t _scanPos;
+
+    ParserSpan _method;
+    ParserSpan _target;
+    ParserSpan _version;
+    std::vector<Field> _fields;
+
+    RequestParserStatus _fail(RequestParserStatus status);
+    bool _parseRequestLine(std::string_view line, size_t offset);
+    bool _parseHeaderLine(std::string_view line, size_t offset);
+
+public:
+    RequestParser(size_t maxSize = REQUEST_PARSER_MAX_HEAD_SIZE);
+    RequestParser(const RequestParser &other) = default;
+    RequestParser &operator=(const RequestParser &other) = default;
+    ~RequestParser() = default;
+
+    RequestParserStatus parse(std::string_view buffer);
+    void reset();
+
+    inline RequestParserStatus getStatus() const { return _status; }
+    inline bool hasFailed() const { return _status == RequestParserStatus::Invalid || _status == RequestParserStatus::TooLarge; }
+
+    /// @brief Amount of bytes the complete head takes up, including the empty line that ends it.
+    inline size_t getHeadLength() const { return _lineStart; }
+
+    inline std::string_view getMethod(std::string_view buffer) const { return _method.in(buffer); }
+    inline std::string_view getTarget(std::string_view buffer) const { return _target.in(buffer); }
+    inline std::string_view getVersion(std::string_view buffer) const { return _version.in(buffer); }
+    inline const std::vector<Field> &getFields() const { return _fields; }
+};
@@ -3,12 +3,13 @@
 #include "config/types/customTypes.hpp"
 #include "config/types/consts.hpp"
 #include "config/rules/rules.hpp"
+#include "openFileCache.hpp"
 
+#include <string_view>
 #include <sstream>
+#include <memory>
 #include <string>
 
-typedef struct stat PathStat;
-
 class RequestLine {
 private:
     Method _method;
@@ -18,17 +19,20 @@ private:
     Path _path;
     Path _serverAbsolutePath;
     bool _pathIsDirectory;
+    std::shared_ptr<const OpenFile> _file;
+    std::shared_ptr<const OpenFile> _precompressedFile;
 
-    bool _fetchCorrectPathFromIndexRule(const IndexRule &rule);
+    bool _fetchCorrectPathFromIndexRule(const IndexRule &rule, OpenFileCache &fileCache);
+    void _fetchPrecompressedFile(OpenFileCache &fileCache);
 
 public:
     RequestLine();
-    RequestLine(std::istringstream &source);
+    RequestLine(std::string_view method, std::string_view target, std::string_view version);
     RequestLine(const RequestLine &other);
     RequestLine &operator=(const RequestLine &other);
     ~RequestLine();
 
-    void translateUrl(const std::string &serverRelativePath, const LocationRule &route);
+    void translateUrl(const std::string &serverRelativePath, const LocationRule &route, OpenFileCache &fileCache);
 
     bool isValid() const;
 
@@ -38,6 +42,8 @@ public:
     const std::string &getServerAbsolutePath() const;
     const Path &getPath() const;
     bool pathIsDirectory() const;
+    const std::shared_ptr<const OpenFile> &getFile() const;
+    const std::shared_ptr<const OpenFile> &getPrecompressedFile() const;
 };
 
 std::ostream &operator<<(std::ostream &os, const RequestLine &request_line);
\ No newline at end of file
@@ -2,14 +2,27 @@
 
 #include "config/rules/ruleTemplates/locationRule.hpp"
 #include "config/types/consts.hpp"
+#include "openFileCache.hpp"
+#include "memoryCache.hpp"
+#include "contentEncoder.hpp"
+#include "byteRange.hpp"
 #include "headers.hpp"
+#include "fastCGI.hpp"
 #include "server.hpp"
 #include "client.hpp"
 #include "body.hpp"
 #include "fd.hpp"
 
+#include <sys/types.h>
+#include <string_view>
+#include <memory>
 #include <string>
 
+#define SENDFILE_CHUNK_SIZE (1024 * 1024) // 1 mb per write tick
+#define COMPRESSION_READ_SIZE (64 * 1024) // 64 kb of file compressed per write tick
+#define CGI_OUTPUT_BUFFER_SIZE (READ_BUFFER_SIZE * 2) // output held per CGI response, a partial head and one more read
+#define CGI_SPLICE_SIZE (1024 * 1024) // bytes asked of one splice, a pipe holds 64 kb unless resized
+
 class Server;
 
 struct ParsedUrl {
@@ -29,6 +42,14 @@ protected:
 	Request *_request;
     Client *_client;
 
+    /// @brief Set once the body is sent compressed, every byte of it has to go through here.
+    std::unique_ptr<ContentEncoder> _encoder;
+
+    bool _setupCompression(ssize_t contentLength);
+    bool _sendEncodedChunk(SocketFD &fd, std::string_view data, EncoderFlush flush);
+
+    static void _discardRequestBody(SocketFD &fd, const Request &request);
+
 public:
     Headers headers;
 
@@ -48,12 +69,15 @@ public:
 	ssize_t sendBodyAsString(SocketFD &fd, const std::string &body);
 
     bool headersBeenSent() const;
-    void sendHeaders(SocketFD &fd);
+    void sendHeaders();
     HttpStatusCode getStatusCode() const;
 
     virtual bool didResponseCreationFail() const;
     virtual bool shouldDirectlySendResponse() const;
     virtual HttpStatusCode getFailedResponseStatusCode() const;
+    virtual bool isReadingSocketDirectly() const;
+
+    static bool isCompressible(const LocationRule *route, std::string_view contentType, ssize_t contentLength);
 
     virtual bool isFullResponseSent() const = 0;
 
@@ -66,15 +90,40 @@ public:
 
 class FileResponse : public Response {
 private:
+    /// @brief Bytes [start, end) of the file, preceded by `prefix` (a multipart delimiter and part headers).
+    struct FileSegment {
+        std::string prefix;
+        off_t start;
+        off_t end;
+    };
+
     ReadableFD _fileFD;
+    std::shared_ptr<const OpenFile> _cachedFile;
     bool _isFinalChunkSent;
 
+    /// @brief Regular files are sent with a Content-Length through sendfile, anything else is chunked.
+    bool _isSendingWithSendfile;
+    bool _isRangeResponse;
+    off_t _fileSize;
+
+    /// @brief What is left to send of a regular file: the whole file, or the requested ranges.
+    std::vector<FileSegment> _segments;
+    size_t _segmentIndex;
+
+    int _getFileDescriptor() const;
+    void _skipSentSegments();
+    void _sendFileTick(SocketFD &fd);
+    void _sendCompressedFileTick(SocketFD &fd);
+
 public:
     FileResponse(Client *client, ReadableFD fileFD, Request *request);
+    FileResponse(Client *client, std::shared_ptr<const OpenFile> file, Request *request);
     FileResponse(const FileResponse &other) = default;
     FileResponse &operator=(const FileResponse &other) = default;
     ~FileResponse() override;
 
+    void setRanges(const std::vector<ByteRange> &ranges, const std::string &contentType);
+
     bool isFullResponseSent() const override;
     bool shouldDirectlySendResponse() const override;
 
@@ -83,7 +132,30 @@ public:
     void terminateResponse() override;
 };
 
-class CGIResponse : public Response {
+/// @brief Response for a file in the memory cache. The cached head, the headers of this
+/// response and the body go out together through writev, without touching the file.
+class MemoryResponse : public Response {
+private:
+    std::shared_ptr<const CachedFile> _file;
+    std::string _responseHeaders;
+    size_t _bytesSent;
+    bool _isFullResponseSent;
+
+public:
+    MemoryResponse(Client *client, std::shared_ptr<const CachedFile> file, Request *request);
+    MemoryResponse(const MemoryResponse &other) = default;
+    MemoryResponse &operator=(const MemoryResponse &other) = default;
+    ~MemoryResponse() override = default;
+
+    bool isFullResponseSent() const override;
+    bool shouldDirectlySendResponse() const override;
+
+    void handleRequestBody(SocketFD &fd, const Request &request) override;
+    void handleSocketWriteTick(SocketFD &fd) override;
+    void terminateResponse() override;
+};
+
+class CGIResponse : public Response, private FastCGIRequestHandler {
 private:
     enum class CGIResponseTransferMode {
         Unknown,
@@ -95,9 +167,14 @@ private:
     ReadableFD _cgiOutputFD;
     WritableFD _cgiInputFD;
 
-    std::unordered_map<std::string, std::string> _environmentVariables;
+    std::vector<std::string> _environment;
     BodyWriter<FDReader, FDWriter> _pipeWriter;
 
+    FastCGIConnection *_fastCGIConnection;
+    uint16_t _fastCGIRequestId;
+    bool _isFastCGIStdinClosed;
+
+    /// @brief Body bytes sent and the Content-Length the script announced, for output sent as is.
     ssize_t _sendBytesTracker;
     ssize_t _responseLength;
 
@@ -108,24 +185,46 @@ private:
     bool _hasSentFinalChunk;
     bool _isBrokenBeyondRepair;
     bool _isGamblingResponseWillWork;
+    bool _isRequestBodySpliceDisabled;
+    bool _isOutputSpliceDisabled;
+    bool _isCGIOutputPaused;
     CGIResponseTransferMode _transferMode;
 
     HttpStatusCode _innerStatusCode;
 
+    const std::vector<std::string> &_getLocationEnvironment(const ServerConfig &config, const LocationRule &route, const Path &serverExecutablePath);
     void _setupEnvironmentVariables(const ServerConfig &config, const LocationRule &route, const ParsedUrl &parsedUrl, const Path &serverExecutablePath);
 
-    void _createEnvironmentArray(std::vector<char*> &envPtrs, std::vector<std::string> &strBuff) const;
+    void _createEnvironmentArray(std::vector<char*> &envPtrs) const;
 
     void _handleCGIInputPipeEvent(WritableFD &fd, short revents);
     void _handleCGIOutputPipeEvent(ReadableFD &fd, short revents);
 
+    void _armTimeout(const LocationRule &route);
     void _handleTimeout();
     ssize_t _sendRequestBodyToCGIProcess();
     HttpStatusCode _prepareCGIResponse();
     void _sendCGIResponse();
-
+    void _sendEncodedCGIOutput(SocketFD &fd);
+
+    bool _spliceRequestBody();
+    bool _awaitRequestBody(bool isWaitingForSocket);
+    bool _isSplicingCGIOutput() const;
+    void _pauseCGIOutput(short revents);
+    void _resumeCGIOutput();
+    void _waitForCGIOutput(SocketFD &fd);
+    void _spliceCGIOutput(SocketFD &fd);
+    bool _endOutputOfWrongLength();
+
+    bool _spawnCGIProcess(const std::string &directory, const std::string &program, int stdinFd, int stdoutFd);
     void _closeToCGIProcessFd();
     void _closeFromCGIProcessFd();
+
+    bool _startFastCGI(const LocationRule &route);
+    void _sendRequestBodyToFastCGI();
+    bool handleFastCGIOutput(std::string_view data) override;
+    void handleFastCGIEnd(bool isComplete) override;
+    void handleFastCGIWritable() override;
     
 public:
     SocketFD &socketFD;
@@ -146,6 +245,7 @@ public:
     void handleSocketWriteTick(SocketFD &fd) override;
     void terminateResponse() override;
 
+    bool isReadingSocketDirectly() const override;
     bool isFullResponseSent() const override;
     bool isBrokenBeyondRepair() const;
 };
@@ -154,6 +254,8 @@ class StaticResponse : public Response {
 private:
     std::string _content;
 
+    void _compressContent();
+
 public:
     StaticResponse(Client *client, const std::string &content, Request *request);
     StaticResponse(const StaticResponse &other) = default;
@@ -3,12 +3,21 @@
 
 #include "config/rules/rules.hpp"
 #include "sessionManager.hpp"
+#include "openFileCache.hpp"
+#include "memoryCache.hpp"
+#include "fastCGI.hpp"
+#include "cgiPool.hpp"
 #include "response.hpp"
 #include "client.hpp"
+#include "ioUring.hpp"
 #include "timer.hpp"
 #include "fd.hpp"
 
+#include <netinet/in.h>
+#include <signal.h>
+#include <unordered_map>
 #include <concepts>
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <map>
@@ -36,17 +45,45 @@ struct FDEvent {
     std::function<void(T&, short)> callback;
 };
 
+enum class FDSlotType {
+    Empty,
+    Listener,
+    Client,
+    Readable,
+    Writable,
+    Ring,
+    Timer,
+    FileNotify
+};
+
+/// @brief Entry of the fd-indexed dispatch table, tagged with the kind of handler it holds.
+/// @details Handlers live behind unique_ptrs so references stay valid when the table grows.
+struct FDSlot {
+    FDSlotType type = FDSlotType::Empty;
+    std::unique_ptr<ServerClientInfo> client;
+    std::unique_ptr<FDEvent<ReadableFD&>> readable;
+    std::unique_ptr<FDEvent<WritableFD&>> writable;
+
+    void reset();
+};
+
 class Server {
 private:
     std::map<int, std::vector<ServerConfig>> _portToConfigs;
     UserSessionManager _sessionManager;
     int _server_fd;
     int _epoll_fd;
+    int _timer_fd;
+    std::chrono::steady_clock::time_point _timerFdDeadline;
     Timer _timer;
+    OpenFileCache _openFileCache;
+    MemoryCache _memoryCache;
+    FastCGIPool _fastCGIPool;
+    CGIPool _cgiPool;
+    std::unordered_map<const LocationRule *, std::vector<std::string>> _cgiEnvironments;
     HTTPRule &_httpRule;
-    std::map<int, ServerClientInfo> _clientDescriptors;
-    std::map<int, FDEvent<ReadableFD&>> _readableDescriptors;
-    std::map<int, FDEvent<WritableFD&>> _writableDescriptors;
+    std::vector<FDSlot> _fdSlots;
+    std::unique_ptr<IOUring> _ring;
 
     std::string _serverAddress;
     std::string _serverExecutablePath;
@@ -54,24 +91,33 @@ private:
     // Socket and epoll setup
     void _setupEpoll();
     void _setupSocket(int listenPort, const std::vector<ServerConfig> &configs);
+    void _setupIOUring();
+    void _setupTimerFd();
+    void _armTimerFd();
+    void _setupOpenFileCache();
     bool _epollExecute(int fd, uint32_t operation, uint32_t events);
 
     // Connection handling
     void _handleNewConnection(int sourceFd);
+    bool _registerClient(SocketFD &clientFD, int sourceFd, const sockaddr_in &clientAddress);
+    void _handleRingCompletions();
     void _removeDescriptor(int fd);
 
+    // Dispatch table
+    FDSlot &_slotAt(int fd);
+    FDSlot *_findSlot(int fd, FDSlotType type);
+
     // I/O handling
     void _handleClientFD(ServerClientInfo &clientInfo, short revents);
-    void _checkHangingConnections();
 
 public:
     Server(HTTPRule &http);
-    Server(const Server &other);
-    Server &operator=(const Server &other);
+    Server(const Server &other) = delete;
+    Server &operator=(const Server &other) = delete;
     ~Server();
 
     void cleanUp();
-    void runOnce();
+    void runOnce(const sigset_t *waitMask = nullptr);
 
     // Request processing
     ServerConfig &loadRequestConfig(const Request &request, int serverFd);
@@ -85,6 +131,12 @@ public:
     void untrackCallbackFD(int fd);
 
     inline Timer &getTimer() { return _timer; }
+    inline OpenFileCache &getOpenFileCache() { return _openFileCache; }
+    inline MemoryCache &getMemoryCache() { return _memoryCache; }
+    inline FastCGIPool &getFastCGIPool() { return _fastCGIPool; }
+    inline CGIPool &getCGIPool() { return _cgiPool; }
+    inline std::unordered_map<const LocationRule *, std::vector<std::string>> &getCGIEnvironments() { return _cgiEnvironments; }
+    inline const HTTPRule &getHTTPRule() const { return _httpRule; }
     inline int getEpollFd() const { return _epoll_fd; }
     inline std::string getServerAddress() { return _serverAddress; }
     inline std::string getServerExecutablePath() { return _serverExecutablePath; }
@@ -19,6 +19,7 @@
 	buffer.insert(buffer.end(), reinterpret_cast<const char *>(&data), reinterpret_cast<const char *>(&data) + sizeof(data))
 
 constexpr char SESSION_MANAGER_FILE[] = "session_manager.sm";
+constexpr char SESSION_MANAGER_LOCK_FILE[] = "session_manager.lock";
 
 struct SessionMetaData {
 	time_t		lastAccessTime;
@@ -37,6 +38,9 @@ private:
 	std::map<std::string, std::shared_ptr<SessionMetaData>> _currentSessions;
 
 	bool _deleteSession(std::map<std::string, std::shared_ptr<SessionMetaData>>::iterator it);
+	void _touchSessionFile(SessionMetaData &session, time_t now) const;
+	bool _isSessionFileInUse(SessionMetaData &session, time_t now) const;
+	static std::map<std::string, time_t> _readManagerFile(const std::string &path);
 
 public:
     UserSessionManager(const std::string &storagePath);
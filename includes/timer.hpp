@@ -1,34 +1,79 @@
 #pragma once
 
 #include <functional>
+#include <cstdint>
 #include <chrono>
-#include <set>
+#include <vector>
+#include <array>
+
+#define TIMER_WHEEL_LEVELS 6
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+#define TIMER_ID_INDEX_BITS 20
+#define TIMER_ID_MAX_EVENTS (1 << TIMER_ID_INDEX_BITS)
+
+/// @brief Source of the current time, replaceable so the wheel can be driven by a fake clock.
+typedef std::chrono::steady_clock::time_point (*TimerClock)();
 
 struct TimerEvent {
 	std::chrono::steady_clock::duration interval;
-	std::chrono::steady_clock::time_point time;
+	uint64_t expiryTick;
 	std::function<void()> callback;
-	int	id;
+	uint32_t generation;
 
-	bool operator<(const TimerEvent &other) const;
+	uint32_t bucket;
+	uint32_t prev;
+	uint32_t next;
 };
 
+/// @brief Hierarchical timing wheel with millisecond ticks.
+/// @details Every level holds TIMER_WHEEL_SLOTS buckets, each level covering TIMER_WHEEL_SLOTS
+/// times the range of the one below. Events sit in an intrusive list inside the bucket of the
+/// highest tick digit in which they differ from the current tick, and move down a level when
+/// the wheel reaches their bucket. Adding, rescheduling and deleting an event are O(1); the ID
+/// handed out encodes the event's slot and a generation, so stale IDs are rejected.
 class Timer {
 private:
-	std::multiset<TimerEvent> _events;
-	
-public:
-	static int nextId;
+	TimerClock _clock;
+	std::chrono::steady_clock::time_point _origin;
+	uint64_t _currentTick;
+
+	std::vector<TimerEvent> _events;
+	uint32_t _freeList;
+	size_t _activeEvents;
+
+	/// @brief Head of every bucket list, followed by the overflow and the firing list.
+	std::array<uint32_t, TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS + 2> _buckets;
+	std::array<uint64_t, TIMER_WHEEL_LEVELS> _occupied;
 
-	Timer() = default;
+	uint64_t _toTick(std::chrono::steady_clock::time_point time, bool roundUp) const;
+	TimerEvent *_getEvent(int eventId);
+	uint32_t _allocate();
+	void _release(uint32_t index);
+
+	void _link(uint32_t index, uint32_t bucket);
+	void _unlink(uint32_t index);
+	void _schedule(uint32_t index);
+	void _cascade(uint32_t bucket);
+	void _advance(uint64_t tick);
+	bool _nextTick(uint64_t &tick) const;
+
+public:
+	Timer();
+	explicit Timer(TimerClock clock);
 	Timer(const Timer &other) = default;
 	Timer &operator=(const Timer &other) = default;
 	~Timer() = default;
 
 	int addEvent(std::chrono::steady_clock::duration delay, std::function<void()> callback, bool isRecurring = false);
+	int rescheduleEvent(int eventId, std::chrono::steady_clock::duration delay);
 	int deleteEvent(int eventId);
-	
+
+	bool getNextEventTime(std::chrono::steady_clock::time_point &time) const;
 	int getNextEventTimeoutMS() const;
 	void processEvents();
 	void clear();
+
+	inline size_t size() const { return _activeEvents; }
 };
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "config/rules/rules.hpp"
+
+#include <sys/types.h>
+#include <signal.h>
+#include <vector>
+
+/// @brief Runs the server as a set of independent worker processes (reactors).
+/// Every worker owns its own epoll instance, SO_REUSEPORT listening sockets, timer
+/// and client tables; the kernel load balances new connections between them.
+class WorkerManager {
+private:
+    HTTPRule &_httpRule;
+    std::vector<pid_t> _workers;
+    sigset_t _originalSignalMask;
+
+    pid_t _spawnWorker(size_t index);
+    void _pinToCpu(size_t index) const;
+    void _reapWorkers();
+    void _stopWorkers();
+    size_t _countRunningWorkers() const;
+
+public:
+    WorkerManager(HTTPRule &http);
+    WorkerManager(const WorkerManager &other) = delete;
+    WorkerManager &operator=(const WorkerManager &other) = delete;
+    ~WorkerManager() = default;
+
+    int run();
+
+    static int runWorker(HTTPRule &http);
+};
@@ -5,9 +5,14 @@
 #include "print.hpp"
 
 #include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <cstdlib>
 #include <filesystem>
 #include <signal.h>
 #include <cstring>
+#include <charconv>
 #include <chrono>
 
 /// @brief Parses the given URL and extracts the script path, path info, and query string.
@@ -67,11 +72,13 @@ CGIResponse::CGIResponse(Client *client, Server &server, SocketFD &socketFD, Req
     Response(client),
     _server(server),
     _cgiOutputFD(), _cgiInputFD(),
-    _environmentVariables(),
+    _environment(),
     _pipeWriter(),
+    _fastCGIConnection(nullptr), _fastCGIRequestId(0), _isFastCGIStdinClosed(false),
     _sendBytesTracker(0), _responseLength(0),
     _timerId(-1), _processId(-1),
     _chunkedRequestBodyRead(false), _hasSentFinalChunk(false), _isBrokenBeyondRepair(false), _isGamblingResponseWillWork(false),
+    _isRequestBodySpliceDisabled(false), _isOutputSpliceDisabled(false), _isCGIOutputPaused(false),
     _transferMode(CGIResponseTransferMode::Unknown),
     _innerStatusCode(HttpStatusCode::OK), socketFD(socketFD) {
     DEBUG("CGIResponse created for client: " << client);
@@ -86,68 +93,86 @@ HttpStatusCode CGIResponse::getFailedResponseStatusCode() const {
     return (_innerStatusCode);
 }
 
-/// @brief Sets up the environment variables for the CGI process.
-/// @details https://www6.uniovi.es/~antonio/ncsa_httpd/cgi/env.html
-/// @param config The server configuration
-/// @param route The location rule
-void CGIResponse::_setupEnvironmentVariables(const ServerConfig &config, const LocationRule &route, const ParsedUrl &parsedUrl, const Path &serverExecutablePath) {
-    _environmentVariables.clear();
-    _environmentVariables["SERVER_SOFTWARE"] = "webserv/1.0";
-    _environmentVariables["SERVER_NAME"] = std::string(config.serverName.getServerName());
-    _environmentVariables["GATEWAY_INTERFACE"] = "CGI/1.1";
-
-    _environmentVariables["SERVER_PROTOCOL"] = Response::protocol + std::string("/") + Response::tlsVersion;
-    _environmentVariables["SERVER_PORT"] = std::to_string(config.port.getPort());
-    _environmentVariables["REQUEST_METHOD"] = methodToStr(_client->request.metadata.getMethod());
-    _environmentVariables["PATH_INFO"] = _request->metadata.getRawUrl();
-    _environmentVariables["PATH_TRANSLATED"] = std::string(parsedUrl.scriptPath + parsedUrl.pathInfo);
-    _environmentVariables["SCRIPT_FILENAME"] = parsedUrl.scriptPath;
-    _environmentVariables["SCRIPT_NAME"] = Path(parsedUrl.scriptPath).getFilename();
-    _environmentVariables["QUERY_STRING"] = std::string(parsedUrl.query);
-    _environmentVariables["REMOTE_ADDR"] = _client->getClientIP();
-    _environmentVariables["REMOTE_PORT"] = _client->getClientPort();
-    _environmentVariables["SERVER_ADDR"] = _client->getServer().getServerAddress();
-    _environmentVariables["SERVER_PORT"] = std::to_string(config.port.getPort());
-    _environmentVariables["REDIRECT_STATUS"] = "200";
+/// @brief Append a KEY=VALUE entry to an environment, allocated once at its final size.
+static void append_environment_variable(std::vector<std::string> &environment, std::string_view key, std::string_view value) {
+    std::string &entry = environment.emplace_back();
+    entry.reserve(key.size() + 1 + value.size());
+    entry.append(key).append(1, '=').append(value);
+}
+
+/// @brief Get the variables that are the same for every request of a location.
+/// @details They're built on the location's first CGI request and kept by the server, which outlives its locations' use.
+const std::vector<std::string> &CGIResponse::_getLocationEnvironment(const ServerConfig &config, const LocationRule &route, const Path &serverExecutablePath) {
+    auto [entry, isNew] = _server.getCGIEnvironments().try_emplace(&route);
+    std::vector<std::string> &environment = entry->second;
+    if (!isNew)
+        return (environment);
+
+    append_environment_variable(environment, "SERVER_SOFTWARE", "webserv/1.0");
+    append_environment_variable(environment, "SERVER_NAME", config.serverName.getServerName());
+    append_environment_variable(environment, "GATEWAY_INTERFACE", "CGI/1.1");
+    append_environment_variable(environment, "SERVER_PROTOCOL", Response::protocol + std::string("/") + Response::tlsVersion);
+    append_environment_variable(environment, "SERVER_PORT", std::to_string(config.port.getPort()));
+    append_environment_variable(environment, "SERVER_ADDR", _server.getServerAddress());
+    append_environment_variable(environment, "REDIRECT_STATUS", "200");
 
     DEBUG("Upload store: " << route.uploadStore.getUploadDir().str());
     if (route.uploadStore.isSet()) {
         DEBUG("Setting WEBSERV_UPLOAD_STORE environment variable for CGI: " << route.uploadStore.getUploadDir().str());
         Path uploadStorePath = Path(serverExecutablePath).append(route.uploadStore.getUploadDir().str());
         DEBUG("Upload store path: " << uploadStorePath.str());
-        _environmentVariables["WEBSERV_UPLOAD_STORE"] = uploadStorePath.str();
+        append_environment_variable(environment, "WEBSERV_UPLOAD_STORE", uploadStorePath.str());
     }
+    return (environment);
+}
+
+/// @brief Sets up the environment variables for the CGI process.
+/// @details https://www6.uniovi.es/~antonio/ncsa_httpd/cgi/env.html
+/// The location's variables are copied in, only the ones of the request are built here.
+/// @param config The server configuration
+/// @param route The location rule
+void CGIResponse::_setupEnvironmentVariables(const ServerConfig &config, const LocationRule &route, const ParsedUrl &parsedUrl, const Path &serverExecutablePath) {
+    const std::vector<std::string> &locationEnvironment = _getLocationEnvironment(config, route, serverExecutablePath);
+    _environment.clear();
+    _environment.reserve(locationEnvironment.size() + 12 + _client->request.headers.size());
+    _environment.insert(_environment.end(), locationEnvironment.begin(), locationEnvironment.end());
+
+    append_environment_variable(_environment, "REQUEST_METHOD", methodToStr(_client->request.metadata.getMethod()));
+    append_environment_variable(_environment, "PATH_INFO", _request->metadata.getRawUrl());
+    append_environment_variable(_environment, "PATH_TRANSLATED", parsedUrl.scriptPath + parsedUrl.pathInfo);
+    append_environment_variable(_environment, "SCRIPT_FILENAME", parsedUrl.scriptPath);
+    append_environment_variable(_environment, "SCRIPT_NAME", Path(parsedUrl.scriptPath).getFilename());
+    append_environment_variable(_environment, "QUERY_STRING", parsedUrl.query);
+    append_environment_variable(_environment, "REMOTE_ADDR", _client->getClientIP());
+    append_environment_variable(_environment, "REMOTE_PORT", _client->getClientPort());
 
     if (_client->request.session && !_client->request.session->sessionId.empty())
-        _environmentVariables["HTTP_SESSION_FILE"] = _client->request.session->absoluteFilePath;
+        append_environment_variable(_environment, "HTTP_SESSION_FILE", _client->request.session->absoluteFilePath);
 
-    const std::string contentHeader = _client->request.headers.getHeader(HeaderKey::ContentType, "");
+    std::string_view contentHeader = _client->request.headers.getHeader(HeaderKey::ContentType, "");
     if (!contentHeader.empty())
-        _environmentVariables["CONTENT_TYPE"] = contentHeader;
+        append_environment_variable(_environment, "CONTENT_TYPE", contentHeader);
 
-    const std::string contentLength = _client->request.headers.getHeader(HeaderKey::ContentLength, "");
+    std::string_view contentLength = _client->request.headers.getHeader(HeaderKey::ContentLength, "");
     if (!contentLength.empty())
-        _environmentVariables["CONTENT_LENGTH"] = contentLength;
-
-    for (const auto &[headerKey, headerValue] : _client->request.headers.getHeaders()) {
-        std::string envVarKey = "HTTP_" + headerKey;
-        std::replace(envVarKey.begin(), envVarKey.end(), '-', '_');
-        std::transform(envVarKey.begin(), envVarKey.end(), envVarKey.begin(), ::toupper);
-        _environmentVariables[envVarKey] = headerValue;
-    }
+        append_environment_variable(_environment, "CONTENT_LENGTH", contentLength);
+
+    _client->request.headers.forEach([this](std::string_view headerKey, std::string_view headerValue) {
+        std::string &entry = _environment.emplace_back();
+        entry.reserve(5 + headerKey.size() + 1 + headerValue.size());
+        entry.append("HTTP_");
+        for (char c : headerKey)
+            entry.push_back(c == '-' ? '_' : static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+        entry.append(1, '=').append(headerValue);
+    });
 }
 
-void CGIResponse::_createEnvironmentArray(std::vector<char*> &envPtrs, std::vector<std::string> &strBuff) const {
-    strBuff.clear();
+/// @brief Point envPtrs at the entries of the environment, terminated by a null pointer as execve() expects.
+void CGIResponse::_createEnvironmentArray(std::vector<char*> &envPtrs) const {
     envPtrs.clear();
-
-    strBuff.reserve(_environmentVariables.size());
-    envPtrs.reserve(_environmentVariables.size() + 1);
-
-for (const auto &env : _environmentVariables) {
-        strBuff.push_back(env.first + "=" + env.second);
-        envPtrs.push_back(const_cast<char*>(strBuff.back().c_str()));
-    }
+    envPtrs.reserve(_environment.size() + 1);
+    for (const std::string &entry : _environment)
+        envPtrs.push_back(const_cast<char*>(entry.c_str()));
     envPtrs.push_back(nullptr);
 }
 
@@ -162,22 +187,30 @@ bool CGIResponse::start(const ServerConfig &config, const LocationRule &route, c
 
     _setupEnvironmentVariables(config, route, parsedUrl, serverExecutablePath);
 
+    if (route.fastcgiPass.isSet())
+        return (_startFastCGI(route));
+
+    // Close-on-exec: the CGI process only gets the ends that become its stdin and stdout, as copies
     int cin[2], cout[2];
-    if (pipe(cin) == -1) {
+    if (pipe2(cin, O_CLOEXEC) == -1) {
         ERROR("Failed to create pipes for CGI process: " << strerror(errno));
         return (false);
     }
 
-    if (pipe(cout) == -1) {
+    if (pipe2(cout, O_CLOEXEC) == -1) {
         ERROR("Failed to create pipes for CGI process: " << strerror(errno));
         close(cin[0]);
         close(cin[1]);
         return (false);
     }
 
-    _processId = fork();
-    if (_processId < 0) {
-        ERROR("Failed to fork CGI process for client: " << &_client);
+    std::string scriptDir = Path(parsedUrl.scriptPath).pop().str();
+    std::string scriptName = Path(parsedUrl.scriptPath).getFilename();
+    DEBUG("CGI script directory: " << scriptDir);
+
+    // A process of the pool was forked ahead of the request, only spawn one here when it ran dry
+    _processId = _server.getCGIPool().launch(scriptDir, scriptName, _environment, cin[0], cout[1]);
+    if (_processId == -1 && !_spawnCGIProcess(scriptDir, scriptName, cin[0], cout[1])) {
         close(cin[0]);
         close(cin[1]);
         close(cout[0]);
@@ -185,85 +218,268 @@ bool CGIResponse::start(const ServerConfig &config, const LocationRule &route, c
         return (false);
     }
 
-    if (_processId == 0) {
-        // Child process
+    // The server keeps the other ends of the pipes
+    _cgiOutputFD = ReadableFD::pipe(cout, CGI_OUTPUT_BUFFER_SIZE);
+    _cgiInputFD = WritableFD::pipe(cin);
 
-        Path scriptDir = Path(parsedUrl.scriptPath).pop();
-        DEBUG("CGI script directory: " << scriptDir.str());
-        if (chdir(scriptDir.str().c_str()) == -1) {
-            ERROR("Failed to change directory to CGI script path: " << parsedUrl.scriptPath << ", errno: " << errno << " (" << strerror(errno) << ")");
-            close(cin[0]);
-            close(cin[1]);
-            close(cout[0]);
-            close(cout[1]);
-            exit(EXIT_FAILURE);
-        }
+    if (_cgiInputFD.setNonBlocking() == -1 || _cgiOutputFD  .setNonBlocking() == -1) {
+        ERROR("Failed to set non-blocking mode for CGI pipes: " << strerror(errno));
+        _closeToCGIProcessFd();
+        _closeFromCGIProcessFd();
+        return (false);
+    }
 
-        FD childStdin = ReadableFD::pipe(cin);
-        FD childStdout = WritableFD::pipe(cout);
-        if (dup2(childStdin.get(), STDIN_FILENO) == -1 || dup2(childStdout.get(), STDOUT_FILENO) == -1) {
-            childStdin.close();
-            childStdout.close();
-            ERROR("Failed to redirect stdin/stdout for CGI process: " << strerror(errno));
-            exit(EXIT_FAILURE);
-        }
+    if (_cgiInputFD.connectToEpoll(_server.getEpollFd(), DEFAULT_EPOLLOUT_EVENTS) == -1 ||
+        _cgiOutputFD.connectToEpoll(_server.getEpollFd(), DEFAULT_EPOLLIN_EVENTS) == -1) {
+        ERROR("Failed to connect CGI pipes to epoll: " << strerror(errno));
+        _closeToCGIProcessFd();
+        _closeFromCGIProcessFd();
+        return (false);
+    }
+
+    _armTimeout(route);
+
+    _server.trackCallbackFD(_cgiInputFD, [this](WritableFD &fd, short revents) {
+        _handleCGIInputPipeEvent(fd, revents);
+    });
+    _server.trackCallbackFD(_cgiOutputFD, [this](ReadableFD &fd, short revents) {
+        _handleCGIOutputPipeEvent(fd, revents);
+    });
+
+    // _server.trackCGIResponse(this);
+    DEBUG("CGI process started with PID: " << _processId << ", cgiInputFD: " << _cgiInputFD.get() << ", cgiOutputFD: " << _cgiOutputFD.get());
+
+    return (true);
+}
+
+/// @brief Start the script in its directory, reading stdinFd and writing stdoutFd.
+/// @details posix_spawn() runs the child on the server's memory until it executes the script
+/// (clone with CLONE_VM | CLONE_VFORK), where fork() would copy the page tables of the whole
+/// server first. The redirections and the directory change are file actions, done in the child.
+/// The child starts without the signals the event loop blocks outside of its wait.
+bool CGIResponse::_spawnCGIProcess(const std::string &directory, const std::string &program, int stdinFd, int stdoutFd) {
+    posix_spawn_file_actions_t actions;
+    int error = posix_spawn_file_actions_init(&actions);
+    if (error != 0) {
+        ERROR("Failed to set up CGI process: " << strerror(error));
+        return (false);
+    }
 
-        childStdin.close();
-        childStdout.close();
+    posix_spawnattr_t attributes;
+    error = posix_spawnattr_init(&attributes);
+    if (error != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        ERROR("Failed to set up CGI process: " << strerror(error));
+        return (false);
+    }
+
+    sigset_t noSignals;
+    sigemptyset(&noSignals);
+    error = posix_spawnattr_setsigmask(&attributes, &noSignals);
+    if (error == 0)
+        error = posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK);
 
-        std::string scriptName = Path(parsedUrl.scriptPath).getFilename();
-        char * const argv[] = {const_cast<char *>(scriptName.c_str()), nullptr};
+    if (error == 0)
+        error = posix_spawn_file_actions_adddup2(&actions, stdinFd, STDIN_FILENO);
+    if (error == 0)
+        error = posix_spawn_file_actions_adddup2(&actions, stdoutFd, STDOUT_FILENO);
+    if (error == 0)
+        error = posix_spawn_file_actions_addchdir_np(&actions, directory.c_str());
 
-        // Debug argv
+    if (error == 0) {
         std::vector<char*> envPtrs;
-        std::vector<std::string> strBuff;
-        _createEnvironmentArray(envPtrs, strBuff);
+        _createEnvironmentArray(envPtrs);
+        char * const argv[] = {const_cast<char *>(program.c_str()), nullptr};
+
+        // Closes still sitting in the submission queue would otherwise leak into the child
+        FD::flushSubmissionRing();
+        pid_t processId = -1;
+        error = posix_spawn(&processId, program.c_str(), &actions, &attributes, argv, envPtrs.data());
+        if (error == 0)
+            _processId = processId;
+    }
+
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error != 0) {
+        ERROR("Failed to execute CGI script: " << directory << "/" << program << ", errno: " << error << " (" << strerror(error) << ")");
+        return (false);
+    }
+    return (true);
+}
+
+/// @brief Pass the request to the location's FastCGI application instead of running the script.
+/// @details The application's output is fed into the same buffer the CGI output pipe would fill,
+/// so the response is put together and sent the same way.
+bool CGIResponse::_startFastCGI(const LocationRule &route) {
+    _fastCGIConnection = _server.getFastCGIPool().acquire(route.fastcgiPass);
+    if (_fastCGIConnection)
+        _fastCGIRequestId = _fastCGIConnection->beginRequest(*this, _environment);
+
+    if (_fastCGIRequestId == 0) {
+        ERROR("Failed to pass request to FastCGI application: " << route.fastcgiPass.getAddress());
+        _fastCGIConnection = nullptr;
+        _innerStatusCode = HttpStatusCode::BadGateway;
+        return (false);
+    }
+
+    _armTimeout(route);
+    DEBUG("Passed request to FastCGI application " << route.fastcgiPass.getAddress() << ", request ID: " << _fastCGIRequestId);
+    return (true);
+}
 
-        if (execve(scriptName.c_str(), argv, envPtrs.data()) == -1) {
-            ERROR("Failed to execute CGI script: " << parsedUrl.scriptPath << ", errno: " << errno << " (" << strerror(errno) << ")");
-            exit(EXIT_FAILURE);
+/// @brief Forward the request body in the socket buffer to the FastCGI application, as far as the connection takes it.
+void CGIResponse::_sendRequestBodyToFastCGI() {
+    while (_fastCGIConnection && !_isFastCGIStdinClosed && !_fastCGIConnection->isBacklogged()) {
+        if (_client->isFullRequestBodyReceived(socketFD)) {
+            // An empty record ends the body
+            _fastCGIConnection->sendStdin(_fastCGIRequestId, "");
+            _isFastCGIStdinClosed = true;
+            return ;
         }
-        exit(EXIT_SUCCESS);
-    } else {
-        // Parent process
-        _cgiOutputFD = ReadableFD::pipe(cout);
-        _cgiInputFD = WritableFD::pipe(cin);
-
-        if (_cgiInputFD.setNonBlocking() == -1 || _cgiOutputFD  .setNonBlocking() == -1) {
-            ERROR("Failed to set non-blocking mode for CGI pipes: " << strerror(errno));
-            _closeToCGIProcessFd();
-            _closeFromCGIProcessFd();
-            return (false);
+
+        if (_client->request.receivingBodyMode == ReceivingBodyMode::Chunked) {
+            FDReader::HTTPChunk chunk = socketFD.extractHTTPChunkFromReadBuffer();
+            if (chunk.size == FDReader::HTTPChunk::noChunk)
+                return ;
+            if (!chunk.data.empty())
+                _fastCGIConnection->sendStdin(_fastCGIRequestId, chunk.data);
+            continue ;
         }
 
-        if (_cgiInputFD.connectToEpoll(_server.getEpollFd(), DEFAULT_EPOLLOUT_EVENTS) == -1 ||
-            _cgiOutputFD.connectToEpoll(_server.getEpollFd(), DEFAULT_EPOLLIN_EVENTS) == -1) {
-            ERROR("Failed to connect CGI pipes to epoll: " << strerror(errno));
-            _closeToCGIProcessFd();
-            _closeFromCGIProcessFd();
-            return (false);
+        // Bytes past the body belong to the next pipelined request
+        std::string_view data = socketFD.peekReadBuffer(std::min<size_t>(FASTCGI_MAX_CONTENT_LENGTH,
+            _client->request.getRemainingBodyLength(static_cast<size_t>(socketFD.getTotalBodyBytes()))));
+        if (data.empty())
+            return ;
+        _fastCGIConnection->sendStdin(_fastCGIRequestId, data);
+        socketFD.consumeReadBuffer(data.size());
+    }
+}
+
+bool CGIResponse::handleFastCGIOutput(std::string_view data) {
+    if (_cgiOutputFD.getReadBufferSize() + data.size() <= CGI_OUTPUT_BUFFER_SIZE) {
+        bool wasEmpty = _cgiOutputFD.getReadBufferSize() == 0;
+        _cgiOutputFD.appendToReadBuffer(data);
+
+        // The head goes out as soon as it's complete, not once the application ended the request
+        if (_transferMode == CGIResponseTransferMode::Unknown && _cgiOutputFD.hasHeadersInReadBuffer()) {
+            if (_prepareCGIResponse() != HttpStatusCode::OK) return (true);
+            _isGamblingResponseWillWork = true;
+            wasEmpty = true;
         }
 
-        _timerId = _server.getTimer().addEvent(std::chrono::milliseconds(static_cast<int>(route.cgiTimeout.timeout.getSeconds() * 1000.0)), [this]() {
-            _handleTimeout();
-        });
+        // The socket stopped waiting for writability once it sent everything, see _waitForCGIOutput()
+        if (wasEmpty && _transferMode != CGIResponseTransferMode::Unknown)
+            _client->setEpollWriteNotification(socketFD);
+        return (true);
+    }
+
+    // Like a full output pipe, the head has to be in the buffer by now
+    if (_transferMode == CGIResponseTransferMode::Unknown) {
+        // The error response replaced this one, there is nothing left to take the output
+        if (_prepareCGIResponse() != HttpStatusCode::OK) return (true);
+        _isGamblingResponseWillWork = true;
+        _client->setEpollWriteNotification(socketFD);
+    }
+    return (false);
+}
+
+void CGIResponse::handleFastCGIEnd(bool isComplete) {
+    _fastCGIConnection = nullptr;
+    _cgiOutputFD.setReaderFDState(FDState::Closed);
+
+    if (_transferMode == CGIResponseTransferMode::Unknown) {
+        if (!isComplete) {
+            DEBUG("FastCGI application did not complete the request");
+            _client->switchResponseToErrorResponse(HttpStatusCode::BadGateway, socketFD);
+            return ;
+        }
+        if (_prepareCGIResponse() != HttpStatusCode::OK) return ;
+    }
 
-        _server.trackCallbackFD(_cgiInputFD, [this](WritableFD &fd, short revents) {
-            _handleCGIInputPipeEvent(fd, revents);
-        });
-        _server.trackCallbackFD(_cgiOutputFD, [this](ReadableFD &fd, short revents) {
-            _handleCGIOutputPipeEvent(fd, revents);
-        });
+    _client->setEpollWriteNotification(socketFD);
+}
+
+void CGIResponse::handleFastCGIWritable() {
+    _sendRequestBodyToFastCGI();
+}
+
+/// @brief Whether the request body goes from the socket into the CGI input pipe without being read by the server.
+/// @details Only bodies of known length, and only once the bytes read along with the head went the copying way.
+bool CGIResponse::isReadingSocketDirectly() const {
+    return (!_isRequestBodySpliceDisabled && _cgiInputFD.isValidFd() && !_fastCGIConnection
+        && _client->request.receivingBodyMode == ReceivingBodyMode::ContentLength
+        && static_cast<size_t>(socketFD.getTotalBodyBytes()) < _client->request.contentLength
+        && socketFD.getReadBufferSize() == 0 && _pipeWriter.isEmpty());
+}
+
+/// @brief Move the request body from the socket into the CGI input pipe with splice(), until either side blocks.
+/// @return false if the client could not be waited on anymore, and this response is gone.
+bool CGIResponse::_spliceRequestBody() {
+    bool hasSpliced = false;
+    while (isReadingSocketDirectly()) {
+        size_t remaining = _client->request.getRemainingBodyLength(static_cast<size_t>(socketFD.getTotalBodyBytes()));
+        ssize_t moved = splice(socketFD.get(), nullptr, _cgiInputFD.get(), nullptr,
+            std::min<size_t>(remaining, CGI_SPLICE_SIZE), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+        if (moved > 0) {
+            socketFD.countBypassedBodyBytes(static_cast<size_t>(moved));
+            hasSpliced = true;
+            continue ;
+        }
+
+        if (moved == -1 && errno == EINTR)
+            continue ;
+
+        if (moved == -1 && errno == EAGAIN) {
+            // Either the socket has nothing left or the pipe is full, only the one that blocked is waited on
+            int pending = 0;
+            return (_awaitRequestBody(ioctl(socketFD.get(), FIONREAD, &pending) == -1 || pending == 0));
+        }
 
-        // _server.trackCGIResponse(this);
-        DEBUG("CGI process started with PID: " << _processId << ", cgiInputFD: " << _cgiInputFD.get() << ", cgiOutputFD: " << _cgiOutputFD.get());
+        if (moved == 0) {
+            // Reading the end of the stream the usual way closes the connection
+            DEBUG("Client closed the connection while the request body was spliced, fd: " << socketFD.get());
+        } else {
+            DEBUG("Can't splice request body (" << strerror(errno) << "), copying it instead");
+        }
+        _isRequestBodySpliceDisabled = true;
+        if (_cgiInputFD.setEpollEvents(DEFAULT_EPOLLOUT_EVENTS) == -1)
+            ERROR("Failed to set EPOLLOUT for CGI input pipe: " << _cgiInputFD.get());
+        return (_awaitRequestBody(true));
     }
 
+    // The last bytes are in the pipe, the script gets its end of file and the socket is read again for the requests behind this one
+    if (hasSpliced && _client->isFullRequestBodyReceived(socketFD)) {
+        DEBUG("Full request body spliced, closing CGI input pipe");
+        _closeToCGIProcessFd();
+        return (_awaitRequestBody(true));
+    }
     return (true);
 }
 
+/// @brief Wait on the side that held up the request body splice: the socket for more of it, or the pipe for room.
+/// @details Both are level-triggered, so the side that isn't blocking is left out or it reports on every loop.
+bool CGIResponse::_awaitRequestBody(bool isWaitingForSocket) {
+    if (_cgiInputFD.isValidFd() && !_isRequestBodySpliceDisabled
+        && _cgiInputFD.setEpollEvents(isWaitingForSocket ? 0u : static_cast<uint32_t>(DEFAULT_EPOLLOUT_EVENTS)) == -1)
+        ERROR("Failed to update epoll events for CGI input pipe: " << _cgiInputFD.get());
+
+    _client->setReadingPaused(!isWaitingForSocket);
+    if (_transferMode != CGIResponseTransferMode::Unknown)
+        return (_client->setEpollWriteNotification(socketFD));
+    return (_client->unsetEpollWriteNotification(socketFD));
+}
+
 void CGIResponse::_handleCGIInputPipeEvent(WritableFD &fd, short revents) {
-    if (revents & EPOLLOUT) {
+    if ((revents & EPOLLOUT) && isReadingSocketDirectly()) {
+        DEBUG("CGI input pipe is ready for splicing, fd: " << fd.get());
+        if (!_spliceRequestBody())
+            return ;
+    }
+
+    else if (revents & EPOLLOUT) {
         DEBUG("CGI input pipe is ready for writing, fd: " << fd.get());
 
         if (!_pipeWriter.isEmpty()) {
@@ -271,6 +487,7 @@ void CGIResponse::_handleCGIInputPipeEvent(WritableFD &fd, short revents) {
         } else {
             switch (_client->request.receivingBodyMode) {
                 case ReceivingBodyMode::Chunked: {
+                    if (socketFD.isFinalChunkRead()) break ;
                     FDReader::HTTPChunk chunk = socketFD.extractHTTPChunkFromReadBuffer();
                     if (chunk.size == FDReader::HTTPChunk::noChunk) break ;
                     if (chunk.size == 0) {
@@ -286,7 +503,9 @@ void CGIResponse::_handleCGIInputPipeEvent(WritableFD &fd, short revents) {
 
                 case ReceivingBodyMode::ContentLength:
                 case ReceivingBodyMode::NotSet: {
-                    _pipeWriter.sendBodyAsString(socketFD, fd);
+                    // Bytes past the body belong to the next pipelined request, not to the script
+                    _pipeWriter.sendBodyAsString(socketFD, fd,
+                        _client->request.getRemainingBodyLength(static_cast<size_t>(socketFD.getTotalBodyBytes())));
                     DEBUG("Sent request body to CGI process, size: " << socketFD.getReadBufferSize());
                     break ;
                 }
@@ -304,35 +523,49 @@ void CGIResponse::_handleCGIInputPipeEvent(WritableFD &fd, short revents) {
     if (revents & (EPOLLHUP | EPOLLERR)) {
         DEBUG("CGI input pipe closed");
         _closeToCGIProcessFd();
+        // Reading may have been paused for room in the pipe that will never come
+        if (!_client->isFullRequestBodyReceived(socketFD) && !_awaitRequestBody(true))
+            return ;
     }
 
-    if (_client->isFullRequestBodyReceived(socketFD) && socketFD.getReadBufferSize() == 0) {
+    // The socket buffer may already hold the next pipelined request, so only the body's own bytes count
+    if (_client->isFullRequestBodyReceived(socketFD) && _pipeWriter.isEmpty()) {
         DEBUG("Full request body received, closing CGI input pipe");
         _closeToCGIProcessFd();
     }
 }
 
 void CGIResponse::_handleCGIOutputPipeEvent(ReadableFD &fd, short revents) {
-    if (revents & EPOLLIN) {
-        DEBUG("CGI output pipe is ready for reading, fd: " << fd.get());
+    // The socket takes the output straight from the pipe once the buffer is sent, so it waits for the socket instead
+    if (_isSplicingCGIOutput())
+        return (_pauseCGIOutput(revents));
 
-        if (fd.wouldReadExceedMaxBufferSize()) {
-            if (_transferMode == CGIResponseTransferMode::Unknown) {
-                if (_prepareCGIResponse() != HttpStatusCode::OK) return ;
-                _isGamblingResponseWillWork = true;
-            }
-        } else {
-            fd.read();
+    if (fd.wouldReadExceedMaxBufferSize()) {
+        if (_transferMode == CGIResponseTransferMode::Unknown) {
+            if (_prepareCGIResponse() != HttpStatusCode::OK) return ;
+            _isGamblingResponseWillWork = true;
         }
+
+        // The socket didn't take what was read so far, reading on would only pile it up
+        DEBUG("CGI output buffer full, pausing reads from fd: " << fd.get());
+        return (_pauseCGIOutput(revents));
     }
 
-    if (revents & (EPOLLHUP | EPOLLERR)) {
+    DEBUG("CGI output pipe is ready for reading, fd: " << fd.get());
+    ssize_t bytesRead = fd.read();
+    // Output can still be in the pipe after the script closed its end, it's only done at end of file
+    bool isEndOfOutput = bytesRead == 0 || (bytesRead < 0 && (revents & EPOLLERR));
+
+    // The head goes out as soon as it's complete, unless the script is done already and its exit status can still decide
+    if (_transferMode == CGIResponseTransferMode::Unknown
+        && (isEndOfOutput || (!(revents & EPOLLHUP) && fd.hasHeadersInReadBuffer()))) {
+        if (_prepareCGIResponse() != HttpStatusCode::OK) return ;
+        _isGamblingResponseWillWork = !isEndOfOutput;
+    }
+
+    if (isEndOfOutput) {
         DEBUG("CGI output pipe closed");
         _closeFromCGIProcessFd();
-
-        if (_transferMode == CGIResponseTransferMode::Unknown) {
-            if (_prepareCGIResponse() != HttpStatusCode::OK) return ;
-        }
     }
 
     if (_transferMode != CGIResponseTransferMode::Unknown
@@ -340,6 +573,35 @@ void CGIResponse::_handleCGIOutputPipeEvent(ReadableFD &fd, short revents) {
         return ;
 }
 
+/// @brief Stop reading the CGI output pipe until the socket made room for more, see _resumeCGIOutput().
+/// @details A pipe the script closed keeps reporting EPOLLHUP whatever its events, so it leaves epoll instead.
+void CGIResponse::_pauseCGIOutput(short revents) {
+    if (revents & (EPOLLHUP | EPOLLERR))
+        _cgiOutputFD.disconnectFromEpoll();
+    else if (_cgiOutputFD.setEpollEvents(0) == -1)
+        ERROR("Failed to update epoll events for CGI output pipe: " << _cgiOutputFD.get());
+
+    _isCGIOutputPaused = true;
+    _client->setEpollWriteNotification(socketFD);
+}
+
+void CGIResponse::_resumeCGIOutput() {
+    if (!_isCGIOutputPaused || !_cgiOutputFD.isValidFd())
+        return ;
+
+    _isCGIOutputPaused = false;
+    if ((_cgiOutputFD.isConnectedToEpoll() ? _cgiOutputFD.setEpollEvents(DEFAULT_EPOLLIN_EVENTS)
+        : _cgiOutputFD.connectToEpoll(_server.getEpollFd(), DEFAULT_EPOLLIN_EVENTS)) == -1)
+        ERROR("Failed to set EPOLLIN for CGI output pipe: " << _cgiOutputFD.get());
+}
+
+/// @brief Nothing is left to send until the script writes more, the socket stops reporting it's writable until then.
+void CGIResponse::_waitForCGIOutput(SocketFD &fd) {
+    if (_cgiOutputFD.getReaderFDState() != FDState::Closed && _cgiOutputFD.getReadBufferSize() == 0
+        && _bodyWriter.isEmpty() && !_isCGIOutputPaused)
+        _client->unsetEpollWriteNotification(fd);
+}
+
 HttpStatusCode CGIResponse::_prepareCGIResponse() {
     std::string cgiHeaderString = _cgiOutputFD.extractHeadersFromReadBuffer();
     DEBUG_ESC("Headers gotten: " << cgiHeaderString);
@@ -352,17 +614,30 @@ HttpStatusCode CGIResponse::_prepareCGIResponse() {
     Headers cgiHeaders(cgiHeaderStream);
     headers.merge(cgiHeaders);
 
-    try {
-        int code = std::stoi(headers.getAndRemoveHeader(HeaderKey::Status, "l"));
-        if (code < 100 || code > 599) {
-            return (HttpStatusCode::InternalServerError);
-        }
-        setStatusCode(static_cast<HttpStatusCode>(code));
-        if (code / 100 != 2)
-            return (static_cast<HttpStatusCode>(code));
-    } catch (...) {
+    // Without a Status header the script's output is a 200 response (RFC 3875, 6.3.3), as FastCGI
+    // applications like PHP-FPM send it, any other status is passed on along with the body
+    std::string status = headers.getAndRemoveHeader(HeaderKey::Status, "200");
+    int code = 0;
+    std::from_chars(status.data(), status.data() + status.size(), code);
+    if (code < 100 || code > 599) {
+        _client->switchResponseToErrorResponse(HttpStatusCode::InternalServerError, socketFD);
         return (HttpStatusCode::InternalServerError);
     }
+    setStatusCode(static_cast<HttpStatusCode>(code));
+
+    // A Content-Length that isn't a plain number can't frame the body, it's sent chunked instead
+    std::string contentLength(headers.getHeader(HeaderKey::ContentLength, ""));
+    ssize_t declaredLength = -1;
+    if (!contentLength.empty()) {
+        auto [end, error] = std::from_chars(contentLength.data(), contentLength.data() + contentLength.size(), declaredLength);
+        if (error != std::errc() || end != contentLength.data() + contentLength.size() || declaredLength < 0) {
+            headers.remove(HeaderKey::ContentLength);
+            declaredLength = -1;
+        }
+    }
+
+    if (_setupCompression(declaredLength))
+        headers.replace(HeaderKey::TransferEncoding, "chunked");
 
     if (headers.getHeader(HeaderKey::ContentLength, "").empty()
         || headers.getHeader(HeaderKey::TransferEncoding, "") == "chunked") {
@@ -373,6 +648,7 @@ HttpStatusCode CGIResponse::_prepareCGIResponse() {
 
     else {
         _transferMode = CGIResponseTransferMode::FullBuffer;
+        _responseLength = declaredLength;
     }
 
     return (HttpStatusCode::OK);
@@ -389,6 +665,8 @@ void CGIResponse::tick() {
 void CGIResponse::handleRequestBody(SocketFD &fd, const Request &request) {
     (void) fd;
     (void) request;
+    _sendRequestBodyToFastCGI();
+    _spliceRequestBody();
 }
 
 void CGIResponse::handleSocketWriteTick(SocketFD &fd) {
@@ -396,35 +674,60 @@ void CGIResponse::handleSocketWriteTick(SocketFD &fd) {
         return ;
     DEBUG("CGIResponse handleSocketWriteTick for client: " << _client << ", fd: " << fd.get());
 
-    if (_processId != -1 && !_isGamblingResponseWillWork) {
-        int status;
-        if (waitpid(_processId, &status, WNOHANG) == -1) {
+    // Output the buffer had no room for is delivered again once this tick made some
+    if (_fastCGIConnection)
+        _fastCGIConnection->resume(_fastCGIRequestId);
+    if (!_cgiOutputFD.wouldReadExceedMaxBufferSize() && !_isSplicingCGIOutput())
+        _resumeCGIOutput();
+
+    if (_processId != -1) {
+        int status = 0;
+        pid_t result = waitpid(_processId, &status, WNOHANG);
+        if (result == -1 && !_isGamblingResponseWillWork) {
             DEBUG("CGI process not yet finished, waiting for it to complete");
             return ;
         }
-        PRINT("Return thingy code" << WEXITSTATUS(status));
 
-        if (WEXITSTATUS(status) != 0) {
-            ERROR("CGI process exited with error, status: " << WEXITSTATUS(status));
-            _client->switchResponseToErrorResponse(HttpStatusCode::InternalServerError, socketFD);
-            return ;
-        }
+        // A result of 0 means the process is still running, status is only filled in once it exited
+        if (result == _processId) {
+            PRINT("Return thingy code" << WEXITSTATUS(status));
 
-        _processId = -1;
+            // Once the head went out ahead of the script finishing, its exit status can't change the response anymore
+            if (WEXITSTATUS(status) != 0 && !_isGamblingResponseWillWork) {
+                ERROR("CGI process exited with error, status: " << WEXITSTATUS(status));
+                _client->switchResponseToErrorResponse(HttpStatusCode::InternalServerError, socketFD);
+                return ;
+            }
+
+            _processId = -1;
+        }
     }
 
+    // Queued only, the first body bytes of this same tick take the head along
     if (!headersBeenSent())
-        return (sendHeaders(fd));
+        sendHeaders();
 
     switch (_transferMode) {
         case CGIResponseTransferMode::Chunked: {
+            if (_encoder)
+                return (_sendEncodedCGIOutput(fd));
             if (_bodyWriter.sendBodyAsHTTPChunk(_cgiOutputFD, fd) != 0)
                 return ;
             break ;
         }
 
         case CGIResponseTransferMode::FullBuffer: {
-            if (_bodyWriter.sendBodyAsString(_cgiOutputFD, fd) != 0)
+            if (_endOutputOfWrongLength())
+                break ;
+
+            // What was read before the head could be parsed goes out first
+            if (_isSplicingCGIOutput() && _cgiOutputFD.getReadBufferSize() == 0 && _bodyWriter.isEmpty())
+                return (_spliceCGIOutput(fd));
+
+            size_t buffered = _cgiOutputFD.getReadBufferSize();
+            ssize_t result = _bodyWriter.sendBodyAsString(_cgiOutputFD, fd, static_cast<size_t>(_responseLength - _sendBytesTracker));
+            _sendBytesTracker += static_cast<ssize_t>(buffered - _cgiOutputFD.getReadBufferSize());
+            if (result != 0)
                 return ;
             break ;
         }
@@ -435,7 +738,7 @@ void CGIResponse::handleSocketWriteTick(SocketFD &fd) {
         }
     }
 
-    if (!_bodyWriter.isEmpty())
+    if (_bodyWriter.isStalled())
         return (_bodyWriter.tick(fd), void());
 
     if (_cgiOutputFD.getReaderFDState() == FDState::Closed && _cgiOutputFD.getReadBufferSize() == 0) {
@@ -447,6 +750,96 @@ void CGIResponse::handleSocketWriteTick(SocketFD &fd) {
             return ;
         }
     }
+
+    _waitForCGIOutput(fd);
+}
+
+/// @brief Whether the rest of the output goes from the CGI output pipe to the socket without being read by the server.
+/// @details Only output of known length sent as is, the pipe isn't read into the buffer anymore from then on.
+/// Once the declared length went out, the pipe is read again to find out whether the script wrote more.
+bool CGIResponse::_isSplicingCGIOutput() const {
+    return (!_isOutputSpliceDisabled && _transferMode == CGIResponseTransferMode::FullBuffer && !_encoder
+        && _cgiOutputFD.isValidFd() && _sendBytesTracker < _responseLength);
+}
+
+/// @brief Move output from the CGI output pipe to the socket with splice(), as much as the socket takes in one go.
+/// @details Never more than what is left of the declared Content-Length, anything beyond it stays in the pipe.
+void CGIResponse::_spliceCGIOutput(SocketFD &fd) {
+    size_t left = static_cast<size_t>(_responseLength - _sendBytesTracker);
+    ssize_t moved = splice(_cgiOutputFD.get(), nullptr, fd.get(), nullptr,
+        std::min<size_t>(left, CGI_SPLICE_SIZE), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (moved > 0) {
+        _bodyWriter.amountOfBytesWritten += moved;
+        _sendBytesTracker += moved;
+        return ;
+    }
+
+    if (moved == 0) {
+        DEBUG("CGI output pipe closed, all output spliced");
+        return (_closeFromCGIProcessFd());
+    }
+
+    if (errno == EINTR)
+        return ;
+
+    if (errno == EAGAIN) {
+        // An empty pipe is waited on until the script writes again, a full socket keeps the write notification
+        int pending = 0;
+        if (ioctl(_cgiOutputFD.get(), FIONREAD, &pending) == -1 || pending > 0)
+            return ;
+    } else {
+        DEBUG("Can't splice CGI output (" << strerror(errno) << "), copying it instead");
+        _isOutputSpliceDisabled = true;
+    }
+
+    // The pipe reports the next output, or that the script closed its end, to the copying way
+    _resumeCGIOutput();
+    _client->unsetEpollWriteNotification(fd);
+}
+
+/// @brief End a response whose script wrote more or less output than its Content-Length announced.
+/// @details The head is out already, so the client can only tell from the connection closing after
+/// the declared length (or what there was of it). Output beyond the declared length is dropped.
+/// @return Whether the response was ended.
+bool CGIResponse::_endOutputOfWrongLength() {
+    bool isOverrun = _sendBytesTracker >= _responseLength && _cgiOutputFD.getReadBufferSize() > 0;
+    bool isUnderrun = _sendBytesTracker < _responseLength
+        && _cgiOutputFD.getReaderFDState() == FDState::Closed && _cgiOutputFD.getReadBufferSize() == 0;
+    if (!isOverrun && !isUnderrun)
+        return (false);
+
+    ERROR("CGI output " << (isOverrun ? "exceeded" : "ended " + std::to_string(_responseLength - _sendBytesTracker) + " bytes before")
+        << " its Content-Length of " << _responseLength << ", closing the connection after the response");
+    if (_request)
+        _request->headers.replace(HeaderKey::Connection, "close");
+    _cgiOutputFD.consumeReadBuffer(_cgiOutputFD.getReadBufferSize());
+    _closeFromCGIProcessFd();
+    _responseLength = _sendBytesTracker;
+    return (true);
+}
+
+/// @brief Compress whatever the CGI process wrote so far and send it as a chunk.
+/// @details Every chunk is flushed, so output the script streams reaches the client right away.
+void CGIResponse::_sendEncodedCGIOutput(SocketFD &fd) {
+    if (_bodyWriter.isStalled() || _hasSentFinalChunk)
+        return (_bodyWriter.tick(fd), void());
+
+    std::string_view data = _cgiOutputFD.peekReadBuffer(DEFAULT_CHUNK_SIZE);
+    bool isLast = _cgiOutputFD.getReaderFDState() == FDState::Closed && data.size() == _cgiOutputFD.getReadBufferSize();
+    if (data.empty() && !isLast) {
+        _bodyWriter.tick(fd);
+        return (_waitForCGIOutput(fd));
+    }
+
+    if (!_sendEncodedChunk(fd, data, isLast ? EncoderFlush::Finish : EncoderFlush::Sync)) {
+        _closeFromCGIProcessFd();
+        _cgiOutputFD.clearReadBuffer();
+        _hasSentFinalChunk = true;
+        return ;
+    }
+
+    _cgiOutputFD.consumeReadBuffer(data.size());
+    _hasSentFinalChunk = isLast;
 }
 
 void CGIResponse::terminateResponse() {
@@ -457,13 +850,26 @@ void CGIResponse::terminateResponse() {
         _timerId = -1;
     }
     if (_processId != -1) {
+        // Reaped right away, a killed script exits without blocking and would otherwise stay a zombie
         kill(_processId, SIGKILL);
+        waitpid(_processId, nullptr, 0);
         _processId = -1;
     }
+    if (_fastCGIConnection) {
+        _fastCGIConnection->abortRequest(_fastCGIRequestId);
+        _fastCGIConnection = nullptr;
+    }
+}
+
+void CGIResponse::_armTimeout(const LocationRule &route) {
+    _timerId = _server.getTimer().addEvent(std::chrono::milliseconds(static_cast<int>(route.cgiTimeout.timeout.getSeconds() * 1000.0)), [this]() {
+        _handleTimeout();
+    });
 }
 
 void CGIResponse::_handleTimeout() {
     DEBUG("CGIResponse timeout handler called for client: " << _client);
+    _timerId = -1;
     _client->switchResponseToErrorResponse(HttpStatusCode::RequestTimeout, socketFD);
 }
 
@@ -1,8 +1,11 @@
 #include "Utils.hpp"
 
+#include <unordered_map>
 #include <algorithm>
 #include <sstream>
+#include <cstring>
 #include <string>
+#include <ctime>
 
 namespace Utils {
     std::string trim(const std::string& str) {
@@ -37,4 +40,54 @@ namespace Utils {
         return tokens;
     }
 
+    /// @brief Guess the media type of a file from its extension, for the Content-Type header.
+    /// @return The media type, or application/octet-stream if the extension is unknown.
+    const char *getMimeType(const std::string& path) {
+        static const std::unordered_map<std::string, const char *> mimeTypes = {
+            {"html", "text/html"}, {"htm", "text/html"}, {"css", "text/css"}, {"txt", "text/plain"},
+            {"js", "text/javascript"}, {"mjs", "text/javascript"}, {"json", "application/json"},
+            {"xml", "application/xml"}, {"csv", "text/csv"}, {"md", "text/markdown"},
+            {"png", "image/png"}, {"jpg", "image/jpeg"}, {"jpeg", "image/jpeg"}, {"gif", "image/gif"},
+            {"svg", "image/svg+xml"}, {"ico", "image/x-icon"}, {"webp", "image/webp"}, {"avif", "image/avif"},
+            {"woff", "font/woff"}, {"woff2", "font/woff2"}, {"ttf", "font/ttf"}, {"otf", "font/otf"},
+            {"mp3", "audio/mpeg"}, {"ogg", "audio/ogg"}, {"wav", "audio/wav"},
+            {"mp4", "video/mp4"}, {"webm", "video/webm"},
+            {"pdf", "application/pdf"}, {"zip", "application/zip"}, {"gz", "application/gzip"},
+            {"wasm", "application/wasm"},
+        };
+
+        size_t dot = path.find_last_of("./");
+        if (dot == std::string::npos || path[dot] != '.')
+            return ("application/octet-stream");
+
+        std::string extension = path.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        auto it = mimeTypes.find(extension);
+        return (it != mimeTypes.end() ? it->second : "application/octet-stream");
+    }
+
+    /// @brief Format a point in time as an HTTP date (IMF-fixdate), e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+    std::string formatHttpDate(std::time_t time) {
+        char buffer[64];
+        std::tm tm;
+        gmtime_r(&time, &tm);
+        size_t length = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        return std::string(buffer, length);
+    }
+
+    /// @brief Parse an HTTP date in the IMF-fixdate format that clients are required to send.
+    /// @return false if the value is not a valid date, which callers have to treat as absent.
+    bool parseHttpDate(const std::string& value, std::time_t &time) {
+        std::tm tm;
+        std::memset(&tm, 0, sizeof(tm));
+        const char *end = strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        if (!end || *end != '\0')
+            return false;
+
+        time = timegm(&tm);
+        return (time != static_cast<std::time_t>(-1));
+    }
+
 }
@@ -0,0 +1,89 @@
+#include "byteRange.hpp"
+#include "Utils.hpp"
+
+#include <strings.h>
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+/// @brief Parse a run of digits, rejecting anything else and values that don't fit an off_t.
+static bool parse_offset(const std::string &value, off_t &offset) {
+    if (value.empty())
+        return (false);
+
+    offset = 0;
+    for (char c : value) {
+        if (!std::isdigit(static_cast<unsigned char>(c)))
+            return (false);
+        if (offset > (std::numeric_limits<off_t>::max() - (c - '0')) / 10)
+            return (false);
+        offset = offset * 10 + (c - '0');
+    }
+    return (true);
+}
+
+std::string ByteRange::toContentRange(off_t size) const {
+    return ("bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(size));
+}
+
+static RangeRequest parse_ranges(const std::string &value, off_t size, std::vector<ByteRange> &ranges) {
+    size_t equals = value.find('=');
+    if (equals == std::string::npos || strcasecmp(Utils::trim(value.substr(0, equals)).c_str(), "bytes") != 0)
+        return (RangeRequest::Ignored);
+
+    std::vector<std::string> specs = Utils::split(value.substr(equals + 1), ',');
+    if (specs.size() > BYTE_RANGE_MAX_RANGES)
+        return (RangeRequest::Ignored);
+
+    bool hasRange = false;
+    for (const std::string &rawSpec : specs) {
+        std::string spec = Utils::trim(rawSpec);
+        if (spec.empty())
+            continue ;
+
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos)
+            return (RangeRequest::Ignored);
+        hasRange = true;
+
+        off_t first;
+        off_t last;
+        if (dash == 0) {
+            // Suffix range: the final `last` bytes of the file
+            if (!parse_offset(spec.substr(1), last))
+                return (RangeRequest::Ignored);
+            if (last == 0 || size == 0)
+                continue ;
+            ranges.push_back(ByteRange{size - std::min(last, size), size - 1});
+            continue ;
+        }
+
+        if (!parse_offset(spec.substr(0, dash), first))
+            return (RangeRequest::Ignored);
+        if (dash + 1 == spec.size())
+            last = size - 1;
+        else if (!parse_offset(spec.substr(dash + 1), last) || last < first)
+            return (RangeRequest::Ignored);
+
+        if (first >= size)
+            continue ;
+        ranges.push_back(ByteRange{first, std::min(last, size - 1)});
+    }
+
+    if (!hasRange)
+        return (RangeRequest::Ignored);
+    return (ranges.empty() ? RangeRequest::Unsatisfiable : RangeRequest::Satisfiable);
+}
+
+/// @brief Parse the value of a Range header against a file of `size` bytes.
+/// @details Ranges that start past the end of the file are dropped, the others are clamped to it.
+/// A header with invalid syntax, another unit or too many ranges is ignored as a whole.
+/// @param ranges Filled with the satisfiable ranges, in the order they were requested. Left empty
+/// unless the result is RangeRequest::Satisfiable, even if the syntax error came after valid ranges.
+RangeRequest ByteRange::parse(const std::string &value, off_t size, std::vector<ByteRange> &ranges) {
+    ranges.clear();
+    RangeRequest result = parse_ranges(value, size, ranges);
+    if (result != RangeRequest::Satisfiable)
+        ranges.clear();
+    return (result);
+}
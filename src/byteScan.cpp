@@ -0,0 +1,118 @@
+#include "byteScan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define BYTE_SCAN_X86
+#endif
+
+typedef size_t (*FindFunction)(std::string_view haystack, std::string_view needle, size_t from);
+
+static size_t find_scalar(std::string_view haystack, std::string_view needle, size_t from) {
+    return (haystack.find(needle, from));
+}
+
+#ifdef BYTE_SCAN_X86
+
+/// @brief Whether the needle, whose first and last byte already matched at `position`, matches in full.
+static bool matches_at(const char *position, std::string_view needle) {
+    for (size_t k = 1; k + 1 < needle.size(); ++k) {
+        if (position[k] != needle[k])
+            return (false);
+    }
+    return (true);
+}
+
+/// @brief Compare the first and last byte of `needle` against every position of one vector at once.
+/// @details Lane i of the first comparison checks haystack[i] against the first byte, lane i of the
+/// second one haystack[i + size - 1] against the last byte, so the set bits of their AND are the only
+/// positions a match can start at, and the bytes in between are only checked for those. Two loads per
+/// vector, whatever the needle length. The second load runs `size - 1` bytes ahead, which is where the
+/// loop has to stop before the end of the haystack.
+__attribute__((target("sse2")))
+static size_t find_sse2(std::string_view haystack, std::string_view needle, size_t from) {
+    constexpr size_t width = sizeof(__m128i);
+    const char *data = haystack.data();
+    const size_t last = needle.size() - 1;
+    const __m128i firstByte = _mm_set1_epi8(needle.front());
+    const __m128i lastByte = _mm_set1_epi8(needle.back());
+    size_t i = from;
+
+    for (; i + width + last <= haystack.size(); i += width) {
+        __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), firstByte);
+        __m128i end = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + last)), lastByte);
+
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_and_si128(first, end)));
+        while (mask != 0) {
+            size_t candidate = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (matches_at(data + candidate, needle))
+                return (candidate);
+            mask &= mask - 1;
+        }
+    }
+
+    return (find_scalar(haystack, needle, i));
+}
+
+__attribute__((target("avx2")))
+static size_t find_avx2(std::string_view haystack, std::string_view needle, size_t from) {
+    constexpr size_t width = sizeof(__m256i);
+    const char *data = haystack.data();
+    const size_t last = needle.size() - 1;
+    const __m256i firstByte = _mm256_set1_epi8(needle.front());
+    const __m256i lastByte = _mm256_set1_epi8(needle.back());
+    size_t i = from;
+
+    for (; i + width + last <= haystack.size(); i += width) {
+        __m256i first = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), firstByte);
+        __m256i end = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + last)), lastByte);
+
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_and_si256(first, end)));
+        while (mask != 0) {
+            size_t candidate = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (matches_at(data + candidate, needle))
+                return (candidate);
+            mask &= mask - 1;
+        }
+    }
+
+    // The tail is shorter than one AVX2 vector but may still fill an SSE2 one
+    return (find_sse2(haystack, needle, i));
+}
+
+#endif
+
+static FindFunction resolve_find() {
+#ifdef BYTE_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return (find_avx2);
+    if (__builtin_cpu_supports("sse2"))
+        return (find_sse2);
+#endif
+    return (find_scalar);
+}
+
+static FindFunction get_find() {
+    static const FindFunction find = resolve_find();
+    return (find);
+}
+
+/// @brief Find the first occurrence of `needle` in `haystack` at or after `from`.
+/// @return Its offset, or std::string_view::npos.
+size_t ByteScan::find(std::string_view haystack, std::string_view needle, size_t from) {
+    if (from > haystack.size() || needle.empty())
+        return (find_scalar(haystack, needle, from));
+    return (get_find()(haystack, needle, from));
+}
+
+/// @brief Name of the implementation picked for this CPU, for logging.
+const char *ByteScan::getImplementationName() {
+    FindFunction find = get_find();
+#ifdef BYTE_SCAN_X86
+    if (find == find_avx2)
+        return ("avx2");
+    if (find == find_sse2)
+        return ("sse2");
+#endif
+    return (find == find_scalar ? "scalar" : "unknown");
+}
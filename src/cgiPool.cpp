@@ -0,0 +1,355 @@
+#include "cgiPool.hpp"
+#include "server.hpp"
+#include "print.hpp"
+#include "fd.hpp"
+
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+#include <cstring>
+#include <chrono>
+
+CGIPool::CGIPool(Server &server) :
+    _server(server), _idle(), _maxIdle(0), _pendingSpawns(0), _timerId(-1), _zygotePid(-1), _zygoteFd() {}
+
+/// @brief Close every descriptor inherited from the server but the given one.
+/// @details Client sockets, epoll and the sockets of other pooled processes included, a process
+/// waiting around must not keep connections open.
+static void close_inherited_fds(int keptFd) {
+    if (keptFd > STDERR_FILENO + 1)
+        close_range(STDERR_FILENO + 1, keptFd - 1, 0);
+    close_range(keptFd + 1, ~0U, 0);
+}
+
+/// @brief Start the zygote, ask it for the idle processes and start the timer that replaces used ones.
+/// @param maxIdle The amount of processes kept waiting, 0 disables the pool.
+/// @param spawnRate The amount of processes created per second at most while refilling.
+void CGIPool::configure(size_t maxIdle, size_t spawnRate) {
+    _maxIdle = maxIdle;
+    if (_maxIdle == 0 || spawnRate == 0)
+        return ;
+
+    if (!_startZygote()) {
+        _maxIdle = 0;
+        return ;
+    }
+
+    // No request is waiting yet, so the pool is filled at once
+    while (_idle.size() + _pendingSpawns < _maxIdle && _requestSpawn())
+        ;
+
+    _timerId = _server.getTimer().addEvent(std::chrono::milliseconds(1000 / spawnRate), [this]() {
+        if (_zygotePid != -1 && _idle.size() + _pendingSpawns < _maxIdle)
+            _requestSpawn();
+    }, true);
+}
+
+/// @brief Fork the zygote and watch its socket for the processes it creates.
+bool CGIPool::_startZygote() {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) == -1) {
+        ERROR("Failed to create socket pair for CGI zygote: " << strerror(errno));
+        return (false);
+    }
+
+    // Closes still sitting in the submission queue would otherwise leak into the child
+    FD::flushSubmissionRing();
+    pid_t pid = fork();
+    if (pid == -1) {
+        ERROR("Failed to fork CGI zygote: " << strerror(errno));
+        ::close(sockets[0]);
+        ::close(sockets[1]);
+        return (false);
+    }
+
+    if (pid == 0) {
+        FD::useSubmissionRing(nullptr);
+        _runZygote(sockets[1]);
+    }
+
+    ::close(sockets[1]);
+    _zygotePid = pid;
+    _zygoteFd = ReadableFD(sockets[0], 0, FDState::OtherFunctionality);
+    if (_zygoteFd.connectToEpoll(_server.getEpollFd(), EPOLLIN) == -1) {
+        ERROR("Failed to connect CGI zygote to epoll: " << strerror(errno));
+        _stopZygote();
+        return (false);
+    }
+
+    _server.trackCallbackFD(_zygoteFd, [this](ReadableFD &, short revents) {
+        while (_receiveWorker(MSG_DONTWAIT))
+            ;
+        if (revents & (EPOLLHUP | EPOLLERR)) {
+            ERROR("CGI zygote exited, requests spawn their own CGI processes from now on");
+            _stopZygote();
+        }
+    });
+    DEBUG("Forked CGI zygote " << pid);
+    return (true);
+}
+
+/// @brief Let the zygote exit and wait for it, processes it still created are taken in as idle ones.
+void CGIPool::_stopZygote() {
+    if (_zygotePid == -1)
+        return ;
+
+    if (_zygoteFd.isConnectedToEpoll())
+        _server.untrackCallbackFD(_zygoteFd);
+    // The zygote answers what it was asked before it sees the end of the stream
+    shutdown(_zygoteFd, SHUT_WR);
+    while (_pendingSpawns > 0 && _receiveWorker(0))
+        ;
+    _zygoteFd.close();
+
+    if (waitpid(_zygotePid, nullptr, 0) == -1)
+        ERROR("Failed to wait for CGI zygote " << _zygotePid << ": " << strerror(errno));
+    _zygotePid = -1;
+    _pendingSpawns = 0;
+}
+
+/// @brief Ask the zygote for another process, it arrives through _receiveWorker().
+bool CGIPool::_requestSpawn() {
+    const char command = 's';
+    if (send(_zygoteFd, &command, sizeof(command), MSG_DONTWAIT | MSG_NOSIGNAL) != sizeof(command)) {
+        ERROR("Failed to ask CGI zygote for a process: " << strerror(errno));
+        return (false);
+    }
+    ++_pendingSpawns;
+    return (true);
+}
+
+/// @brief Take a process the zygote created in as an idle one.
+/// @return false once no answer is waiting, or the zygote is gone.
+bool CGIPool::_receiveWorker(int flags) {
+    pid_t pid = -1;
+    iovec data{&pid, sizeof(pid)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+
+    msghdr header{};
+    header.msg_iov = &data;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+
+    ssize_t received = recvmsg(_zygoteFd, &header, flags | MSG_CMSG_CLOEXEC);
+    if (received <= 0)
+        return (false);
+    if (_pendingSpawns > 0)
+        --_pendingSpawns;
+
+    int controlFd = -1;
+    cmsghdr *rights = CMSG_FIRSTHDR(&header);
+    if (rights && rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS
+        && rights->cmsg_len == CMSG_LEN(sizeof(int)))
+        std::memcpy(&controlFd, CMSG_DATA(rights), sizeof(controlFd));
+
+    if (received != sizeof(pid) || pid <= 0 || controlFd == -1) {
+        ERROR("CGI zygote failed to create a process for the pool");
+        if (controlFd != -1)
+            ::close(controlFd);
+        return (true);
+    }
+
+    _idle.push_back(Worker{pid, controlFd});
+    DEBUG("CGI zygote created process " << pid << " for the pool, " << _idle.size() << " idle");
+    return (true);
+}
+
+/// @brief Body of the zygote: create a pooled process whenever the server asks, until it closes its end.
+void CGIPool::_runZygote(int controlFd) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGQUIT, SIG_DFL);
+
+    // The server only takes these signals while waiting for events, scripts always do
+    sigset_t noSignals;
+    sigemptyset(&noSignals);
+    sigprocmask(SIG_SETMASK, &noSignals, nullptr);
+    close_inherited_fds(controlFd);
+
+    while (true) {
+        char command;
+        ssize_t received;
+        do {
+            received = recv(controlFd, &command, sizeof(command), 0);
+        } while (received == -1 && errno == EINTR);
+
+        // The server closed its end, it's shutting down
+        if (received <= 0)
+            _exit(EXIT_SUCCESS);
+
+        pid_t pid = -1;
+        int sockets[2] = {-1, -1};
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) == -1) {
+            ERROR("Failed to create socket pair for CGI process: " << strerror(errno));
+        } else {
+            // CLONE_PARENT makes the process a child of the server, which waits for it as for any CGI process
+            pid = static_cast<pid_t>(syscall(SYS_clone, CLONE_PARENT | SIGCHLD, nullptr, nullptr, nullptr, nullptr));
+            if (pid == 0)
+                _runWorker(sockets[1]);
+            ERROR_IF(pid == -1, "Failed to create CGI process for the pool: " << strerror(errno));
+            ::close(sockets[1]);
+        }
+
+        // The pid, and the server's end of the process's socket pair when it was created
+        iovec data{&pid, sizeof(pid)};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        msghdr header{};
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        if (pid > 0) {
+            header.msg_control = control;
+            header.msg_controllen = sizeof(control);
+            cmsghdr *rights = CMSG_FIRSTHDR(&header);
+            rights->cmsg_level = SOL_SOCKET;
+            rights->cmsg_type = SCM_RIGHTS;
+            rights->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(rights), &sockets[0], sizeof(int));
+        }
+
+        ssize_t sent = sendmsg(controlFd, &header, MSG_NOSIGNAL);
+        if (sockets[0] != -1)
+            ::close(sockets[0]);
+        if (sent == -1)
+            _exit(EXIT_SUCCESS);
+    }
+}
+
+/// @brief Body of a pooled process: wait for a request, then become its CGI process.
+/// @details Signal dispositions come from the zygote, the descriptors it had are closed first.
+void CGIPool::_runWorker(int controlFd) {
+    close_inherited_fds(controlFd);
+
+    std::vector<char> message(CGI_POOL_MAX_MESSAGE_SIZE);
+    iovec data{message.data(), message.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 2)];
+
+    msghdr header{};
+    header.msg_iov = &data;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = recvmsg(controlFd, &header, 0);
+    } while (received == -1 && errno == EINTR);
+
+    // The server closed its end without a request, it's shutting down or retiring this process
+    if (received <= 0)
+        _exit(EXIT_SUCCESS);
+
+    cmsghdr *rights = CMSG_FIRSTHDR(&header);
+    if ((header.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) || !rights || rights->cmsg_level != SOL_SOCKET
+        || rights->cmsg_type != SCM_RIGHTS || rights->cmsg_len != CMSG_LEN(sizeof(int) * 2)
+        || message[received - 1] != '\0') {
+        ERROR("Malformed request handed to pooled CGI process");
+        _exit(EXIT_FAILURE);
+    }
+
+    int pipes[2];
+    std::memcpy(pipes, CMSG_DATA(rights), sizeof(pipes));
+    if (dup2(pipes[0], STDIN_FILENO) == -1 || dup2(pipes[1], STDOUT_FILENO) == -1) {
+        ERROR("Failed to redirect stdin/stdout for CGI process: " << strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
+    ::close(pipes[0]);
+    ::close(pipes[1]);
+    ::close(controlFd);
+
+    // The message holds the directory, the script and the environment, each terminated by a null byte
+    std::vector<char *> strings;
+    for (ssize_t offset = 0; offset < received; offset += std::strlen(message.data() + offset) + 1)
+        strings.push_back(message.data() + offset);
+    if (strings.size() < 2) {
+        ERROR("Malformed request handed to pooled CGI process");
+        _exit(EXIT_FAILURE);
+    }
+    strings.push_back(nullptr);
+
+    if (chdir(strings[0]) == -1) {
+        ERROR("Failed to change directory to CGI script path: " << strings[0] << ", errno: " << errno << " (" << strerror(errno) << ")");
+        _exit(EXIT_FAILURE);
+    }
+
+    char * const argv[] = {strings[1], nullptr};
+    execve(strings[1], argv, strings.data() + 2);
+    ERROR("Failed to execute CGI script: " << strings[1] << ", errno: " << errno << " (" << strerror(errno) << ")");
+    _exit(EXIT_FAILURE);
+}
+
+/// @brief Hand a request to an idle process, which executes the script in the given directory.
+/// @param stdinFd, stdoutFd The pipe ends that become the script's stdin and stdout, the caller keeps its copies.
+/// @return The pid of the CGI process, or -1 if the pool had none to hand it to.
+pid_t CGIPool::launch(const std::string &directory, const std::string &program,
+    const std::vector<std::string> &environment, int stdinFd, int stdoutFd)
+{
+    if (_idle.empty())
+        return (-1);
+
+    std::string message;
+    message.reserve(directory.size() + program.size() + 2);
+    message.append(directory).push_back('\0');
+    message.append(program).push_back('\0');
+    for (const std::string &variable : environment)
+        message.append(variable).push_back('\0');
+    if (message.size() > CGI_POOL_MAX_MESSAGE_SIZE)
+        return (-1);
+
+    while (!_idle.empty()) {
+        Worker worker = _idle.back();
+        _idle.pop_back();
+
+        int pipes[2] = {stdinFd, stdoutFd};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(pipes))] = {};
+        iovec data{message.data(), message.size()};
+
+        msghdr header{};
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+
+        cmsghdr *rights = CMSG_FIRSTHDR(&header);
+        rights->cmsg_level = SOL_SOCKET;
+        rights->cmsg_type = SCM_RIGHTS;
+        rights->cmsg_len = CMSG_LEN(sizeof(pipes));
+        std::memcpy(CMSG_DATA(rights), pipes, sizeof(pipes));
+
+        ssize_t sent = sendmsg(worker.controlFd, &header, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent == static_cast<ssize_t>(message.size())) {
+            // The message stays queued for the process, it reads it before seeing the socket closed
+            ::close(worker.controlFd);
+            DEBUG("Handed CGI request for " << program << " to pooled process " << worker.pid);
+            return (worker.pid);
+        }
+
+        ERROR("Failed to hand CGI request to pooled process " << worker.pid << ": " << strerror(errno));
+        _retire(worker);
+    }
+    return (-1);
+}
+
+/// @brief Close the socket of an idle process and wait for it, it exits once it sees the socket closed.
+void CGIPool::_retire(const Worker &worker) {
+    ::close(worker.controlFd);
+    if (waitpid(worker.pid, nullptr, 0) == -1)
+        ERROR("Failed to wait for pooled CGI process " << worker.pid << ": " << strerror(errno));
+}
+
+void CGIPool::clear() {
+    if (_timerId != -1) {
+        _server.getTimer().deleteEvent(_timerId);
+        _timerId = -1;
+    }
+
+    // Before the idle processes, the ones the zygote is still creating join them
+    _stopZygote();
+    for (const Worker &worker : _idle)
+        _retire(worker);
+    _idle.clear();
+    _maxIdle = 0;
+}
@@ -3,6 +3,7 @@
 #include "methods.hpp"
 #include "headers.hpp"
 #include "server.hpp"
+#include "Utils.hpp"
 #include "print.hpp"
 #include "fd.hpp"
 
@@ -56,15 +57,49 @@ static const std::string getDefaultBody(HttpStatusCode statusCode) {
     return (s);
 }
 
+/// @brief Evaluate the conditional headers of a GET against the current validators of a file.
+/// @details If-Modified-Since is only considered without If-None-Match, and ETags are compared weakly.
+static bool is_not_modified(const Request &request, const std::string &etag, std::time_t lastModified) {
+    std::string ifNoneMatch(request.headers.getHeader(HeaderKey::IfNoneMatch, ""));
+    if (!ifNoneMatch.empty()) {
+        for (const std::string &candidate : Utils::split(ifNoneMatch, ',')) {
+            std::string tag = Utils::trim(candidate);
+            if (tag.compare(0, 2, "W/") == 0)
+                tag.erase(0, 2);
+            if (tag == "*" || tag == etag)
+                return (true);
+        }
+        return (false);
+    }
+
+    std::time_t since;
+    return (Utils::parseHttpDate(std::string(request.headers.getHeader(HeaderKey::IfModifiedSince, "")), since) && lastModified <= since);
+}
+
+/// @brief Check if the Range header of a request applies, which If-Range limits to an unchanged file.
+/// @details If-Range takes either a strong ETag or the exact Last-Modified date of the file.
+static bool is_range_applicable(const Request &request, const std::string &etag, const OpenFile &file) {
+    std::string ifRange(request.headers.getHeader(HeaderKey::IfRange, ""));
+    if (ifRange.empty())
+        return (true);
+    if (ifRange.front() == '"')
+        return (ifRange == etag);
+
+    std::time_t date;
+    return (Utils::parseHttpDate(ifRange, date) && date == file.modificationTime.tv_sec);
+}
+
 Response *Client::_createErrorResponse(HttpStatusCode statusCode, const LocationRule &route, bool shouldCloseConnection) {
     DEBUG("Creating error response");
     std::string errorPage = route.errorPages.getErrorPage(StatusCode(static_cast<int>(statusCode)));
     Response *ret = nullptr;
 
     if (!errorPage.empty()) {
-        int fd = open(errorPage.c_str(), O_RDONLY);
-        if (fd != -1)
-            ret = _configureResponse(new FileResponse(this, ReadableFD::file(fd), &request), statusCode);
+        std::shared_ptr<const OpenFile> file = OpenFile::withDescriptor(errorPage, _server.getOpenFileCache().lookup(errorPage));
+        if (file->fd != -1) {
+            ret = _configureResponse(new FileResponse(this, file, &request), statusCode);
+            ret->headers.replace(HeaderKey::ContentType, Utils::getMimeType(errorPage));
+        }
     }
 
     if (!ret)
@@ -99,8 +134,9 @@ Response *Client::_createCGIResponse(SocketFD &fd, const ServerConfig &config, c
     CGIResponse *response = new CGIResponse(this, _server, fd, &request);
     _configureResponse(response, HttpStatusCode::OK);
     if (!response->start(config, route, Path(_server.getServerExecutablePath()))) {
+        HttpStatusCode statusCode = response->didResponseCreationFail() ? response->getFailedResponseStatusCode() : HttpStatusCode::InternalServerError;
         delete response;
-        return _createErrorResponse(HttpStatusCode::InternalServerError, route);
+        return _createErrorResponse(statusCode, route);
     }
     return (response);
 }
@@ -110,8 +146,15 @@ Client::Client(Server &server, int serverFd, const char *clientIP, int clientPor
     _serverFd(serverFd),
     _state(ClientHTTPState::WaitingForHeaders),
     _chunkedRequestBodyRead(false),
+    _pipeline(),
+    _parser(),
+    _isReadingPaused(false),
+    _timeoutEventId(-1),
+    _timeoutState(ClientHTTPState::SendingResponse),
+    _stateChangeTime(std::chrono::steady_clock::now()),
     _clientIP(std::string(clientIP)),
     _clientPort(std::to_string(clientPort)),
+    route(nullptr),
     response(nullptr),
     request() {}
 
@@ -122,17 +165,22 @@ bool Client::isFullRequestBodyReceived(SocketFD &fd) const {
         }
         case ReceivingBodyMode::ContentLength:
         default: {
-            return (fd.getTotalBodyBytes() - request.headerPartLength >= request.contentLength);
+            return (static_cast<size_t>(fd.getTotalBodyBytes()) >= request.contentLength);
         }
     }
 }
 
+/// @brief Whether the response takes the request body off the socket itself, so the server mustn't read it.
+bool Client::isReadingSocketDirectly() const {
+    return (_state == ClientHTTPState::ReadingBody && response && response->isReadingSocketDirectly());
+}
+
 Response *Client::_createResponseFromRequest(SocketFD &fd, Request &request) {
     DEBUG("Creating response from request for Client, fd: " << fd.get());
 
     ServerConfig &config = _server.loadRequestConfig(request, _serverFd);
     route = &config.getLocation(request.metadata.getRawUrl());
-    request.metadata.translateUrl(_server.getServerExecutablePath(), *route);
+    request.metadata.translateUrl(_server.getServerExecutablePath(), *route, _server.getOpenFileCache());
 
     DEBUG("Route found for request: " << *route);
     DEBUG("URL path: " << request.metadata.getPath().str());
@@ -140,7 +188,9 @@ Response *Client::_createResponseFromRequest(SocketFD &fd, Request &request) {
     if ((route->maxBodySize.isSet() && request.contentLength > route->maxBodySize.getMaxBodySize().get()))
         return _createErrorResponse(HttpStatusCode::PayloadTooLarge, *route);
 
-    if (route->cgi.isEnabled() || (!request.metadata.pathIsDirectory() && route->cgiExtension.isCGI(request.metadata.getPath())))
+    // A FastCGI application takes every request of its location, unless cgi_extension picks them
+    if (route->cgi.isEnabled() || (route->fastcgiPass.isSet() && !route->cgiExtension.isSet())
+        || (!request.metadata.pathIsDirectory() && route->cgiExtension.isCGI(request.metadata.getPath())))
         return _createCGIResponse(fd, config, *route);
 
     if (!route->methods.isAllowed(request.metadata.getMethod()))
@@ -158,23 +208,125 @@ Response *Client::_createResponseFromRequest(SocketFD &fd, Request &request) {
     if (request.metadata.pathIsDirectory())
         return _createDirectoryListingResponse(*route);
 
-    if (request.metadata.getMethod() != Method::GET)
+    // HEAD takes the same path as GET, the responses leave out the body when they are sent
+    if (request.metadata.getMethod() != Method::GET && request.metadata.getMethod() != Method::HEAD)
         return _createErrorResponse(HttpStatusCode::BadRequest, *route);
 
-    int fileFd = open(request.metadata.getPath().str().c_str(), O_RDONLY);
-    if (fileFd == -1)
+    const std::shared_ptr<const OpenFile> &file = request.metadata.getFile();
+    if (!file->exists)
         return _createErrorResponse(HttpStatusCode::NotFound, *route);
 
     if (request.metadata.getRawUrl() == "/directory") {
         return _configureResponse(new StaticResponse(this, "", &request), HttpStatusCode::OK);
     }
 
-    return (_configureResponse(new FileResponse(this, ReadableFD::file(fileFd), &request), HttpStatusCode::OK));
+    const std::string &path = request.metadata.getPath().str();
+    const char *contentType = Utils::getMimeType(path);
+    std::string acceptEncoding(request.headers.getHeader(HeaderKey::AcceptEncoding, ""));
+    const std::shared_ptr<const OpenFile> &precompressed = request.metadata.getPrecompressedFile();
+    bool isCompressible = Response::isCompressible(route, contentType, file->size);
+    bool isVarying = precompressed || isCompressible;
+
+    ContentEncoding encoding = ContentEncoding::Identity;
+    if (precompressed && ContentEncoder::getQuality(acceptEncoding, ContentEncoding::Gzip) > 0)
+        encoding = ContentEncoding::Gzip;
+    else if (isCompressible)
+        encoding = ContentEncoder::negotiate(acceptEncoding);
+
+    bool isPrecompressed = precompressed && encoding == ContentEncoding::Gzip;
+    std::string etag = ContentEncoder::getVariantETag(file->getETag(), encoding);
+    if (file->isRegular && is_not_modified(request, etag, file->modificationTime.tv_sec))
+        return (_createNotModifiedResponse(*route, *file, encoding, isVarying));
+
+    // Ranges address the bytes that are sent, so they only work when those are known up front
+    bool acceptsRanges = file->isRegular && (encoding == ContentEncoding::Identity || isPrecompressed);
+    std::vector<ByteRange> ranges;
+    // Range requests are only defined for GET, a HEAD always describes the full representation
+    if (acceptsRanges && request.metadata.getMethod() == Method::GET && is_range_applicable(request, etag, *file)) {
+        off_t size = isPrecompressed ? precompressed->size : file->size;
+        if (ByteRange::parse(std::string(request.headers.getHeader(HeaderKey::Range, "")), size, ranges) == RangeRequest::Unsatisfiable) {
+            Response *response = _createErrorResponse(HttpStatusCode::RangeNotSatisfiable, *route, false);
+            response->headers.replace(HeaderKey::ContentRange, "bytes */" + std::to_string(size));
+            return (response);
+        }
+    }
+
+    Response *response;
+    FileResponse *fileResponse = nullptr;
+    std::shared_ptr<const CachedFile> cached;
+    std::shared_ptr<const OpenFile> opened;
+    // Without open_file_cache the lookups above only stat the files, the one that is sent gets opened here
+    if (isPrecompressed) {
+        opened = OpenFile::withDescriptor(path + ".gz", precompressed);
+        if (opened->fd == -1)
+            return _createErrorResponse(HttpStatusCode::NotFound, *route);
+        response = fileResponse = new FileResponse(this, opened, &request);
+        response->headers.replace(HeaderKey::ContentEncoding, ContentEncoder::getName(encoding));
+    } else if (ranges.empty() && (cached = _server.getMemoryCache().lookup(path, *file, encoding, route->gzipCompLevel.getLevel()))) {
+        response = new MemoryResponse(this, cached, &request);
+    } else if (file->isRegular) {
+        opened = OpenFile::withDescriptor(path, file);
+        if (opened->fd == -1)
+            return _createErrorResponse(HttpStatusCode::NotFound, *route);
+        response = fileResponse = new FileResponse(this, opened, &request);
+    } else {
+        // Only regular files are kept open, anything else is streamed from a descriptor of its own
+        int fileFd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fileFd == -1)
+            return _createErrorResponse(HttpStatusCode::NotFound, *route);
+        response = fileResponse = new FileResponse(this, ReadableFD::file(fileFd), &request);
+    }
+
+    // Cached heads already carry the type and validators. Dynamically compressed files get their ETag suffixed once the coding is settled.
+    if (!cached) {
+        response->headers.replace(HeaderKey::ContentType, contentType);
+        if (file->isRegular)
+            _setValidatorHeaders(*response, *file, isPrecompressed ? encoding : ContentEncoding::Identity);
+    }
+    if (fileResponse && !ranges.empty())
+        fileResponse->setRanges(ranges, contentType);
+    if (acceptsRanges)
+        response->headers.replace(HeaderKey::AcceptRanges, "bytes");
+
+    _configureResponse(response, ranges.empty() ? HttpStatusCode::OK : HttpStatusCode::PartialContent);
+    _setCachingHeaders(*response, *route, isVarying);
+    return (response);
+}
+
+/// @brief Answer a conditional GET whose validators still match with a bodyless 304.
+Response *Client::_createNotModifiedResponse(const LocationRule &route, const OpenFile &file, ContentEncoding encoding, bool isVarying) {
+    DEBUG("Not modified: " << request.metadata.getPath().str());
+    Response *response = _configureResponse(new StaticResponse(this, "", &request), HttpStatusCode::NotModified);
+    response->headers.remove(HeaderKey::ContentLength);
+    _setValidatorHeaders(*response, file, encoding);
+    _setCachingHeaders(*response, route, isVarying);
+    return (response);
+}
+
+void Client::_setValidatorHeaders(Response &response, const OpenFile &file, ContentEncoding encoding) {
+    response.headers.replace(HeaderKey::ETag, ContentEncoder::getVariantETag(file.getETag(), encoding));
+    response.headers.replace(HeaderKey::LastModified, file.getLastModified());
+}
+
+/// @brief Replace the default no-store policy of file responses with the route's cache_control rule.
+/// @param isVarying Whether the body depends on Accept-Encoding, which shared caches have to key on.
+void Client::_setCachingHeaders(Response &response, const LocationRule &route, bool isVarying) {
+    if (route.cacheControl.isEnabled())
+        response.headers.replace(HeaderKey::CacheControl, route.cacheControl.getValue());
+    else
+        response.headers.remove(HeaderKey::CacheControl);
+
+    if (isVarying)
+        response.headers.replace(HeaderKey::Vary, "Accept-Encoding");
 }
 
 bool Client::setEpollWriteNotification(SocketFD &fd) {
     DEBUG("Setting EPOLLOUT for Client: " << fd.get());
-    if (fd.setEpollEvents(EPOLLOUT | EPOLLIN) == -1) {
+    uint32_t events = EPOLLOUT;
+    if (!_isReadingPaused)
+        events |= EPOLLIN;
+
+    if (fd.setEpollEvents(events) == -1) {
         ERROR("Failed to set EPOLLOUT for client: " << fd.get());
         _server.untrackClient(fd);
         return (false);
@@ -184,7 +336,11 @@ bool Client::setEpollWriteNotification(SocketFD &fd) {
 
 bool Client::unsetEpollWriteNotification(SocketFD &fd) {
     DEBUG("Unsetting EPOLLOUT for Client: " << fd.get());
-    if (fd.setEpollEvents(EPOLLIN) == -1) {
+    uint32_t events = 0;
+    if (!_isReadingPaused)
+        events |= EPOLLIN;
+
+    if (fd.setEpollEvents(events) == -1) {
         ERROR("Failed to unset EPOLLOUT for client: " << fd.get());
         _server.untrackClient(fd);
         return (false);
@@ -197,30 +353,36 @@ void Client::handleRead(SocketFD &fd, ssize_t funcReturnValue) {
     switch (_state) {
         case ClientHTTPState::Idle: {
             if (fd.getReadBufferSize() > 0) {
-                _state = ClientHTTPState::WaitingForHeaders;
+                _setState(ClientHTTPState::WaitingForHeaders, fd);
                 return handleRead(fd, funcReturnValue);
             }
             return ;
         }
 
         case ClientHTTPState::WaitingForHeaders: {
-            std::string headerString = fd.extractHeadersFromReadBuffer();
-            if (headerString.empty()) {
-                if (fd.wouldReadExceedMaxBufferSize()) {
-                    DEBUG("No valid headers received; closing the connection.");
-                    _server.untrackClient(fd);
+            switch (_parseRequestHead(fd, request)) {
+                case RequestParserStatus::Complete:
+                    return _beginRequest(fd);
+
+                case RequestParserStatus::Incomplete: {
+                    if (fd.wouldReadExceedMaxBufferSize()) {
+                        DEBUG("No valid headers received; closing the connection.");
+                        _server.untrackClient(fd);
+                    }
+                    return ;
                 }
-                return ;
-            }
-
-            request = Request(headerString);
-            response = _createResponseFromRequest(fd, request);
 
-            if (response->shouldDirectlySendResponse() &&
-                !setEpollWriteNotification(fd)) return ;
+                case RequestParserStatus::TooLarge: {
+                    DEBUG("Request head exceeds the maximum size, using error response");
+                    return switchResponseToErrorResponse(HttpStatusCode::RequestHeaderFieldsTooLarge, fd);
+                }
 
-            _state = ClientHTTPState::ReadingBody;
-            return handleRead(fd, funcReturnValue);
+                case RequestParserStatus::Invalid: {
+                    DEBUG("Malformed request head, using error response");
+                    return switchResponseToErrorResponse(HttpStatusCode::BadRequest, fd);
+                }
+            }
+            return ;
         }
 
         case ClientHTTPState::ReadingBody: {
@@ -245,19 +407,82 @@ void Client::handleRead(SocketFD &fd, ssize_t funcReturnValue) {
                 return ;
             }
 
-            if (isFullRequestBodyReceived(fd))
-                _state = ClientHTTPState::SendingResponse;
+            if (isFullRequestBodyReceived(fd)) {
+                _setState(ClientHTTPState::SendingResponse, fd);
+                _queuePipelinedRequests(fd);
+            }
 
             return ;
         }
 
-        default: {
-            ERROR("Unexpected state in Client::handleRead: " << static_cast<int>(_state));
+        case ClientHTTPState::SendingResponse: {
+            _queuePipelinedRequests(fd);
             return ;
         }
     }
 }
 
+/// @brief Continue parsing the next request head from the socket buffer.
+/// @details Once complete, the request is built straight from the buffer and the head consumed from it.
+RequestParserStatus Client::_parseRequestHead(SocketFD &fd, Request &into) {
+    std::string_view buffer = fd.peekReadBuffer();
+    RequestParserStatus status = _parser.parse(buffer);
+    if (status != RequestParserStatus::Complete)
+        return (status);
+
+    into = Request(_parser, buffer);
+    fd.skipReadBuffer(_parser.getHeadLength());
+    _parser.reset();
+    return (status);
+}
+
+/// @brief Create the response for `request` and start reading its body.
+void Client::_beginRequest(SocketFD &fd) {
+    response = _createResponseFromRequest(fd, request);
+
+    if (response->shouldDirectlySendResponse() &&
+        !setEpollWriteNotification(fd)) return ;
+
+    _setState(ClientHTTPState::ReadingBody, fd);
+    return handleRead(fd, 0);
+}
+
+/// @brief Whether no further request can be taken off the connection until the current response is sent.
+/// @details A body can only be consumed once its response exists, so nothing behind a request with a
+/// body is parsed ahead, and nothing behind one that closes the connection would ever be answered.
+bool Client::_isPipelineBlocked(const SocketFD &fd) const {
+    if (_pipeline.size() >= _server.getHTTPRule().pipelineDepth.getDepth() || fd.wouldReadExceedMaxBufferSize() || _parser.hasFailed())
+        return (true);
+    if (_pipeline.empty())
+        return (false);
+
+    const Request &last = _pipeline.back();
+    return (last.hasBody() || last.headers.getHeader(HeaderKey::Connection, "keep-alive") == "close");
+}
+
+/// @brief Parse the requests pipelined behind the one being answered, while the response is sent.
+/// @details Once the queue is blocked, reading stops so a client can't grow the buffer (or keep the
+/// connection busy reading) while its responses wait, it resumes as soon as the response is sent.
+void Client::_queuePipelinedRequests(SocketFD &fd) {
+    while (!_isPipelineBlocked(fd)) {
+        Request pipelined;
+        if (_parseRequestHead(fd, pipelined) != RequestParserStatus::Complete)
+            break ;
+
+        _pipeline.push_back(std::move(pipelined));
+        DEBUG("Queued pipelined request for Client: " << fd.get() << ", queue size: " << _pipeline.size());
+    }
+
+    if (!_isReadingPaused && _isPipelineBlocked(fd)) {
+        DEBUG("Pausing reads for Client: " << fd.get() << " until its response is sent");
+        _isReadingPaused = true;
+        if (fd.setEpollEvents(EPOLLOUT) == -1) {
+            ERROR("Failed to pause reading for client: " << fd.get());
+            _server.untrackClient(fd);
+        }
+    }
+}
+
 void Client::handleWrite(SocketFD &fd) {
     DEBUG("Handling write for Client, fd: " << fd.get());
 
@@ -267,7 +492,7 @@ void Client::handleWrite(SocketFD &fd) {
     }
 
     if (isFullRequestBodyReceived(fd))
-        _state = ClientHTTPState::SendingResponse;
+        _setState(ClientHTTPState::SendingResponse, fd);
 
     response->handleSocketWriteTick(fd);
 
@@ -280,84 +505,163 @@ void Client::handleClientReset(SocketFD &fd) {
 
 	DEBUG("Socket body bytes" << fd.getTotalBodyBytes());
 	DEBUG("Socket wrote bytes" << response->fuckyou());
+    bool shouldClose = request.headers.getHeader(HeaderKey::Connection, "keep-alive") == "close";
     if (response) {
+        shouldClose |= response->headers.getHeader(HeaderKey::Connection, "keep-alive") == "close";
         delete response;
         response = nullptr;
     }
 
-    if (request.headers.getHeader(HeaderKey::Connection, "keep-alive") == "close") {
+    if (shouldClose) {
         DEBUG("Connection header indicates 'close', disconnecting Client: " << fd.get());
         _server.untrackClient(fd);
         return;
     }
 
+    _isReadingPaused = false;
     if (fd.setEpollEvents(EPOLLIN) == -1) {
         ERROR("Failed to set EPOLLIN for client: " << fd.get());
         _server.untrackClient(fd);
         return;
     }
 
-    _state = ClientHTTPState::Idle;
+    _setState(ClientHTTPState::Idle, fd);
     request = Request();
     fd.resetCounter();
 
     _chunkedRequestBodyRead = false;
+
+    // Requests already in the buffer won't raise another read event, so they are started right away
+    if (!_pipeline.empty()) {
+        request = std::move(_pipeline.front());
+        _pipeline.pop_front();
+        _setState(ClientHTTPState::WaitingForHeaders, fd);
+        return _beginRequest(fd);
+    }
+    if (fd.getReadBufferSize() > 0)
+        handleRead(fd, 0);
 }
 
 void Client::switchResponseToErrorResponse(HttpStatusCode statusCode, SocketFD &fd) {
     DEBUG("SWITCHING response to error response for Client: " << _clientIP << ":" << _clientPort);
     DEBUG("Current response: " << (response ? "exists" : "does not exist"));
     DEBUG("Response address: " << response);
+
+    // Once a head went out an error head would land in the middle of its body, the connection is dropped
+    // instead, which also ends whatever process was producing that body
+    if (response && response->headersBeenSent()) {
+        ERROR("Aborting response of Client: " << _clientIP << ":" << _clientPort << " with " << static_cast<int>(statusCode) << ", its head was already sent");
+        return (_server.untrackClient(fd));
+    }
+
     if (response) {
         DEBUG("Deleting existing response for Client: " << _clientIP << ":" << _clientPort);
         delete response;
     }
 
+    // Requests rejected while parsing never got routed
     ServerConfig &config = _server.loadRequestConfig(request, _serverFd);
-    response = _createErrorResponse(statusCode, config.getLocation(request.metadata.getRawUrl()), true);
+    route = &config.getLocation(request.metadata.getRawUrl());
+    response = _createErrorResponse(statusCode, *route, true);
 
     if (_state == ClientHTTPState::WaitingForHeaders || _state == ClientHTTPState::ReadingBody)
-        _state = ClientHTTPState::SendingResponse;
+        _setState(ClientHTTPState::SendingResponse, fd);
 
     if (!setEpollWriteNotification(fd))
         return ;
 }
 
-bool Client::isTimedOut(const HTTPRule &httpRule, const SocketFD &fd) const {
-    switch (getState()) {
+/// @brief Change the HTTP state and move the timeout along with it.
+void Client::_setState(ClientHTTPState state, SocketFD &fd) {
+    _state = state;
+    armTimeout(fd);
+}
+
+/// @brief Timeout of the current state: header, body or keep-alive, zero if the state has none.
+std::chrono::steady_clock::duration Client::_getStateTimeout() const {
+    double seconds = 0;
+
+    switch (_state) {
         case ClientHTTPState::WaitingForHeaders: {
-            auto bound = fd.getLastReadTime() + std::chrono::duration<double>(httpRule.clientHeaderTimeout.timeout.getSeconds());
-            DEBUG_IF(bound < std::chrono::steady_clock::now(), "Client timed out while waiting for headers, fd: " << fd.get() << ", bound: " << bound.time_since_epoch().count());
-            return (bound < std::chrono::steady_clock::now());
+            seconds = _server.getHTTPRule().clientHeaderTimeout.timeout.getSeconds();
+            break ;
         }
 
         case ClientHTTPState::ReadingBody: {
-            ServerConfig &config = _server.loadRequestConfig(request, _serverFd);
-            const LocationRule &route = config.getLocation(request.metadata.getRawUrl());
-
-            auto bound = fd.getLastReadTime() + std::chrono::duration<double>(route.clientBodyReadTimeout.timeout.getSeconds());
-            DEBUG_IF(bound < std::chrono::steady_clock::now(), "Client timed out while reading body, fd: " << fd.get() << ", bound: " << bound.time_since_epoch().count());
-            return (bound < std::chrono::steady_clock::now());
+            if (route)
+                seconds = route->clientBodyReadTimeout.timeout.getSeconds();
+            break ;
         }
 
-        default: {
-            return (false);
+        case ClientHTTPState::Idle: {
+            seconds = _server.getHTTPRule().clientKeepAliveReadTimeout.timeout.getSeconds();
+            break ;
         }
+
+        default:
+            break ;
     }
+
+    return (std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds)));
 }
 
-bool Client::shouldBeClosed(const HTTPRule &httpRule, const SocketFD &fd) const {
-    if (getState() == ClientHTTPState::Idle) {
-        auto bound = fd.getLastReadTime() + std::chrono::duration<double>(httpRule.clientKeepAliveReadTimeout.timeout.getSeconds());
-        DEBUG_IF(bound < std::chrono::steady_clock::now(), "Client timed out while waiting for next request, fd: " << fd.get() << ", bound: " << bound.time_since_epoch().count());
-        return (bound < std::chrono::steady_clock::now());
+/// @brief Register the deadline of the current state with the server's timer.
+/// @details Only state changes touch the timer. Reads just move the socket's last read time,
+/// an event that fires before the real deadline re-arms itself for the remainder.
+void Client::armTimeout(SocketFD &fd) {
+    if (_timeoutEventId != -1 && _timeoutState == _state)
+        return ;
+
+    _cancelTimeout();
+    _timeoutState = _state;
+    _stateChangeTime = std::chrono::steady_clock::now();
+
+    std::chrono::steady_clock::duration timeout = _getStateTimeout();
+    if (timeout <= std::chrono::steady_clock::duration::zero())
+        return ;
+
+    _timeoutEventId = _server.getTimer().addEvent(timeout, [this, &fd]() {
+        _handleTimeout(fd);
+    });
+}
+
+void Client::_cancelTimeout() {
+    if (_timeoutEventId == -1)
+        return ;
+    _server.getTimer().deleteEvent(_timeoutEventId);
+    _timeoutEventId = -1;
+}
+
+void Client::_handleTimeout(SocketFD &fd) {
+    _timeoutEventId = -1;
+    if (_timeoutState != _state)
+        return (armTimeout(fd));
+
+    auto lastActivity = _stateChangeTime;
+    if (fd.getLastReadTime() != std::chrono::steady_clock::time_point::max())
+        lastActivity = std::max(lastActivity, fd.getLastReadTime());
+
+    auto now = std::chrono::steady_clock::now();
+    auto bound = lastActivity + _getStateTimeout();
+    if (bound > now) {
+        _timeoutEventId = _server.getTimer().addEvent(bound - now, [this, &fd]() {
+            _handleTimeout(fd);
+        });
+        return ;
+    }
+
+    if (_state == ClientHTTPState::Idle) {
+        DEBUG("Client timed out while waiting for next request, fd: " << fd.get());
+        return (_server.untrackClient(fd));
     }
 
-    return (false);
+    DEBUG("Client " << _clientIP << ":" << _clientPort << " has timed out, returning RequestTimeout response");
+    switchResponseToErrorResponse(HttpStatusCode::RequestTimeout, fd);
 }
 
 Client::~Client() {
     DEBUG("Destroying client for IP: " << _clientIP << ", Port: " << _clientPort << " (" << this << ")");
+    _cancelTimeout();
     if (response)
         delete response;
 }
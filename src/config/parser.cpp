@@ -30,6 +30,21 @@ static Key getRuleKeyFromToken(Token *token) {
         {ClientBodyReadTimeoutRule::getRuleName(), ClientBodyReadTimeoutRule::getKey()},
         {HTTPRule::getRuleName(), HTTPRule::getKey()},
         {ClientKeepAliveReadTimeoutRule::getRuleName(), ClientKeepAliveReadTimeoutRule::getKey()},
+        {WorkerProcessesRule::getRuleName(), WorkerProcessesRule::getKey()},
+        {WorkerCpuAffinityRule::getRuleName(), WorkerCpuAffinityRule::getKey()},
+        {IOEngineRule::getRuleName(), IOEngineRule::getKey()},
+        {TimerResolutionRule::getRuleName(), TimerResolutionRule::getKey()},
+        {OpenFileCacheRule::getRuleName(), OpenFileCacheRule::getKey()},
+        {MemoryCacheRule::getRuleName(), MemoryCacheRule::getKey()},
+        {GzipRule::getRuleName(), GzipRule::getKey()},
+        {GzipTypesRule::getRuleName(), GzipTypesRule::getKey()},
+        {GzipMinLengthRule::getRuleName(), GzipMinLengthRule::getKey()},
+        {GzipCompLevelRule::getRuleName(), GzipCompLevelRule::getKey()},
+        {GzipStaticRule::getRuleName(), GzipStaticRule::getKey()},
+        {CacheControlRule::getRuleName(), CacheControlRule::getKey()},
+        {PipelineDepthRule::getRuleName(), PipelineDepthRule::getKey()},
+        {FastCGIPassRule::getRuleName(), FastCGIPassRule::getKey()},
+        {CgiPreforkRule::getRuleName(), CgiPreforkRule::getKey()},
     };
 
     auto it = keyMap.find(token->value);
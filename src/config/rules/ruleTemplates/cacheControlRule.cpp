@@ -0,0 +1,57 @@
+#include "config/rules/ruleTemplates/cacheControlRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+#include <vector>
+
+CacheControlRule::CacheControlRule() :
+    _isSet(false), _isEnabled(true), _value(CACHE_CONTROL_DEFAULT) {}
+
+/// @brief Parse the Cache-Control directives sent with files, e.g. 'cache_control public max-age=3600;',
+/// or 'off' to leave the header out and let clients apply their own heuristics.
+CacheControlRule::CacheControlRule(Rule *rule) :
+    _isSet(false), _isEnabled(true), _value(CACHE_CONTROL_DEFAULT)
+{
+    if (!rule) return ;
+
+    RuleParser parser = RuleParser::create(rule, *this);
+    parser.expectMinNumArguments(1);
+
+    const Argument *argument = rule->arguments[0];
+    if (argument->type == ArgumentType::KEYWORD && std::get<Keyword>(argument->value) == Keyword::OFF) {
+        parser.expectArgumentCount(1);
+        _isEnabled = false;
+        _isSet = true;
+        return ;
+    }
+
+    std::vector<std::string> directives;
+    parser.parseAll(directives);
+
+    _value.clear();
+    for (const std::string &directive : directives)
+        _value.append(_value.empty() ? "" : ", ").append(directive);
+
+    _isSet = true;
+}
+
+/// @brief Check if the cache control rule is set.
+bool CacheControlRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Check if files are sent with a Cache-Control header at all.
+bool CacheControlRule::isEnabled() const {
+    return _isEnabled;
+}
+
+/// @brief Get the value of the Cache-Control header for files.
+const std::string &CacheControlRule::getValue() const {
+    return _value;
+}
+
+std::ostream& operator<<(std::ostream &os, const CacheControlRule &rule) {
+    os << "CacheControlRule: " << (rule.isEnabled() ? rule.getValue() : "off");
+    return os;
+}
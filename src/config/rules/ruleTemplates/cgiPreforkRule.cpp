@@ -0,0 +1,63 @@
+#include "config/rules/ruleTemplates/cgiPreforkRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+
+CgiPreforkRule::CgiPreforkRule() :
+    _isSet(false), _maxIdle(DEFAULT_CGI_PREFORK_MAX_IDLE), _spawnRate(DEFAULT_CGI_PREFORK_SPAWN_RATE) {}
+
+/// @brief Parse how many CGI processes are kept forked ahead of requests (or 'off'),
+/// and how many of them may be forked per second to refill the pool.
+CgiPreforkRule::CgiPreforkRule(Rule *rule) :
+    _isSet(false), _maxIdle(DEFAULT_CGI_PREFORK_MAX_IDLE), _spawnRate(DEFAULT_CGI_PREFORK_SPAWN_RATE)
+{
+    if (!rule) return ;
+
+    RuleParser parser = RuleParser::create(rule, *this);
+    parser.expectArgumentCount(1, 2);
+
+    const Argument *argument = rule->arguments[0];
+    if (argument->type == ArgumentType::KEYWORD && std::get<Keyword>(argument->value) == Keyword::OFF) {
+        parser.expectArgumentCount(1);
+        _isSet = true;
+        return ;
+    }
+
+    parser.parseArgument(_maxIdle)
+        .parseOptionalArgument(_spawnRate);
+
+    if (_maxIdle < 1 || _maxIdle > 256)
+        throw ParserArgumentException("Invalid amount of idle CGI processes", argument,
+            "Use a number of processes between 1 and 256, or 'off' to fork one for each request.");
+
+    if (_spawnRate < 1 || _spawnRate > 1000)
+        throw ParserArgumentException("Invalid CGI process spawn rate", rule->arguments[1],
+            "Use a number of processes per second between 1 and 1000.");
+
+    _isSet = true;
+}
+
+/// @brief Check if the CGI prefork rule is set.
+bool CgiPreforkRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Get the amount of idle CGI processes kept ready, 0 if the pool is disabled.
+size_t CgiPreforkRule::getMaxIdle() const {
+    return static_cast<size_t>(_maxIdle);
+}
+
+/// @brief Get the amount of CGI processes that may be forked per second.
+size_t CgiPreforkRule::getSpawnRate() const {
+    return static_cast<size_t>(_spawnRate);
+}
+
+std::ostream& operator<<(std::ostream &os, const CgiPreforkRule &rule) {
+    os << "CgiPreforkRule: ";
+    if (rule.getMaxIdle() == 0)
+        os << "off";
+    else
+        os << rule.getMaxIdle() << " idle processes, " << rule.getSpawnRate() << " spawned per second";
+    return os;
+}
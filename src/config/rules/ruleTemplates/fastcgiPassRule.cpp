@@ -0,0 +1,75 @@
+#include "config/rules/ruleTemplates/fastcgiPassRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+#include <string>
+
+FastCGIPassRule::FastCGIPassRule() :
+    _address(), _socketPath(), _host(), _port() {}
+
+FastCGIPassRule::FastCGIPassRule(Rule *rule) :
+    _address(), _socketPath(), _host(), _port()
+{
+    if (!rule) return ;
+
+    RuleParser::create(rule, *this)
+        .expectArgumentCount(1)
+        .parseArgument(_address);
+
+    if (_address.starts_with("unix:")) {
+        _socketPath = _address.substr(5);
+        if (_socketPath.empty())
+            throw ParserArgumentException("Missing FastCGI socket path", rule->arguments[0],
+                "Use 'unix:' followed by the path of the application's socket, e.g. 'unix:/run/php-fpm.sock'.");
+        return ;
+    }
+
+    size_t colon = _address.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == _address.size()
+        || _address.find_first_not_of("0123456789", colon + 1) != std::string::npos)
+        throw ParserArgumentException("Invalid FastCGI address", rule->arguments[0],
+            "Use 'unix:<path>' for a unix socket, or '<host>:<port>' for a TCP socket, e.g. '127.0.0.1:9000'.");
+
+    _host = _address.substr(0, colon);
+    _port = _address.substr(colon + 1);
+    // Bracketed IPv6 addresses, as in "[::1]:9000"
+    if (_host.size() > 2 && _host.front() == '[' && _host.back() == ']')
+        _host = _host.substr(1, _host.size() - 2);
+}
+
+/// @brief Check if requests of the location are passed to a FastCGI application.
+bool FastCGIPassRule::isSet() const {
+    return (!_address.empty());
+}
+
+/// @brief Whether the application listens on a unix socket rather than a TCP one.
+bool FastCGIPassRule::isUnixSocket() const {
+    return (!_socketPath.empty());
+}
+
+/// @brief The address as written in the configuration, which identifies the application.
+const std::string &FastCGIPassRule::getAddress() const {
+    return (_address);
+}
+
+const std::string &FastCGIPassRule::getSocketPath() const {
+    return (_socketPath);
+}
+
+const std::string &FastCGIPassRule::getHost() const {
+    return (_host);
+}
+
+const std::string &FastCGIPassRule::getPort() const {
+    return (_port);
+}
+
+std::ostream& operator<<(std::ostream &os, const FastCGIPassRule &rule) {
+    os << "FastCGIPassRule: ";
+    if (rule.isSet())
+        os << rule.getAddress();
+    else
+        os << "Not set";
+    return os;
+}
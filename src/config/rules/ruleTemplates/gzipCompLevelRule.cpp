@@ -0,0 +1,39 @@
+#include "config/rules/ruleTemplates/gzipCompLevelRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+
+GzipCompLevelRule::GzipCompLevelRule() :
+    _isSet(false), _level(GZIP_COMP_LEVEL_DEFAULT) {}
+
+GzipCompLevelRule::GzipCompLevelRule(Rule *rule) :
+    _isSet(false), _level(GZIP_COMP_LEVEL_DEFAULT)
+{
+    if (!rule) return ;
+
+    RuleParser::create(rule, *this)
+        .expectArgumentCount(1)
+        .parseArgument(_level);
+
+    if (_level < 1 || _level > 9)
+        throw ParserArgumentException("Invalid gzip compression level", rule->arguments[0],
+            "Use a level between 1 (fastest) and 9 (smallest output).");
+
+    _isSet = true;
+}
+
+/// @brief Check if the gzip compression level rule is set.
+bool GzipCompLevelRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Get the zlib compression level, from 1 (fastest) to 9 (smallest output).
+int GzipCompLevelRule::getLevel() const {
+    return _level;
+}
+
+std::ostream& operator<<(std::ostream &os, const GzipCompLevelRule &rule) {
+    os << "GzipCompLevelRule: " << rule.getLevel();
+    return os;
+}
@@ -0,0 +1,36 @@
+#include "config/rules/ruleTemplates/gzipMinLengthRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+
+GzipMinLengthRule::GzipMinLengthRule() :
+    _isSet(false), _minLength(Size(GZIP_MIN_LENGTH_DEFAULT)) {}
+
+/// @brief Parse the smallest body that is worth compressing. Bodies of unknown length are always compressed.
+GzipMinLengthRule::GzipMinLengthRule(Rule *rule) :
+    _isSet(false), _minLength(Size(GZIP_MIN_LENGTH_DEFAULT))
+{
+    if (!rule) return ;
+
+    RuleParser::create(rule, *this)
+        .expectArgumentCount(1)
+        .parseArgument(_minLength);
+
+    _isSet = true;
+}
+
+/// @brief Check if the gzip min length rule is set.
+bool GzipMinLengthRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Get the smallest body length in bytes that gets compressed.
+size_t GzipMinLengthRule::getMinLength() const {
+    return _minLength.get();
+}
+
+std::ostream& operator<<(std::ostream &os, const GzipMinLengthRule &rule) {
+    os << "GzipMinLengthRule: " << rule.getMinLength() << " bytes";
+    return os;
+}
@@ -0,0 +1,35 @@
+#include "config/rules/ruleTemplates/gzipRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+
+GzipRule::GzipRule() :
+    _isSet(false), _isEnabled(GZIP_DEFAULT) {}
+
+GzipRule::GzipRule(Rule *rule) :
+    _isSet(false), _isEnabled(GZIP_DEFAULT)
+{
+    if (!rule) return ;
+
+    RuleParser::create(rule, *this)
+        .expectArgumentCount(1)
+        .parseArgument(_isEnabled);
+
+    _isSet = true;
+}
+
+/// @brief Check if the gzip rule is set.
+bool GzipRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Check if response bodies may be compressed for clients that accept it.
+bool GzipRule::isEnabled() const {
+    return _isEnabled;
+}
+
+std::ostream& operator<<(std::ostream &os, const GzipRule &rule) {
+    os << "GzipRule: " << (rule.isEnabled() ? "on" : "off");
+    return os;
+}
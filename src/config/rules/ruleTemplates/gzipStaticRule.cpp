@@ -0,0 +1,35 @@
+#include "config/rules/ruleTemplates/gzipStaticRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+
+GzipStaticRule::GzipStaticRule() :
+    _isSet(false), _isEnabled(GZIP_STATIC_DEFAULT) {}
+
+GzipStaticRule::GzipStaticRule(Rule *rule) :
+    _isSet(false), _isEnabled(GZIP_STATIC_DEFAULT)
+{
+    if (!rule) return ;
+
+    RuleParser::create(rule, *this)
+        .expectArgumentCount(1)
+        .parseArgument(_isEnabled);
+
+    _isSet = true;
+}
+
+/// @brief Check if the gzip static rule is set.
+bool GzipStaticRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Check if a precompressed "<file>.gz" next to a requested file is sent instead, to clients that accept gzip.
+bool GzipStaticRule::isEnabled() const {
+    return _isEnabled;
+}
+
+std::ostream& operator<<(std::ostream &os, const GzipStaticRule &rule) {
+    os << "GzipStaticRule: " << (rule.isEnabled() ? "on" : "off");
+    return os;
+}
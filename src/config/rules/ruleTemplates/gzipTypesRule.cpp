@@ -0,0 +1,55 @@
+#include "config/rules/ruleTemplates/gzipTypesRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <cctype>
+
+GzipTypesRule::GzipTypesRule() :
+    _isSet(false), _types(GZIP_TYPES_DEFAULT) {}
+
+/// @brief Parse the media types that get compressed. text/html is always part of them, '*' matches any type.
+GzipTypesRule::GzipTypesRule(Rule *rule) :
+    _isSet(false), _types(GZIP_TYPES_DEFAULT)
+{
+    if (!rule) return ;
+
+    _types = {"text/html"};
+    RuleParser::create(rule, *this)
+        .expectMinNumArguments(1)
+        .parseAll(_types);
+
+    _isSet = true;
+}
+
+/// @brief Check if the gzip types rule is set.
+bool GzipTypesRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Check if a Content-Type value is one of the compressed types, ignoring its parameters (e.g. charset).
+bool GzipTypesRule::matches(std::string_view contentType) const {
+    contentType = contentType.substr(0, contentType.find(';'));
+    while (!contentType.empty() && std::isspace(static_cast<unsigned char>(contentType.back())))
+        contentType.remove_suffix(1);
+    if (contentType.empty())
+        return (false);
+
+    return (std::any_of(_types.begin(), _types.end(), [contentType](const std::string &type) {
+        return (type == "*" || std::equal(type.begin(), type.end(), contentType.begin(), contentType.end(),
+            [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); }));
+    }));
+}
+
+/// @brief Get the media types that get compressed.
+const std::vector<std::string>& GzipTypesRule::getTypes() const {
+    return _types;
+}
+
+std::ostream& operator<<(std::ostream &os, const GzipTypesRule &rule) {
+    os << "GzipTypesRule: ";
+    for (const auto &type : rule.getTypes())
+        os << type << " ";
+    return os;
+}
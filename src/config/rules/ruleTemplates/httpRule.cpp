@@ -19,6 +19,14 @@ HTTPRule::HTTPRule(Rule *rule) {
 	objectParser.local().optional()
 		.parseFromOne(clientHeaderTimeout)
 		.parseFromOne(clientKeepAliveReadTimeout)
+		.parseFromOne(workerProcesses)
+		.parseFromOne(workerCpuAffinity)
+		.parseFromOne(ioEngine)
+		.parseFromOne(timerResolution)
+		.parseFromOne(openFileCache)
+		.parseFromOne(memoryCache)
+		.parseFromOne(pipelineDepth)
+		.parseFromOne(cgiPrefork)
 		.required()
 		.parseRange(servers);
 }
@@ -26,6 +34,14 @@ HTTPRule::HTTPRule(Rule *rule) {
 std::ostream& operator<<(std::ostream &os, const HTTPRule &rule) {
     os << "HTTPRule: ";
     os << "Client Header Timeout: " << rule.clientHeaderTimeout << "\n";
+    os << rule.workerProcesses << "\n";
+    os << rule.workerCpuAffinity << "\n";
+    os << rule.ioEngine << "\n";
+    os << rule.timerResolution << "\n";
+    os << rule.openFileCache << "\n";
+    os << rule.memoryCache << "\n";
+    os << rule.pipelineDepth << "\n";
+    os << rule.cgiPrefork << "\n";
 	os << "Servers:\n";
 	for (const auto &server : rule.servers)
 		os << server << "\n";
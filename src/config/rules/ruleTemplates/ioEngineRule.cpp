@@ -0,0 +1,45 @@
+#include "config/rules/ruleTemplates/ioEngineRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+#include <string>
+
+IOEngineRule::IOEngineRule() :
+    _isSet(false), _engine(IO_ENGINE_DEFAULT) {}
+
+IOEngineRule::IOEngineRule(Rule *rule) :
+    _isSet(false), _engine(IO_ENGINE_DEFAULT)
+{
+    if (!rule) return ;
+
+    std::string engine;
+    RuleParser::create(rule, *this)
+        .expectArgumentCount(1)
+        .parseArgument(engine);
+
+    if (engine == "epoll")
+        _engine = IOEngine::Epoll;
+    else if (engine == "io_uring")
+        _engine = IOEngine::IOUring;
+    else
+        throw ParserArgumentException("Unknown io engine", rule->arguments[0],
+            "Use 'epoll', or 'io_uring' to accept connections and batch epoll updates and closes through an io_uring.");
+
+    _isSet = true;
+}
+
+/// @brief Check if the io engine rule is set.
+bool IOEngineRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Get the engine the event loop should use for its descriptor bookkeeping.
+IOEngine IOEngineRule::getEngine() const {
+    return _engine;
+}
+
+std::ostream& operator<<(std::ostream &os, const IOEngineRule &rule) {
+    os << "IOEngineRule: " << (rule.getEngine() == IOEngine::IOUring ? "io_uring" : "epoll");
+    return os;
+}
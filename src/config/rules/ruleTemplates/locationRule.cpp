@@ -32,6 +32,12 @@ void LocationRule::_parseFromObject(Object *object) {
 
     objectParser.bound(Key::HTTP).optional()
         .parseFromOne(clientBodyReadTimeout)
+        .parseFromOne(gzip)
+        .parseFromOne(gzipTypes)
+        .parseFromOne(gzipMinLength)
+        .parseFromOne(gzipCompLevel)
+        .parseFromOne(gzipStatic)
+        .parseFromOne(cacheControl)
         .bound(Key::SERVER).optional()
         .parseFromOne(root, path.str(), object)
         .parseFromRange(methods)
@@ -44,6 +50,7 @@ void LocationRule::_parseFromObject(Object *object) {
         .parseFromOne(cgi)
         .parseFromOne(cgiTimeout)
         .parseFromRange(cgiExtension)
+        .parseFromOne(fastcgiPass)
         .local() // Local rules are not inherited from parent objects
         .parseFromOne(alias);
 }
@@ -68,6 +75,13 @@ std::ostream& operator<<(std::ostream &os, const LocationRule &rule) {
     os << rule.cgi << "\n";
     os << rule.cgiTimeout << "\n";
     os << rule.cgiExtension << "\n";
+    os << rule.fastcgiPass << "\n";
     os << rule.clientBodyReadTimeout << "\n";
+    os << rule.gzip << "\n";
+    os << rule.gzipTypes << "\n";
+    os << rule.gzipMinLength << "\n";
+    os << rule.gzipCompLevel << "\n";
+    os << rule.gzipStatic << "\n";
+    os << rule.cacheControl << "\n";
     return os;
 }
@@ -0,0 +1,55 @@
+#include "config/rules/ruleTemplates/memoryCacheRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+
+MemoryCacheRule::MemoryCacheRule() :
+    _isSet(false), _maxMemory(Size(DEFAULT_MEMORY_CACHE_MAX_MEMORY)), _maxFileSize(Size(DEFAULT_MEMORY_CACHE_MAX_FILE_SIZE)) {}
+
+/// @brief Parse the memory cache limits: the memory all cached files may take up together
+/// (or 'off'), and the size of the largest file that is cached.
+MemoryCacheRule::MemoryCacheRule(Rule *rule) :
+    _isSet(false), _maxMemory(Size(DEFAULT_MEMORY_CACHE_MAX_MEMORY)), _maxFileSize(Size(DEFAULT_MEMORY_CACHE_MAX_FILE_SIZE))
+{
+    if (!rule) return ;
+
+    RuleParser parser = RuleParser::create(rule, *this);
+    parser.expectArgumentCount(1, 2);
+
+    const Argument *argument = rule->arguments[0];
+    if (argument->type == ArgumentType::KEYWORD && std::get<Keyword>(argument->value) == Keyword::OFF) {
+        parser.expectArgumentCount(1);
+        _isSet = true;
+        return ;
+    }
+
+    parser.parseArgument(_maxMemory)
+        .parseOptionalArgument(_maxFileSize);
+
+    _isSet = true;
+}
+
+/// @brief Check if the memory cache rule is set.
+bool MemoryCacheRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Get the memory budget of the cache in bytes, 0 if the cache is disabled.
+size_t MemoryCacheRule::getMaxMemory() const {
+    return _maxMemory.get();
+}
+
+/// @brief Get the size in bytes of the largest file that is kept in memory.
+size_t MemoryCacheRule::getMaxFileSize() const {
+    return _maxFileSize.get();
+}
+
+std::ostream& operator<<(std::ostream &os, const MemoryCacheRule &rule) {
+    os << "MemoryCacheRule: ";
+    if (rule.getMaxMemory() == 0)
+        os << "off";
+    else
+        os << rule.getMaxMemory() << " bytes, files up to " << rule.getMaxFileSize() << " bytes";
+    return os;
+}
@@ -29,7 +29,10 @@ MethodsRule::MethodsRule(const std::vector<Rule *> &rules) :
 }
 
 /// @brief Check if the specified method is allowed by this rule.
+/// @details Allowing GET allows HEAD as well, like every server that supports GET has to.
 bool MethodsRule::isAllowed(Method method) const {
+    if (method == Method::HEAD && (_methods & Method::GET) != Method::UNKNOWN_METHOD)
+        return (true);
     return (_methods & method) != Method::UNKNOWN_METHOD;
 }
 
@@ -0,0 +1,54 @@
+#include "config/rules/ruleTemplates/openFileCacheRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+
+OpenFileCacheRule::OpenFileCacheRule() :
+    _isSet(false), _maxEntries(DEFAULT_OPEN_FILE_CACHE_MAX_ENTRIES), validity(DEFAULT_OPEN_FILE_CACHE_VALIDITY) {}
+
+/// @brief Parse the open file cache limits: how many paths are kept open (or 'off'),
+/// and for how long an entry is trusted before the path is opened again.
+OpenFileCacheRule::OpenFileCacheRule(Rule *rule) :
+    _isSet(false), _maxEntries(DEFAULT_OPEN_FILE_CACHE_MAX_ENTRIES), validity(DEFAULT_OPEN_FILE_CACHE_VALIDITY)
+{
+    if (!rule) return ;
+
+    RuleParser parser = RuleParser::create(rule, *this);
+    parser.expectArgumentCount(1, 2);
+
+    const Argument *argument = rule->arguments[0];
+    if (argument->type == ArgumentType::KEYWORD && std::get<Keyword>(argument->value) == Keyword::OFF) {
+        parser.expectArgumentCount(1);
+        _isSet = true;
+        return ;
+    }
+
+    parser.parseArgument(_maxEntries)
+        .parseOptionalArgument(validity);
+
+    if (_maxEntries < 1)
+        throw ParserArgumentException("Invalid amount of open file cache entries", argument,
+            "Use a positive number of entries, or 'off' to open every file on each request.");
+
+    _isSet = true;
+}
+
+/// @brief Check if the open file cache rule is set.
+bool OpenFileCacheRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Get the maximum amount of cached paths, 0 if the cache is disabled.
+size_t OpenFileCacheRule::getMaxEntries() const {
+    return static_cast<size_t>(_maxEntries);
+}
+
+std::ostream& operator<<(std::ostream &os, const OpenFileCacheRule &rule) {
+    os << "OpenFileCacheRule: ";
+    if (rule.getMaxEntries() == 0)
+        os << "off";
+    else
+        os << rule.getMaxEntries() << " entries, valid for " << rule.validity.getSeconds() << " seconds";
+    return os;
+}
@@ -0,0 +1,39 @@
+#include "config/rules/ruleTemplates/pipelineDepthRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+
+PipelineDepthRule::PipelineDepthRule() :
+    _isSet(false), _depth(DEFAULT_PIPELINE_DEPTH) {}
+
+PipelineDepthRule::PipelineDepthRule(Rule *rule) :
+    _isSet(false), _depth(DEFAULT_PIPELINE_DEPTH)
+{
+    if (!rule) return ;
+
+    RuleParser::create(rule, *this)
+        .expectArgumentCount(1)
+        .parseArgument(_depth);
+
+    if (_depth < 1)
+        throw ParserArgumentException("Invalid pipeline depth", rule->arguments[0],
+            "Use a positive number of requests, 1 handles pipelined requests strictly one after another.");
+
+    _isSet = true;
+}
+
+/// @brief Check if the pipeline depth rule is set.
+bool PipelineDepthRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Get how many requests of a connection are parsed ahead while a response is still being sent.
+size_t PipelineDepthRule::getDepth() const {
+    return static_cast<size_t>(_depth);
+}
+
+std::ostream& operator<<(std::ostream &os, const PipelineDepthRule &rule) {
+    os << "PipelineDepthRule: " << rule.getDepth() << " request(s)";
+    return os;
+}
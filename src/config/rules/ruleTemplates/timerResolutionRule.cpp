@@ -0,0 +1,30 @@
+#include "config/rules/ruleTemplates/timerResolutionRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+TimerResolutionRule::TimerResolutionRule() :
+    _isSet(false), resolution(DEFAULT_TIMER_RESOLUTION) {}
+
+/// @brief Parse the timer resolution: timer wakeups are rounded up to a multiple of it,
+/// so deadlines that are close together are handled by a single wakeup. 0 fires timers exactly.
+TimerResolutionRule::TimerResolutionRule(Rule *rule) :
+    _isSet(false), resolution(DEFAULT_TIMER_RESOLUTION)
+{
+    if (!rule) return;
+
+    RuleParser::create(rule, *this)
+        .expectArgumentCount(1)
+        .parseArgument(resolution);
+
+    _isSet = true;
+}
+
+/// @brief Check if the timer resolution rule is set.
+bool TimerResolutionRule::isSet() const {
+    return _isSet;
+}
+
+std::ostream& operator<<(std::ostream &os, const TimerResolutionRule &rule) {
+    os << "TimerResolutionRule: " << rule.resolution.getSeconds() << " seconds";
+    return os;
+}
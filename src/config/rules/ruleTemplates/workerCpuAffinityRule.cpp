@@ -0,0 +1,33 @@
+#include "config/rules/ruleTemplates/workerCpuAffinityRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+WorkerCpuAffinityRule::WorkerCpuAffinityRule() :
+    _isSet(false), _enabled(WORKER_CPU_AFFINITY_DEFAULT) {}
+
+WorkerCpuAffinityRule::WorkerCpuAffinityRule(Rule *rule) :
+    _isSet(false), _enabled(WORKER_CPU_AFFINITY_DEFAULT)
+{
+    if (!rule) return ;
+
+    RuleParser::create(rule, *this)
+        .expectArgumentCount(1)
+        .parseArgument(_enabled);
+
+    _isSet = true;
+}
+
+/// @brief Check if the worker cpu affinity rule is set.
+bool WorkerCpuAffinityRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Check if every worker process should be pinned to its own CPU core.
+bool WorkerCpuAffinityRule::isEnabled() const {
+    return _enabled;
+}
+
+std::ostream& operator<<(std::ostream &os, const WorkerCpuAffinityRule &rule) {
+    os << "WorkerCpuAffinityRule: " << (rule.isEnabled() ? "on" : "off");
+    return os;
+}
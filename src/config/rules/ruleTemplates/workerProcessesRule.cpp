@@ -0,0 +1,45 @@
+#include "config/rules/ruleTemplates/workerProcessesRule.hpp"
+#include "config/rules/ruleParser.hpp"
+#include "config/rules/rules.hpp"
+
+#include <ostream>
+#include <thread>
+
+WorkerProcessesRule::WorkerProcessesRule() :
+    _isSet(false), _workerCount(DEFAULT_WORKER_PROCESSES) {}
+
+WorkerProcessesRule::WorkerProcessesRule(Rule *rule) :
+    _isSet(false), _workerCount(DEFAULT_WORKER_PROCESSES)
+{
+    if (!rule) return ;
+
+    RuleParser parser = RuleParser::create(rule, *this);
+    parser.expectArgumentCount(1);
+
+    const Argument *argument = rule->arguments[0];
+    if (argument->type == ArgumentType::KEYWORD && std::get<Keyword>(argument->value) == Keyword::AUTO)
+        _workerCount = std::max(1u, std::thread::hardware_concurrency());
+    else
+        parser.parseArgument(_workerCount);
+
+    if (_workerCount < 1)
+        throw ParserArgumentException("Invalid amount of worker processes", argument,
+            "Use a positive number of workers, or 'auto' to start one worker per CPU core.");
+
+    _isSet = true;
+}
+
+/// @brief Check if the worker processes rule is set.
+bool WorkerProcessesRule::isSet() const {
+    return _isSet;
+}
+
+/// @brief Get the amount of worker processes (reactors) that should be started.
+int WorkerProcessesRule::getWorkerCount() const {
+    return _workerCount;
+}
+
+std::ostream& operator<<(std::ostream &os, const WorkerProcessesRule &rule) {
+    os << "WorkerProcessesRule: " << rule.getWorkerCount() << " worker(s)";
+    return os;
+}
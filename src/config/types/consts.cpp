@@ -4,6 +4,7 @@
 
 #include <type_traits>
 #include <algorithm>
+#include <strings.h>
 #include <string>
 
 Method operator|(Method lhs, Method rhs) {
@@ -28,15 +29,18 @@ std::string methodToStr(const Method &method) {
 	return str;
 }
 
-Method stringToMethod(const std::string &str) {
-    std::string lowerStr = str;
-    std::transform(lowerStr.begin(), lowerStr.end(), lowerStr.begin(), ::tolower);
-    if (lowerStr == "get") return GET;
-	if (lowerStr == "post") return POST;
-	if (lowerStr == "delete") return DELETE;
-	if (lowerStr == "put") return PUT;
-	if (lowerStr == "head") return HEAD;
-	if (lowerStr == "options") return OPTIONS;
+/// @brief Case-insensitive method lookup, straight from the request buffer.
+Method stringToMethod(std::string_view str) {
+    auto is = [str](std::string_view name) {
+        return (str.size() == name.size() && strncasecmp(str.data(), name.data(), name.size()) == 0);
+    };
+
+    if (is("get")) return GET;
+	if (is("post")) return POST;
+	if (is("delete")) return DELETE;
+	if (is("put")) return PUT;
+	if (is("head")) return HEAD;
+	if (is("options")) return OPTIONS;
 	return UNKNOWN_METHOD;
 }
 
@@ -130,7 +134,7 @@ std::ostream& operator<<(std::ostream& os, HttpStatusCode code) {
 	return os;
 }
 
-std::string headerKeyToString(HeaderKey key) {
+std::string_view headerKeyToString(HeaderKey key) {
     switch (key) {
         case HeaderKey::ContentType: return "Content-Type";
         case HeaderKey::ContentLength: return "Content-Length";
@@ -151,6 +155,17 @@ std::string headerKeyToString(HeaderKey key) {
         case HeaderKey::ContentDisposition: return "Content-Disposition";
         case HeaderKey::RetryAfter: return "Retry-After";
         case HeaderKey::CacheControl: return "Cache-Control";
+        case HeaderKey::ETag: return "ETag";
+        case HeaderKey::ContentEncoding: return "Content-Encoding";
+        case HeaderKey::Vary: return "Vary";
+        case HeaderKey::LastModified: return "Last-Modified";
+        case HeaderKey::IfNoneMatch: return "If-None-Match";
+        case HeaderKey::IfModifiedSince: return "If-Modified-Since";
+        case HeaderKey::Range: return "Range";
+        case HeaderKey::IfRange: return "If-Range";
+        case HeaderKey::AcceptRanges: return "Accept-Ranges";
+        case HeaderKey::ContentRange: return "Content-Range";
+        case HeaderKey::Unknown: return "Unknown";
 
         default:
             ERROR("Unknown Header Key: " << static_cast<int>(key));
@@ -158,6 +173,59 @@ std::string headerKeyToString(HeaderKey key) {
     }
 }
 
+/// @brief FNV-1a of the lowercased name, so differently cased spellings of a field hash the same.
+uint32_t hashHeaderName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>('A' <= c && c <= 'Z' ? c - 'A' + 'a' : c);
+        hash *= 16777619u;
+    }
+    return (hash);
+}
+
+/// @brief Open-addressed table of the known field names by their hash, built on first use.
+struct HeaderKeyTable {
+    struct Slot {
+        uint32_t hash;
+        HeaderKey key;
+    };
+    Slot slots[HEADER_KEY_TABLE_SIZE];
+
+    HeaderKeyTable() {
+        for (Slot &slot : slots)
+            slot = Slot{0, HeaderKey::Unknown};
+        for (int i = 0; i < static_cast<int>(HeaderKey::Unknown); ++i) {
+            HeaderKey key = static_cast<HeaderKey>(i);
+            uint32_t hash = hashHeaderName(headerKeyToString(key));
+            uint32_t index = hash & (HEADER_KEY_TABLE_SIZE - 1);
+            while (slots[index].key != HeaderKey::Unknown)
+                index = (index + 1) & (HEADER_KEY_TABLE_SIZE - 1);
+            slots[index] = Slot{hash, key};
+        }
+    }
+};
+
+/// @brief The HeaderKey of a field name, matched case-insensitively, or HeaderKey::Unknown.
+/// @param nameHash hashHeaderName() of the name, for callers that need it anyway.
+HeaderKey stringToHeaderKey(std::string_view name, uint32_t nameHash) {
+    static const HeaderKeyTable table;
+
+    uint32_t index = nameHash & (HEADER_KEY_TABLE_SIZE - 1);
+    for (; table.slots[index].key != HeaderKey::Unknown; index = (index + 1) & (HEADER_KEY_TABLE_SIZE - 1)) {
+        const HeaderKeyTable::Slot &slot = table.slots[index];
+        if (slot.hash != nameHash)
+            continue ;
+        std::string_view known = headerKeyToString(slot.key);
+        if (name.size() == known.size() && strncasecmp(name.data(), known.data(), known.size()) == 0)
+            return (slot.key);
+    }
+    return (HeaderKey::Unknown);
+}
+
+HeaderKey stringToHeaderKey(std::string_view name) {
+    return (stringToHeaderKey(name, hashHeaderName(name)));
+}
+
 std::ostream& operator<<(std::ostream& os, HeaderKey key) {
     os << headerKeyToString(key);
     return os;
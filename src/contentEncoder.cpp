@@ -0,0 +1,138 @@
+#include "contentEncoder.hpp"
+#include "print.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+
+ContentEncoder::ContentEncoder(ContentEncoding encoding) : _stream(), _encoding(encoding), _isFinished(false) {}
+
+ContentEncoder::~ContentEncoder() {
+    deflateEnd(&_stream);
+}
+
+/// @brief Start a compression stream.
+/// @param level zlib compression level, from 1 (fastest) to 9 (smallest output).
+/// @return The encoder, or nullptr for Identity or if zlib could not be initialized.
+std::unique_ptr<ContentEncoder> ContentEncoder::create(ContentEncoding encoding, int level) {
+    if (encoding == ContentEncoding::Identity)
+        return (nullptr);
+
+    std::unique_ptr<ContentEncoder> encoder(new ContentEncoder(encoding));
+    // zlib wraps the stream in a gzip header and trailer when 16 is added to the window bits
+    int windowBits = CONTENT_ENCODER_WINDOW_BITS + (encoding == ContentEncoding::Gzip ? 16 : 0);
+    int result = deflateInit2(&encoder->_stream, level, Z_DEFLATED, windowBits, CONTENT_ENCODER_MEMORY_LEVEL, Z_DEFAULT_STRATEGY);
+    if (result != Z_OK) {
+        ERROR("Failed to initialize " << getName(encoding) << " encoder: " << zError(result));
+        // deflateEnd must not run on a stream that was never initialized
+        encoder->_stream.state = nullptr;
+        return (nullptr);
+    }
+    return (encoder);
+}
+
+/// @brief Compress `input` and append whatever output zlib produces to `output`.
+/// @return false if the stream is broken or was already finished.
+bool ContentEncoder::write(std::string_view input, std::string &output, EncoderFlush flush) {
+    if (_isFinished)
+        return (input.empty());
+
+    int mode = flush == EncoderFlush::Finish ? Z_FINISH : flush == EncoderFlush::Sync ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+    _stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    _stream.avail_in = static_cast<uInt>(input.size());
+
+    while (true) {
+        size_t offset = output.size();
+        output.resize(offset + CONTENT_ENCODER_OUTPUT_BLOCK_SIZE);
+        _stream.next_out = reinterpret_cast<Bytef *>(output.data() + offset);
+        _stream.avail_out = CONTENT_ENCODER_OUTPUT_BLOCK_SIZE;
+
+        int result = deflate(&_stream, mode);
+        output.resize(offset + CONTENT_ENCODER_OUTPUT_BLOCK_SIZE - _stream.avail_out);
+
+        if (result == Z_STREAM_END) {
+            _isFinished = true;
+            return (true);
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            ERROR("Failed to compress response body: " << zError(result));
+            return (false);
+        }
+        // A full output block means zlib may still be holding back output
+        if (_stream.avail_out != 0 && _stream.avail_in == 0)
+            return (true);
+    }
+}
+
+/// @brief Get the quality an Accept-Encoding header gives a coding, 0 if the client doesn't accept it.
+/// @details '*' stands for every coding that isn't listed explicitly and x-gzip is an alias of gzip.
+double ContentEncoder::getQuality(const std::string &acceptEncoding, ContentEncoding encoding) {
+    std::string_view name = getName(encoding);
+    double quality = -1;
+    double wildcardQuality = -1;
+
+    size_t position = 0;
+    while (position < acceptEncoding.size()) {
+        size_t end = std::min(acceptEncoding.find(',', position), acceptEncoding.size());
+        std::string_view element(acceptEncoding.data() + position, end - position);
+        position = end + 1;
+
+        std::string_view coding = element.substr(0, element.find(';'));
+        while (!coding.empty() && std::isspace(static_cast<unsigned char>(coding.front())))
+            coding.remove_prefix(1);
+        while (!coding.empty() && std::isspace(static_cast<unsigned char>(coding.back())))
+            coding.remove_suffix(1);
+
+        double elementQuality = 1;
+        size_t parameter = element.find("q=");
+        if (parameter == std::string_view::npos)
+            parameter = element.find("Q=");
+        if (parameter != std::string_view::npos && element.find(';') < parameter)
+            elementQuality = std::strtod(std::string(element.substr(parameter + 2)).c_str(), nullptr);
+
+        auto equals = [coding](std::string_view other) {
+            return (std::equal(coding.begin(), coding.end(), other.begin(), other.end(),
+                [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; }));
+        };
+        if (equals(name) || (encoding == ContentEncoding::Gzip && equals("x-gzip")))
+            quality = std::max(quality, elementQuality);
+        else if (coding == "*")
+            wildcardQuality = elementQuality;
+    }
+
+    if (quality < 0)
+        quality = wildcardQuality;
+    return (std::max(quality, 0.0));
+}
+
+/// @brief Pick the encoding for a response from an Accept-Encoding header, gzip wins over deflate at equal quality.
+ContentEncoding ContentEncoder::negotiate(const std::string &acceptEncoding) {
+    double gzipQuality = getQuality(acceptEncoding, ContentEncoding::Gzip);
+    double deflateQuality = getQuality(acceptEncoding, ContentEncoding::Deflate);
+
+    if (gzipQuality > 0 && gzipQuality >= deflateQuality)
+        return (ContentEncoding::Gzip);
+    if (deflateQuality > 0)
+        return (ContentEncoding::Deflate);
+    return (ContentEncoding::Identity);
+}
+
+/// @brief Derive the validator of an encoded variant from the one of the file, e.g. "5f1-a9b" becomes "5f1-a9b-gzip".
+/// @details Variants differ in their bytes, so they can't share a strong validator with the file.
+std::string ContentEncoder::getVariantETag(const std::string &etag, ContentEncoding encoding) {
+    if (encoding == ContentEncoding::Identity || etag.size() < 2 || etag.back() != '"')
+        return (etag);
+
+    std::string variant = etag;
+    variant.insert(variant.size() - 1, std::string("-") + getName(encoding));
+    return (variant);
+}
+
+const char *ContentEncoder::getName(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::Gzip: return "gzip";
+        case ContentEncoding::Deflate: return "deflate";
+        case ContentEncoding::Identity: break ;
+    }
+    return "identity";
+}
@@ -34,18 +34,20 @@ std::string Cookie::getHeaderInitializationString() const {
 /// @brief Parses a cookie header value and creates a vector of Cookie objects.
 /// @param header_value The value of the Set-Cookie header from an HTTP response.
 /// @return A vector of Cookie objects parsed from the header value.
-std::vector<Cookie> Cookie::createAllFromHeader(const std::string &header_value) {
+std::vector<Cookie> Cookie::createAllFromHeader(std::string_view header_value) {
 	std::vector<Cookie> cookies;
 
-	std::vector<std::string> split = Utils::split(header_value, ';');
-	for (const std::string &cookie_str : split) {
+	while (!header_value.empty()) {
+		std::string_view cookie_str = header_value.substr(0, header_value.find(';'));
+		header_value.remove_prefix(std::min(header_value.size(), cookie_str.size() + 1));
+
 		size_t eq_pos = cookie_str.find('=');
-		if (eq_pos == std::string::npos) {
+		if (eq_pos == std::string_view::npos) {
 			DEBUG("Invalid cookie format: " << cookie_str);
 			continue;
 		}
-		std::string name = Utils::trim(cookie_str.substr(0, eq_pos));
-		std::string value = Utils::trim(cookie_str.substr(eq_pos + 1));
+		std::string name = Utils::trim(std::string(cookie_str.substr(0, eq_pos)));
+		std::string value = Utils::trim(std::string(cookie_str.substr(eq_pos + 1)));
 		cookies.push_back(Cookie::create(name, value));
 	}
 
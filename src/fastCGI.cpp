@@ -0,0 +1,548 @@
+#include "fastCGI.hpp"
+#include "server.hpp"
+#include "print.hpp"
+
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <sys/un.h>
+#include <charconv>
+#include <cstring>
+#include <netdb.h>
+
+#define FASTCGI_ROLE_RESPONDER 1
+#define FASTCGI_KEEP_CONN 1
+
+FastCGIConnection::FastCGIConnection(Server &server, const FastCGIPassRule &rule) :
+    _server(server),
+    _address(rule.getAddress()),
+    _fd(), _writer(), _output(),
+    _events(0),
+    _slots(), _activeRequests(0), _maxRequests(1),
+    _isConnecting(false), _isPaused(false), _isHungUp(false), _isClosed(false)
+{
+    if (!_connect(rule)) {
+        _isClosed = true;
+        return ;
+    }
+
+    // Until the application tells whether requests can share the connection, it takes one at a time
+    std::string values;
+    FastCGIRecord::appendPair(values, "FCGI_MPXS_CONNS", "");
+    FastCGIRecord::appendPair(values, "FCGI_MAX_REQS", "");
+    _queueRecord(FastCGIRecordType::GetValues, 0, values);
+
+    if (!_isConnecting)
+        _output.tick(_writer);
+    _updateEvents();
+}
+
+FastCGIConnection::~FastCGIConnection() {
+    // The server is going away as well, so the descriptor is only closed, not untracked
+    if (!_isClosed && _fd.isValidFd())
+        _fd.close();
+    for (Slot &slot : _slots)
+        _dropPendingOutput(slot);
+}
+
+/// @brief Open a non-blocking connection to the application and track it.
+/// @details The connect may still be in progress when this returns, records are queued until it completes.
+bool FastCGIConnection::_connect(const FastCGIPassRule &rule) {
+    int socketFd = -1;
+    int result = -1;
+
+    if (rule.isUnixSocket()) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (rule.getSocketPath().size() >= sizeof(address.sun_path)) {
+            ERROR("FastCGI socket path is too long: " << rule.getSocketPath());
+            return (false);
+        }
+        std::memcpy(address.sun_path, rule.getSocketPath().c_str(), rule.getSocketPath().size() + 1);
+
+        socketFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (socketFd != -1)
+            result = connect(socketFd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    } else {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_NUMERICSERV;
+
+        addrinfo *addresses = nullptr;
+        int error = getaddrinfo(rule.getHost().c_str(), rule.getPort().c_str(), &hints, &addresses);
+        if (error != 0) {
+            ERROR("Failed to resolve FastCGI application " << _address << ": " << gai_strerror(error));
+            return (false);
+        }
+
+        socketFd = socket(addresses->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (socketFd != -1) {
+            int enable = 1;
+            setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            result = connect(socketFd, addresses->ai_addr, addresses->ai_addrlen);
+        }
+        freeaddrinfo(addresses);
+    }
+
+    if (socketFd == -1 || (result == -1 && errno != EINPROGRESS)) {
+        ERROR("Failed to connect to FastCGI application " << _address << ": " << strerror(errno));
+        if (socketFd != -1)
+            ::close(socketFd);
+        return (false);
+    }
+
+    _isConnecting = (result == -1);
+    _fd = ReadableFD(socketFd, DEFAULT_MAX_BUFFER_SIZE, FDState::Awaiting);
+    _writer = FDWriter(socketFd, FDState::OtherFunctionality);
+
+    _events = EPOLLIN | EPOLLOUT;
+    if (_fd.connectToEpoll(_server.getEpollFd(), _events) == -1) {
+        ERROR("Failed to connect FastCGI connection to epoll: " << strerror(errno));
+        _fd.close();
+        return (false);
+    }
+
+    _server.trackCallbackFD(_fd, [this](ReadableFD &, short revents) {
+        _handleEvent(revents);
+    });
+    DEBUG("Connecting to FastCGI application " << _address << ", fd: " << _fd.get());
+    return (true);
+}
+
+void FastCGIConnection::_handleEvent(short revents) {
+    if (_isConnecting) {
+        if (!(revents & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+            return ;
+
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) == -1 || error != 0) {
+            ERROR("Failed to connect to FastCGI application " << _address << ": " << strerror(error ? error : errno));
+            return (close());
+        }
+        _isConnecting = false;
+    }
+
+    if (revents & EPOLLOUT) {
+        if (!_output.isEmpty())
+            _output.tick(_writer);
+        if (!isBacklogged())
+            _notifyWritable();
+        if (_isClosed)
+            return ;
+    }
+
+    if (!_isPaused && (revents & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+        _fd.read();
+
+    _handleRecords();
+    if (_isClosed)
+        return ;
+
+    // Records and output the handlers didn't take yet are still delivered once they resume
+    bool isDrained = (!_isPaused || _fd.getReadBufferSize() == 0) && !_hasPendingOutput();
+    if ((revents & EPOLLERR) || (_fd.getReaderFDState() == FDState::Closed && isDrained)) {
+        DEBUG("FastCGI application " << _address << " closed the connection");
+        return (close());
+    }
+    if ((revents & EPOLLHUP) || _fd.getReaderFDState() == FDState::Closed)
+        _isHungUp = true;
+
+    _updateEvents();
+}
+
+/// @brief Hand every complete record in the read buffer to the request it belongs to.
+void FastCGIConnection::_handleRecords() {
+    while (!_isClosed && !_isPaused) {
+        std::string_view buffer = _fd.peekReadBuffer();
+        if (buffer.size() < FASTCGI_HEADER_SIZE)
+            return ;
+
+        const unsigned char *header = reinterpret_cast<const unsigned char *>(buffer.data());
+        if (header[0] != FASTCGI_VERSION) {
+            ERROR("Invalid record from FastCGI application " << _address << ", version: " << static_cast<int>(header[0]));
+            return (close());
+        }
+
+        FastCGIRecordType type = static_cast<FastCGIRecordType>(header[1]);
+        uint16_t requestId = static_cast<uint16_t>((header[2] << 8) | header[3]);
+        size_t contentLength = (static_cast<size_t>(header[4]) << 8) | header[5];
+        size_t recordLength = FASTCGI_HEADER_SIZE + contentLength + header[6];
+        if (buffer.size() < recordLength)
+            return ;
+
+        std::string_view content = buffer.substr(FASTCGI_HEADER_SIZE, contentLength);
+        switch (type) {
+            case FastCGIRecordType::Stdout: {
+                if (requestId > 0 && requestId <= _slots.size() && _slots[requestId - 1].isActive && !content.empty()
+                    && !_handleOutput(requestId - 1, content)) {
+                    DEBUG("Pausing FastCGI connection to " << _address << " until request " << requestId << " takes more output");
+                    _isPaused = true;
+                    return ;
+                }
+                break ;
+            }
+
+            case FastCGIRecordType::Stderr: {
+                ERROR("FastCGI application " << _address << ": " << content);
+                break ;
+            }
+
+            case FastCGIRecordType::EndRequest: {
+                bool isComplete = content.size() >= 5
+                    && static_cast<FastCGIProtocolStatus>(content[4]) == FastCGIProtocolStatus::RequestComplete;
+                // The handler may close the connection, so the record is dropped before it runs
+                _fd.skipReadBuffer(recordLength);
+                if (requestId > 0 && requestId <= _slots.size() && _slots[requestId - 1].hasPendingOutput()) {
+                    // The request ends once its handler took the rest of its output
+                    _slots[requestId - 1].isEnded = true;
+                    _slots[requestId - 1].isComplete = isComplete;
+                    continue ;
+                }
+                _endRequest(requestId, isComplete);
+                continue ;
+            }
+
+            case FastCGIRecordType::GetValuesResult: {
+                _handleValues(content);
+                break ;
+            }
+
+            default: {
+                DEBUG("Ignoring FastCGI record of type: " << static_cast<int>(type));
+                break ;
+            }
+        }
+
+        _fd.skipReadBuffer(recordLength);
+    }
+}
+
+/// @brief Hand output to its request, what the handler refuses waits in the request's slot so the
+/// records of the other requests keep being read.
+/// @return false if the slot has no room left for it either, the record stays on the connection.
+bool FastCGIConnection::_handleOutput(size_t index, std::string_view content) {
+    // Output stays in order, once some waits everything after it does as well
+    if (!_slots[index].handler
+        || (!_slots[index].hasPendingOutput() && _slots[index].handler->handleFastCGIOutput(content)))
+        return (true);
+    // The handler may have aborted the request or closed the connection
+    if (_isClosed || !_slots[index].isActive || !_slots[index].handler)
+        return (true);
+
+    // A record always fits an empty slot, it's never larger than the limit
+    Slot &slot = _slots[index];
+    if (slot.pendingOutput.size() + content.size() > FASTCGI_MAX_PENDING_OUTPUT)
+        return (false);
+    slot.pendingOutput.append(content);
+    return (true);
+}
+
+void FastCGIConnection::_dropPendingOutput(Slot &slot) {
+    std::string().swap(slot.pendingOutput);
+}
+
+/// @brief Take over whether the application multiplexes, from its answer to FCGI_GET_VALUES.
+void FastCGIConnection::_handleValues(std::string_view content) {
+    bool isMultiplexing = false;
+    size_t maxRequests = FASTCGI_MAX_REQUESTS;
+    size_t offset = 0;
+
+    while (offset < content.size()) {
+        size_t nameLength, valueLength;
+        if (!FastCGIRecord::readPairLength(content, offset, nameLength)
+            || !FastCGIRecord::readPairLength(content, offset, valueLength)
+            || offset + nameLength + valueLength > content.size())
+            break ;
+
+        std::string_view name = content.substr(offset, nameLength);
+        std::string_view value = content.substr(offset + nameLength, valueLength);
+        offset += nameLength + valueLength;
+
+        if (name == "FCGI_MPXS_CONNS")
+            isMultiplexing = (value == "1");
+        else if (name == "FCGI_MAX_REQS")
+            std::from_chars(value.data(), value.data() + value.size(), maxRequests);
+    }
+
+    if (isMultiplexing)
+        _maxRequests = std::clamp<size_t>(maxRequests, 1, FASTCGI_MAX_REQUESTS);
+    DEBUG("FastCGI application " << _address << " takes " << _maxRequests << " request(s) per connection");
+}
+
+void FastCGIConnection::_endRequest(uint16_t requestId, bool isComplete) {
+    if (requestId == 0 || requestId > _slots.size() || !_slots[requestId - 1].isActive)
+        return ;
+
+    FastCGIRequestHandler *handler = _slots[requestId - 1].handler;
+    _dropPendingOutput(_slots[requestId - 1]);
+    _slots[requestId - 1] = Slot{};
+    --_activeRequests;
+    DEBUG("FastCGI request " << requestId << " on " << _address << " ended, complete: " << isComplete);
+
+    if (handler)
+        handler->handleFastCGIEnd(isComplete);
+}
+
+void FastCGIConnection::_notifyWritable() {
+    for (size_t i = 0; i < _slots.size() && !_isClosed && !isBacklogged(); ++i) {
+        if (_slots[i].isActive && _slots[i].handler)
+            _slots[i].handler->handleFastCGIWritable();
+    }
+}
+
+/// @brief Go over the connection again once a request took some of its pending output or was aborted.
+/// @details A record that still finds no room pauses the connection again.
+void FastCGIConnection::_wake() {
+    bool wasPaused = _isPaused;
+    _isPaused = false;
+    // Records already read, or a hang up while out of epoll, won't raise another event, the socket being writable does
+    if (wasPaused || (!_fd.isConnectedToEpoll() && !_hasPendingOutput()))
+        _updateEvents(EPOLLOUT);
+}
+
+bool FastCGIConnection::_hasPendingOutput() const {
+    return (std::any_of(_slots.begin(), _slots.end(), [](const Slot &slot) {
+        return (slot.hasPendingOutput());
+    }));
+}
+
+/// @brief Watch for what the connection waits on: records unless paused, and writability while bytes are queued.
+/// @details A hung up socket is reported whatever it's watched for, so it leaves epoll while nothing is read off it.
+void FastCGIConnection::_updateEvents(uint32_t extraEvents) {
+    if (_isClosed)
+        return ;
+
+    if (_isHungUp && extraEvents == 0 && (_isPaused || _fd.getReaderFDState() == FDState::Closed)) {
+        if (_fd.isConnectedToEpoll() && _fd.disconnectFromEpoll() == -1) {
+            ERROR("Failed to disconnect FastCGI connection to " << _address << " from epoll");
+            return (close());
+        }
+        return ;
+    }
+
+    uint32_t events = extraEvents;
+    if (!_isPaused)
+        events |= EPOLLIN;
+    if (_isConnecting || !_output.isEmpty())
+        events |= EPOLLOUT;
+
+    if (!_fd.isConnectedToEpoll()) {
+        if (_fd.connectToEpoll(_server.getEpollFd(), events) == -1) {
+            ERROR("Failed to reconnect FastCGI connection to " << _address << " to epoll");
+            return (close());
+        }
+        _events = events;
+        return ;
+    }
+
+    if (events == _events)
+        return ;
+    if (_fd.setEpollEvents(events) == -1) {
+        ERROR("Failed to update events of FastCGI connection to " << _address);
+        return (close());
+    }
+    _events = events;
+}
+
+/// @brief Queue a record, split in as many as it takes, without writing it yet.
+void FastCGIConnection::_queueRecord(FastCGIRecordType type, uint16_t requestId, std::string_view content) {
+    FastCGIRecord::split(type, requestId, content, [this](std::string_view header, std::string_view part) {
+        _output.queue(header);
+        _output.queue(part);
+    });
+}
+
+/// @brief Write a record along with whatever is queued, only what the socket doesn't take is copied.
+void FastCGIConnection::_sendRecord(FastCGIRecordType type, uint16_t requestId, std::string_view content) {
+    FastCGIRecord::split(type, requestId, content, [this](std::string_view header, std::string_view part) {
+        _output.queue(header);
+        if (_isConnecting)
+            _output.queue(part);
+        else
+            _output.sendBodyAsString(part, _writer);
+    });
+
+    _updateEvents();
+}
+
+/// @brief Start a request as a responder and send its parameters, the KEY=VALUE entries of its CGI environment.
+/// @return The ID the request has on this connection, 0 if it can't take one.
+uint16_t FastCGIConnection::beginRequest(FastCGIRequestHandler &handler, const std::vector<std::string> &environment) {
+    if (!canTakeRequest())
+        return (0);
+
+    size_t index = 0;
+    while (index < _slots.size() && _slots[index].isActive)
+        ++index;
+    if (index == _slots.size())
+        _slots.push_back(Slot{});
+    _slots[index] = Slot{};
+    _slots[index].handler = &handler;
+    _slots[index].isActive = true;
+    ++_activeRequests;
+    uint16_t requestId = static_cast<uint16_t>(index + 1);
+
+    // The role, and FCGI_KEEP_CONN so the application leaves the connection open for the next request
+    const char beginRequestBody[8] = {0, FASTCGI_ROLE_RESPONDER, FASTCGI_KEEP_CONN, 0, 0, 0, 0, 0};
+    _queueRecord(FastCGIRecordType::BeginRequest, requestId, std::string_view(beginRequestBody, sizeof(beginRequestBody)));
+
+    std::string encodedParams;
+    for (std::string_view variable : environment) {
+        size_t separator = variable.find('=');
+        if (separator != std::string_view::npos)
+            FastCGIRecord::appendPair(encodedParams, variable.substr(0, separator), variable.substr(separator + 1));
+    }
+    if (!encodedParams.empty())
+        _queueRecord(FastCGIRecordType::Params, requestId, encodedParams);
+    // An empty record ends the stream
+    _queueRecord(FastCGIRecordType::Params, requestId, "");
+
+    if (!_isConnecting)
+        _output.tick(_writer);
+    _updateEvents();
+
+    DEBUG("Began FastCGI request " << requestId << " on " << _address << ", fd: " << _fd.get());
+    return (requestId);
+}
+
+/// @brief Send request body bytes, an empty string ends the body.
+void FastCGIConnection::sendStdin(uint16_t requestId, std::string_view data) {
+    if (_isClosed || requestId == 0 || requestId > _slots.size() || !_slots[requestId - 1].isActive)
+        return ;
+    _sendRecord(FastCGIRecordType::Stdin, requestId, data);
+}
+
+/// @brief Give up on a request that hasn't ended, nothing it sends anymore is delivered.
+/// @details Without multiplexing the connection is closed instead, nothing else could use it until the
+/// application got to the abort, which it might only do once the script finished anyway.
+void FastCGIConnection::abortRequest(uint16_t requestId) {
+    if (_isClosed || requestId == 0 || requestId > _slots.size() || !_slots[requestId - 1].isActive)
+        return ;
+
+    Slot &slot = _slots[requestId - 1];
+    slot.handler = nullptr;
+    _dropPendingOutput(slot);
+    if (slot.isEnded) {
+        // The application ended it already, only its output was left
+        _endRequest(requestId, false);
+        return (_wake());
+    }
+    if (_maxRequests == 1)
+        return (close());
+
+    // The ID stays taken until the application confirms with FCGI_END_REQUEST
+    _sendRecord(FastCGIRecordType::AbortRequest, requestId, "");
+    // It may have been the request the connection was paused for, its output is dropped from now on
+    _wake();
+}
+
+/// @brief Deliver the output a request's handler refused, once it has room again.
+void FastCGIConnection::resume(uint16_t requestId) {
+    if (_isClosed || requestId == 0 || requestId > _slots.size() || !_slots[requestId - 1].hasPendingOutput())
+        return ;
+
+    // Taken out of the slot while the handler runs, an abort from it drops the slot's output
+    size_t index = requestId - 1;
+    std::string pending = std::move(_slots[index].pendingOutput);
+    _slots[index].pendingOutput.clear();
+
+    // In parts no larger than a record, as the handler would have gotten them
+    size_t offset = 0;
+    while (offset < pending.size() && _slots[index].handler) {
+        std::string_view part = std::string_view(pending).substr(offset, FASTCGI_MAX_CONTENT_LENGTH);
+        if (!_slots[index].handler->handleFastCGIOutput(part))
+            break ;
+        offset += part.size();
+        if (_isClosed || !_slots[index].isActive)
+            return ;
+    }
+    if (offset < pending.size()) {
+        if (_slots[index].handler) {
+            pending.erase(0, offset);
+            _slots[index].pendingOutput = std::move(pending);
+        }
+        return (_wake());
+    }
+
+    if (_slots[index].isEnded)
+        _endRequest(requestId, _slots[index].isComplete);
+    if (!_isClosed)
+        _wake();
+}
+
+/// @brief Close the connection, the requests still on it end incomplete.
+void FastCGIConnection::close() {
+    if (_isClosed)
+        return ;
+
+    _isClosed = true;
+    if (_fd.isValidFd()) {
+        _server.untrackCallbackFD(_fd);
+        _fd.close();
+    }
+
+    std::vector<FastCGIRequestHandler *> handlers;
+    for (Slot &slot : _slots) {
+        if (slot.isActive && slot.handler)
+            handlers.push_back(slot.handler);
+        _dropPendingOutput(slot);
+        slot = Slot{};
+    }
+    _activeRequests = 0;
+
+    for (FastCGIRequestHandler *handler : handlers)
+        handler->handleFastCGIEnd(false);
+}
+
+/// @details Not while a request on it has output waiting for its handler, the connection may have to stop reading
+/// for it, nor once the application hung up. A new request would wait as well, the pool opens another connection.
+bool FastCGIConnection::canTakeRequest() const {
+    return (!_isClosed && !_isPaused && !_isHungUp && !_hasPendingOutput() && _activeRequests < _maxRequests);
+}
+
+/// @brief Whether enough is queued that request bodies should wait until the application caught up.
+bool FastCGIConnection::isBacklogged() const {
+    return (_output.getPendingSize() > FASTCGI_MAX_BACKLOG);
+}
+
+bool FastCGIConnection::isClosed() const {
+    return (_isClosed);
+}
+
+FastCGIPool::FastCGIPool(Server &server) : _server(server), _connections() {}
+
+/// @brief A connection to the application of the rule with room for another request.
+/// @return nullptr if none could be opened.
+FastCGIConnection *FastCGIPool::acquire(const FastCGIPassRule &rule) {
+    std::vector<std::unique_ptr<FastCGIConnection>> &connections = _connections[rule.getAddress()];
+    std::erase_if(connections, [](const std::unique_ptr<FastCGIConnection> &connection) {
+        return (connection->isClosed());
+    });
+
+    for (const std::unique_ptr<FastCGIConnection> &connection : connections) {
+        if (connection->canTakeRequest())
+            return (connection.get());
+    }
+
+    if (connections.size() >= FASTCGI_MAX_CONNECTIONS) {
+        ERROR("All " << FASTCGI_MAX_CONNECTIONS << " connections to FastCGI application " << rule.getAddress() << " are busy");
+        return (nullptr);
+    }
+
+    std::unique_ptr<FastCGIConnection> connection = std::make_unique<FastCGIConnection>(_server, rule);
+    if (connection->isClosed())
+        return (nullptr);
+
+    connections.push_back(std::move(connection));
+    return (connections.back().get());
+}
+
+void FastCGIPool::clear() {
+    for (auto &[address, connections] : _connections) {
+        for (std::unique_ptr<FastCGIConnection> &connection : connections)
+            connection->close();
+    }
+    _connections.clear();
+}
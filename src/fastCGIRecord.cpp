@@ -0,0 +1,51 @@
+#include "fastCGIRecord.hpp"
+
+void FastCGIRecord::formatHeader(char (&header)[FASTCGI_HEADER_SIZE], FastCGIRecordType type, uint16_t requestId, size_t contentLength) {
+    header[0] = FASTCGI_VERSION;
+    header[1] = static_cast<char>(type);
+    header[2] = static_cast<char>(requestId >> 8);
+    header[3] = static_cast<char>(requestId & 0xff);
+    header[4] = static_cast<char>(contentLength >> 8);
+    header[5] = static_cast<char>(contentLength & 0xff);
+    header[6] = 0; // padding length
+    header[7] = 0; // reserved
+}
+
+/// @brief Append the length of a name or value of a name-value pair: one byte below 128, four otherwise.
+void FastCGIRecord::appendPairLength(std::string &buffer, size_t length) {
+    if (length < 0x80) {
+        buffer.push_back(static_cast<char>(length));
+        return ;
+    }
+    buffer.push_back(static_cast<char>(0x80 | ((length >> 24) & 0x7f)));
+    buffer.push_back(static_cast<char>((length >> 16) & 0xff));
+    buffer.push_back(static_cast<char>((length >> 8) & 0xff));
+    buffer.push_back(static_cast<char>(length & 0xff));
+}
+
+void FastCGIRecord::appendPair(std::string &buffer, std::string_view name, std::string_view value) {
+    appendPairLength(buffer, name.size());
+    appendPairLength(buffer, value.size());
+    buffer.append(name).append(value);
+}
+
+/// @brief Read the length at `offset`, advancing it past the length.
+/// @return false, leaving `offset` as is, if the content ends before the length does.
+bool FastCGIRecord::readPairLength(std::string_view content, size_t &offset, size_t &length) {
+    if (offset >= content.size())
+        return (false);
+
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(content.data()) + offset;
+    if (bytes[0] < 0x80) {
+        length = bytes[0];
+        offset += 1;
+        return (true);
+    }
+
+    if (offset + 4 > content.size())
+        return (false);
+    length = (static_cast<size_t>(bytes[0] & 0x7f) << 24) | (static_cast<size_t>(bytes[1]) << 16)
+        | (static_cast<size_t>(bytes[2]) << 8) | bytes[3];
+    offset += 4;
+    return (true);
+}
@@ -1,3 +1,4 @@
+#include "ioUring.hpp"
 #include "print.hpp"
 #include "fd.hpp"
 
@@ -9,6 +10,8 @@
 #include <string>
 #include <memory>
 
+IOUring *FD::_submissionRing = nullptr;
+
 FD::FD() : _fd(-1), _epollFd(-1) {}
 
 FD::FD(int fd)
@@ -25,6 +28,13 @@ bool FD::operator<(int otherFd) const {
 FD::~FD() {}
 
 int FD::p_cleanUp() {
+    if (_submissionRing && isValidFd()
+        && _submissionRing->queueClose(_fd, _epollFd)) {
+        _epollFd = -1;
+        _fd = -1;
+        return (0);
+    }
+
     if (isConnectedToEpoll())
         ERROR_IF(disconnectFromEpoll() == -1, "Failed to disconnect fd: " << _fd << " from epoll");
 
@@ -64,6 +74,11 @@ int FD::p_connectToEpoll(int epoll_fd, uint32_t events) {
         return -1;
     }
 
+    if (_submissionRing && _submissionRing->queueEpollCtl(epoll_fd, EPOLL_CTL_ADD, _fd, events)) {
+        _epollFd = epoll_fd;
+        return (0);
+    }
+
     epoll_event event{};
     event.events = events;
     event.data.fd = _fd;
@@ -81,6 +96,11 @@ int FD::disconnectFromEpoll() {
         return -1;
     }
 
+    if (_submissionRing && _submissionRing->queueEpollCtl(_epollFd, EPOLL_CTL_DEL, _fd, 0)) {
+        _epollFd = -1;
+        return (0);
+    }
+
     int result = epoll_ctl(_epollFd, EPOLL_CTL_DEL, _fd, nullptr);
     if (result == -1) {
         ERROR("Failed to disconnect fd: " << _fd << " from epoll, errno: " << errno << " (" << strerror(errno) << ")");
@@ -100,6 +120,9 @@ int FD::p_setEpollEvents(uint32_t events) {
         return -1;
     }
 
+    if (_submissionRing && _submissionRing->queueEpollCtl(_epollFd, EPOLL_CTL_MOD, _fd, events))
+        return (0);
+
     epoll_event event{};
     event.events = events;
     event.data.fd = _fd;
@@ -132,6 +155,19 @@ int FD::close() {
     return (p_cleanUp());
 }
 
+/// @brief Route epoll updates and closes of every FD through an io_uring submission queue.
+/// @details Queued operations only take effect once the ring is submitted, which the
+/// server does right before it waits for events. Passing nullptr restores direct syscalls.
+void FD::useSubmissionRing(IOUring *ring) {
+    _submissionRing = ring;
+}
+
+/// @brief Submit every queued epoll update and close right away, e.g. before forking.
+void FD::flushSubmissionRing() {
+    if (_submissionRing)
+        _submissionRing->submit();
+}
+
 ReadableFD::ReadableFD() 
     : FD(), FDReader() {
 }
@@ -1,8 +1,14 @@
 #include "print.hpp"
 #include "fd.hpp"
 
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <string_view>
+#include <system_error>
+#include <algorithm>
+#include <stdexcept>
 #include <unistd.h>
+#include <charconv>
 #include <fcntl.h>
 #include <string>
 #include <chrono>
@@ -19,6 +25,13 @@ FDReader::FDReader()
 FDReader::FDReader(int fd, int maxBufferSize, FDState state)
     : _fd(fd), _maxBufferSize(maxBufferSize), _readBuffer(), _state(state), _lastReadTime(std::chrono::steady_clock::time_point::max()), _totalReadBytes(0), _totalBodyBytes(0), _isLastChunkRead(false) {}
 
+/// @brief Parse the hexadecimal size at the start of a chunk-size line, ignoring chunk extensions.
+/// @return false if the line does not start with a valid size.
+static bool parse_chunk_size(std::string_view line, size_t &chunkSize) {
+    std::from_chars_result result = std::from_chars(line.data(), line.data() + line.size(), chunkSize, 16);
+    return (result.ec == std::errc() && result.ptr != line.data());
+}
+
 ssize_t FDReader::read() {
     if (_fd < 0) {
         ERROR("Trying to read from an invalid file descriptor");
@@ -31,12 +44,12 @@ ssize_t FDReader::read() {
         return -1;
     }
 
-    char buffer[READ_BUFFER_SIZE];
-    ssize_t bytesRead = ::read(_fd, buffer, sizeof(buffer));
+    // Read straight into the tail of the buffer, no intermediate copy
+    ssize_t bytesRead = ::read(_fd, _readBuffer.prepareWrite(READ_BUFFER_SIZE), READ_BUFFER_SIZE);
     DEBUG("Bytes read: " << bytesRead << " from fd: " << _fd);
 
     if (bytesRead > 0) {
-        _readBuffer.append(buffer, bytesRead);
+        _readBuffer.commitWrite(bytesRead);
         _totalReadBytes += bytesRead;
         _lastReadTime = std::chrono::steady_clock::now();
         DEBUG("Read " << bytesRead << " bytes from fd: " << _fd);
@@ -81,32 +94,71 @@ FDState FDReader::getReaderFDState() const {
     return (FDReader::_state);
 }
 
-const std::string &FDReader::peekReadBuffer() const {
-    return (_readBuffer);
+/// @brief View of the buffered data, valid until the next read or extraction.
+std::string_view FDReader::peekReadBuffer() const {
+    return (_readBuffer.view());
+}
+
+/// @brief View of at most `maxSize` bytes of buffered data, valid until the next read or extraction.
+std::string_view FDReader::peekReadBuffer(size_t maxSize) const {
+    return (_readBuffer.view(maxSize));
+}
+
+/// @brief Drop body bytes from the front of the buffer after they were handled through a view.
+void FDReader::consumeReadBuffer(size_t size) {
+    size = std::min(size, _readBuffer.size());
+    _readBuffer.consume(size);
+    _totalBodyBytes += size;
+}
+
+/// @brief Add bytes that arrived by other means than reading the descriptor, as if they had been read.
+/// @details Lets data demultiplexed from a shared connection go through the same buffer as a pipe's.
+void FDReader::appendToReadBuffer(std::string_view data) {
+    _readBuffer.append(data);
+    _totalReadBytes += static_cast<ssize_t>(data.size());
+    _lastReadTime = std::chrono::steady_clock::now();
+}
+
+/// @brief Count body bytes that were moved off the descriptor without passing the buffer (splice), as read and consumed.
+void FDReader::countBypassedBodyBytes(size_t size) {
+    _totalReadBytes += static_cast<ssize_t>(size);
+    _totalBodyBytes += static_cast<ssize_t>(size);
+    _lastReadTime = std::chrono::steady_clock::now();
+}
+
+/// @brief Drop bytes that aren't body, such as a parsed request head, from the front of the buffer.
+void FDReader::skipReadBuffer(size_t size) {
+    _readBuffer.consume(size);
 }
 
 std::string FDReader::extractHeadersFromReadBuffer() {
-    size_t pos = _readBuffer.find("\r\n\r\n");
-    if (pos != std::string::npos) {
-        std::string headerStr = _readBuffer.substr(0, pos);
-        _readBuffer.erase(0, pos + 4);
+    size_t pos = _readBuffer.scan("\r\n\r\n");
+    if (pos != std::string_view::npos) {
+        std::string headerStr(_readBuffer.view(pos));
+        _readBuffer.consume(pos + 4);
         return (headerStr);
     }
 
     return (std::string());
 }
 
+/// @brief Whether the buffer holds a complete head, without extracting it.
+/// @details Bytes searched by an earlier call aren't searched again.
+bool FDReader::hasHeadersInReadBuffer() {
+    return (_readBuffer.scan("\r\n\r\n") != std::string_view::npos);
+}
+
 FDReader::HTTPChunk FDReader::extractHTTPChunkFromReadBuffer() {
-    size_t sizeSepPos = _readBuffer.find("\r\n");
-    if (sizeSepPos != std::string::npos) {
-        ssize_t chunkSize = 0;
-        try { chunkSize = std::stoul(_readBuffer.substr(0, sizeSepPos), nullptr, 16); }
-        catch (...) { throw std::runtime_error("Invalid chunk size format in buffer"); }
+    size_t sizeSepPos = _readBuffer.scan("\r\n");
+    if (sizeSepPos != std::string_view::npos) {
+        size_t chunkSize = 0;
+        if (!parse_chunk_size(_readBuffer.view(sizeSepPos), chunkSize))
+            throw std::runtime_error("Invalid chunk size format in buffer");
         size_t minBuffLen = sizeSepPos + 4 + chunkSize;
         if (_readBuffer.size() >= minBuffLen) {
-            _readBuffer.erase(0, sizeSepPos + 2);
+            _readBuffer.consume(sizeSepPos + 2);
             std::string chunkData = extractChunkFromReadBuffer(chunkSize);
-            _readBuffer.erase(0, 2);
+            _readBuffer.consume(2);
             if (chunkSize == 0)
                 _isLastChunkRead = true;
             return HTTPChunk(std::move(chunkData), chunkSize);
@@ -115,26 +167,30 @@ FDReader::HTTPChunk FDReader::extractHTTPChunkFromReadBuffer() {
     return HTTPChunk("", HTTPChunk::noChunk);
 }
 
-FDReader::HTTPChunkStatus FDReader::returnHTTPChunkStatus() const {
+FDReader::HTTPChunkStatus FDReader::returnHTTPChunkStatus() {
     DEBUG("Call the chunk checker; len remaining buff: " << _readBuffer.size());
-    size_t sizePos = _readBuffer.find("\r\n");
-    ssize_t chunkSize = 0;
+    std::string_view buffer = _readBuffer.view();
+    size_t sizePos = _readBuffer.scan("\r\n");
+    size_t chunkSize = 0;
 
-    if (_readBuffer.empty())
+    if (buffer.empty())
         return (HTTPChunkStatus::Ok);
 
-    try {   size_t chunkStartPos = 0;
-            chunkSize = std::stoul(_readBuffer.substr(chunkStartPos, sizePos), nullptr, 16); }
-    catch (...) { return (HTTPChunkStatus::Error); }
+    if (!parse_chunk_size(buffer.substr(0, sizePos), chunkSize))
+        return (HTTPChunkStatus::Error);
 
     if (chunkSize > MAX_ACCEPT_CHUNK_SIZE)
         return (HTTPChunkStatus::TooLarge);
 
+    // Extensions could otherwise grow the size line up to the whole buffer
+    if (sizePos == std::string_view::npos)
+        return (buffer.size() > MAX_CHUNK_SIZE_LINE ? HTTPChunkStatus::Error : HTTPChunkStatus::Ok);
+
     size_t minBuffLen = sizePos + 4 + chunkSize;
-    if (_readBuffer.size() < minBuffLen)
+    if (buffer.size() < minBuffLen)
         return (HTTPChunkStatus::Ok);
 
-    if (_readBuffer.compare(sizePos + 2 + chunkSize, 2, "\r\n") != 0)
+    if (buffer.compare(sizePos + 2 + chunkSize, 2, "\r\n") != 0)
         return (HTTPChunkStatus::Error);
 
     return (HTTPChunkStatus::Ok);
@@ -144,17 +200,17 @@ std::string FDReader::extractChunkFromReadBuffer(size_t chunkSize) {
     if (chunkSize > _readBuffer.size())
         chunkSize = _readBuffer.size();
 
-    std::string chunk = _readBuffer.substr(0, chunkSize);
-    _readBuffer.erase(0, chunkSize);
+    std::string chunk(_readBuffer.view(chunkSize));
+    _readBuffer.consume(chunkSize);
     _totalBodyBytes += chunkSize;
     DEBUG("Extracted chunk of size: " << chunkSize << " from buffer");
     return (chunk);
 }
 
 std::string FDReader::extractFullBuffer() {
-    std::string fullBuffer = std::move(_readBuffer);
+    std::string fullBuffer(_readBuffer.view());
     _totalReadBytes += fullBuffer.size();
-    _readBuffer = std::string();
+    _readBuffer.clear();
     return (fullBuffer);
 }
 
@@ -184,12 +240,12 @@ FDWriter::FDWriter() : _fd(-1), _state(FDState::Invalid) {}
 
 FDWriter::FDWriter(int fd, FDState state) : _fd(fd), _state(state) {}
 
-ssize_t FDWriter::writeAsString(const std::string &data) {
+ssize_t FDWriter::writeAsString(std::string_view data) {
     if (_fd < 0) {
         ERROR("Trying to write to an invalid file descriptor");
         return -1;
     }
-    ssize_t bytesWritten = ::write(_fd, data.c_str(), data.size());
+    ssize_t bytesWritten = ::write(_fd, data.data(), data.size());
     if (bytesWritten < 0)
         FDWriter::_state = FDState::Awaiting;
     if (bytesWritten == 0)
@@ -199,19 +255,59 @@ ssize_t FDWriter::writeAsString(const std::string &data) {
     return (bytesWritten);
 }
 
-ssize_t FDWriter::writeAsChunk(const std::string &data) {
+/// @brief Copy a range of a file straight to this descriptor with sendfile(2), bypassing user space.
+/// @param fileFd The file to read from, it has to support mmap-like operations (a regular file).
+/// @param offset The file offset to start at, advanced by the amount of bytes written.
+/// @param count The maximum amount of bytes to write.
+/// @return The amount of bytes written, 0 if the file has no more data, or -1 on error.
+ssize_t FDWriter::writeFromFile(int fileFd, off_t &offset, size_t count) {
     if (_fd < 0) {
         ERROR("Trying to write to an invalid file descriptor");
         return -1;
     }
 
-    std::stringstream ss;
-    ss << std::hex << data.size();
-    ss << "\r\n";
-    ss << data;
-    ss << "\r\n";
+    ssize_t bytesWritten = ::sendfile(_fd, fileFd, &offset, count);
+    if (bytesWritten < 0)
+        FDWriter::_state = FDState::Awaiting;
+
+    DEBUG("Sent " << bytesWritten << " bytes from file fd: " << fileFd << " to fd: " << _fd);
+    return (bytesWritten);
+}
+
+/// @brief Write several buffers with a single writev(2), in order.
+/// @param hasMore Only for sockets: more data follows right away (e.g. the file after a head), so the
+/// kernel holds these bytes back to send them in the same segment (MSG_MORE) instead of on their own.
+/// @return The total amount of bytes written, which may end in the middle of any buffer, or -1 on error.
+ssize_t FDWriter::writeAsVector(const iovec *vectors, int count, bool hasMore) {
+    if (_fd < 0) {
+        ERROR("Trying to write to an invalid file descriptor");
+        return -1;
+    }
+
+    ssize_t bytesWritten;
+    if (hasMore) {
+        msghdr message{};
+        message.msg_iov = const_cast<iovec *>(vectors);
+        message.msg_iovlen = static_cast<size_t>(count);
+        bytesWritten = ::sendmsg(_fd, &message, MSG_MORE);
+    } else
+        bytesWritten = ::writev(_fd, vectors, count);
+    if (bytesWritten < 0)
+        FDWriter::_state = FDState::Awaiting;
+    if (bytesWritten == 0)
+        FDWriter::_state = FDState::Closed;
+
+    DEBUG("Wrote " << bytesWritten << " bytes from " << count << " buffers to fd: " << _fd);
+    return (bytesWritten);
+}
 
-    return (writeAsString(ss.str()));
+/// @brief Write the size line of an HTTP chunk ("<hex size>\r\n") into a fixed buffer.
+/// @return Its length.
+size_t FDWriter::formatChunkHeader(char (&buffer)[HTTP_CHUNK_HEADER_SIZE], size_t size) {
+    char *end = std::to_chars(buffer, buffer + HTTP_CHUNK_HEADER_SIZE - 2, size, 16).ptr;
+    *end++ = '\r';
+    *end++ = '\n';
+    return (static_cast<size_t>(end - buffer));
 }
 
 void FDWriter::setWriterFDState(FDState state) {
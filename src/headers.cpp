@@ -2,26 +2,22 @@
 #include "print.hpp"
 #include "Utils.hpp"
 
-#include <map>
-#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <strings.h>
 #include <string>
 #include <sstream>
 
-Headers::Headers(): _headers() {}
-
-static std::string removePortFromHostValue(const std::string& value)
+static std::string_view remove_port_from_host_value(std::string_view value)
 {
-    std::size_t pos = value.find(":");
-
-    if (pos == std::string::npos)
-        return (value);
-    return (value.substr(0, pos));
+    return (value.substr(0, value.find(':')));
 }
 
-Headers::Headers(std::istringstream &source) {
+Headers::Headers() : _fields(), _arena() {}
+
+Headers::Headers(std::istringstream &source) : _fields(), _arena() {
     std::string line;
     bool first_line = true;
-    constexpr std::string_view host_string = "Host";
 
     while (std::getline(source, line, '\n')) {
         line = Utils::trim(line);
@@ -38,111 +34,194 @@ Headers::Headers(std::istringstream &source) {
             continue;
         }
 
-        std::string key = Utils::trim(line.substr(0, colon));
-        std::string value = Utils::trim(line.substr(colon + 1));
-        if (key == host_string)
-            value = removePortFromHostValue(value);
-        add(key, value);
+        add(Utils::trim(line.substr(0, colon)), Utils::trim(line.substr(colon + 1)));
     }
 }
 
-Headers::Headers(const Headers &other) : _headers(other._headers) {}
+/// @brief Copy the header fields found by the RequestParser out of the request buffer.
+Headers::Headers(const RequestParser &parser, std::string_view buffer) : _fields(), _arena() {
+    const std::vector<RequestParser::Field> &fields = parser.getFields();
+    size_t arenaSize = 0;
+    for (const RequestParser::Field &field : fields)
+        arenaSize += field.name.length + field.value.length;
+
+    _fields.reserve(fields.size());
+    _arena.reserve(arenaSize);
+    for (const RequestParser::Field &field : fields)
+        add(field.name.in(buffer), field.value.in(buffer));
+}
+
+Headers::Headers(const Headers &other) : _fields(other._fields), _arena(other._arena) {}
 
 Headers &Headers::operator=(const Headers &other) {
     if (this != &other) {
-        _headers = other._headers;
+        _fields = other._fields;
+        _arena = other._arena;
     }
     return *this;
 }
 
 Headers::~Headers() {}
 
-/// @brief Checks if the headers map is empty.
+/// @brief Checks if there is any header.
 bool Headers::isValid() const {
-    return !_headers.empty();
+    return !_fields.empty();
 }
 
-/// @brief Adds a new header.
-void Headers::add(const std::string &key, const std::string &value) {
-    _headers.insert(std::make_pair(key, value));
+/// @brief Copy text to the end of the arena.
+/// @return Its offset in the arena.
+uint32_t Headers::_store(std::string_view text) {
+    uint32_t offset = static_cast<uint32_t>(_arena.size());
+    _arena.append(text);
+    return (offset);
+}
+
+void Headers::_add(HeaderKey key, std::string_view name, std::string_view value, uint32_t nameHash) {
+    // The Host of a request is only ever compared against server names, which have no port
+    if (key == HeaderKey::Host)
+        value = remove_port_from_host_value(value);
+
+    // A value viewing the arena itself, like the old value passed to replace(), would dangle once it grows
+    std::string copy;
+    std::less<const char *> before;
+    if (!before(value.data(), _arena.data()) && before(value.data(), _arena.data() + _arena.size())) {
+        copy = value;
+        value = copy;
+    }
+
+    // A response gets its headers one by one, size it once for the usual amount instead of growing it
+    if (_fields.capacity() == 0)
+        _fields.reserve(HEADERS_INITIAL_FIELDS);
+    if (_arena.capacity() < HEADERS_INITIAL_ARENA_SIZE && _arena.size() + name.size() + value.size() > _arena.capacity())
+        _arena.reserve(HEADERS_INITIAL_ARENA_SIZE);
+
+    Field field{key, 0, 0, 0, 0, static_cast<uint32_t>(value.size())};
+    if (key == HeaderKey::Unknown) {
+        field.nameHash = nameHash;
+        field.nameOffset = _store(name);
+        field.nameLength = static_cast<uint32_t>(name.size());
+    }
+    field.valueOffset = _store(value);
+    _fields.push_back(field);
+}
+
+/// @brief Adds a new header, by its name as it arrived.
+void Headers::add(std::string_view name, std::string_view value) {
+    uint32_t hash = hashHeaderName(name);
+    _add(stringToHeaderKey(name, hash), name, value, hash);
 }
 
 /// @brief Adds a new header.
-void Headers::add(HeaderKey key, const std::string &value) {
-    _headers.insert(std::make_pair(headerKeyToString(key), value));
+void Headers::add(HeaderKey key, std::string_view value) {
+    _add(key, std::string_view(), value, 0);
 }
 
-/// @brief Removes a header by its key.
-/// @param key The key of the header to remove.
-void Headers::remove(HeaderKey key) {
-    std::string keyStr = headerKeyToString(key);
-    auto it = _headers.find(keyStr);
-    if (it != _headers.end()) {
-        _headers.erase(it);
+void Headers::_removeAll(HeaderKey key) {
+    for (size_t i = 0; i < _fields.size(); ) {
+        if (_fields[i].key == key)
+            _fields.erase(_fields.begin() + static_cast<std::ptrdiff_t>(i));
+        else
+            ++i;
     }
 }
 
+/// @brief Removes every header with this key.
+/// @details Their bytes stay in the arena until the headers go away, a response only drops a few.
+void Headers::remove(HeaderKey key) {
+    _removeAll(key);
+}
+
 /// @brief Replaces the value of an existing header - even if multiple headers have been set already.
-void Headers::replace(HeaderKey key, const std::string &value) {
-    std::string keyStr = headerKeyToString(key);
-    _headers.erase(keyStr);
-    _headers.insert(std::make_pair(keyStr, value));
+void Headers::replace(HeaderKey key, std::string_view value) {
+    _removeAll(key);
+    add(key, value);
+}
+
+std::vector<Headers::Field>::const_iterator Headers::_find(HeaderKey key) const {
+    for (auto it = _fields.begin(); it != _fields.end(); ++it) {
+        if (it->key == key)
+            return (it);
+    }
+    return (_fields.end());
+}
+
+std::vector<Headers::Field>::const_iterator Headers::_find(std::string_view name) const {
+    uint32_t hash = hashHeaderName(name);
+    HeaderKey key = stringToHeaderKey(name, hash);
+    if (key != HeaderKey::Unknown)
+        return (_find(key));
+
+    for (auto it = _fields.begin(); it != _fields.end(); ++it) {
+        if (it->key == HeaderKey::Unknown && it->nameHash == hash && it->nameLength == name.size()
+            && strncasecmp(_arena.data() + it->nameOffset, name.data(), name.size()) == 0)
+            return (it);
+    }
+    return (_fields.end());
 }
 
 /// @brief Retrieves the value of a header by its key. Throws if the key does not exist.
-const std::string &Headers::getHeader(HeaderKey key) const {
-    auto it = _headers.find(headerKeyToString(key));
-    if (it != _headers.end())
-        return it->second;
-    throw std::out_of_range("Header not found: " + headerKeyToString(key));
+std::string_view Headers::getHeader(HeaderKey key) const {
+    auto it = _find(key);
+    if (it != _fields.end())
+        return (_valueOf(*it));
+    throw std::out_of_range("Header not found: " + std::string(headerKeyToString(key)));
 }
 
 /// @brief Retrieves the value of a header by its key, returning a default value
 /// if the key does not exist.
-const std::string &Headers::getHeader(HeaderKey key, const std::string &default_value) const {
-    auto it = _headers.find(headerKeyToString(key));
-    if (it != _headers.end())
-        return it->second;
-    return default_value;
+std::string_view Headers::getHeader(HeaderKey key, std::string_view default_value) const {
+    auto it = _find(key);
+    if (it != _fields.end())
+        return (_valueOf(*it));
+    return (default_value);
+}
+
+/// @brief Retrieves the value of a header by its name in any case, returning a default value
+/// if there is no such header.
+std::string_view Headers::getHeader(std::string_view name, std::string_view default_value) const {
+    auto it = _find(name);
+    if (it != _fields.end())
+        return (_valueOf(*it));
+    return (default_value);
 }
 
 /// @brief Merges another Headers object into this one, adding all headers from the other object.
 /// This will not overwrite existing headers, but will add new ones.
 /// @param other The Headers object to merge
 void Headers::merge(const Headers &other) {
-    for (const auto &header : other.getHeaders()) {
-        _headers.insert(header);
-    }
+    _fields.reserve(_fields.size() + other._fields.size());
+    for (const Field &field : other._fields)
+        _add(field.key, other._nameOf(field), other._valueOf(field), field.nameHash);
 }
 
-const std::string Headers::getAndRemoveHeader(HeaderKey key, const std::string &default_value) {
-
-    auto it = _headers.find(headerKeyToString(key));
-    if (it != _headers.end()) {
-        std::string result;
-        result = it->second;
-        _headers.erase(it);
-        return (result);
-    }
-
-    return (default_value);
+/// @brief Amount of bytes appendTo() adds.
+size_t Headers::getSerializedLength() const {
+    size_t length = 0;
+    for (const Field &field : _fields)
+        length += _nameOf(field).size() + 2 + field.valueLength + 2;
+    return (length);
 }
 
-/// @brief Returns a constant reference to the internal headers map.
-const std::multimap<std::string, std::string> &Headers::getHeaders() const {
-    return (_headers);
+/// @brief Append every header as a "Key: value" line to a buffer, growing it at most once.
+void Headers::appendTo(std::string &buffer) const {
+    buffer.reserve(buffer.size() + getSerializedLength());
+    for (const Field &field : _fields)
+        buffer.append(_nameOf(field)).append(": ").append(_valueOf(field)).append("\r\n");
 }
 
-std::ostream &operator<<(std::ostream &os, const Headers &headers) {
-    for (const auto &header : headers.getHeaders()) {
-        os << header.first << ": " << header.second << "\r\n";
-    }
-    return os;
+std::string Headers::getAndRemoveHeader(HeaderKey key, std::string_view default_value) {
+    auto it = _find(key);
+    if (it == _fields.end())
+        return (std::string(default_value));
+
+    std::string result(_valueOf(*it));
+    _fields.erase(it);
+    return (result);
 }
 
-std::ostringstream &operator<<(std::ostringstream &os, const Headers &headers) {
-    for (const auto &header : headers.getHeaders()) {
-        os << header.first << ": " << header.second << "\r\n";
-    }
+std::ostream &operator<<(std::ostream &os, const Headers &headers) {
+    headers.forEach([&os](std::string_view name, std::string_view value) {
+        os << name << ": " << value << "\r\n";
+    });
     return os;
 }
@@ -0,0 +1,248 @@
+#include "ioUring.hpp"
+#include "print.hpp"
+
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <stdexcept>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+#include <atomic>
+#include <cerrno>
+
+static int io_uring_setup(unsigned entries, io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static inline uint64_t encode_user_data(IOUringOperation operation, int fd) {
+    return (static_cast<uint64_t>(operation) << 32) | static_cast<uint32_t>(fd);
+}
+
+/// @brief Create the ring and map its submission and completion queues.
+/// @throws std::runtime_error if the kernel refuses to set up the ring (e.g. io_uring disabled).
+IOUring::IOUring(unsigned entries) :
+    _ringFd(-1),
+    _sqRing(MAP_FAILED), _sqRingSize(0),
+    _cqRing(MAP_FAILED), _cqRingSize(0),
+    _sqes(static_cast<io_uring_sqe *>(MAP_FAILED)), _sqesSize(0),
+    _sqHead(nullptr), _sqTail(nullptr), _sqMask(0), _sqEntries(0), _sqArray(nullptr),
+    _cqHead(nullptr), _cqTail(nullptr), _cqMask(0), _cqes(nullptr),
+    _pendingSubmissions(0),
+    _skipSuccessFlag(0),
+    _epollEvents()
+{
+    // SUBMIT_ALL keeps flushing the batch when one descriptor update fails
+    io_uring_params params{};
+    params.flags = IORING_SETUP_SUBMIT_ALL;
+    _ringFd = io_uring_setup(entries, &params);
+    if (_ringFd == -1 && errno == EINVAL) {
+        params = io_uring_params{};
+        _ringFd = io_uring_setup(entries, &params);
+    }
+    if (_ringFd == -1)
+        throw std::runtime_error(std::string("io_uring_setup failed: ") + strerror(errno));
+
+    // Descriptor bookkeeping only needs a completion when it fails, older kernels post them all
+    if (params.features & IORING_FEAT_CQE_SKIP)
+        _skipSuccessFlag = IOSQE_CQE_SKIP_SUCCESS;
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+
+    _sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        _cqRing = _sqRing;
+    else if (_sqRing != MAP_FAILED)
+        _cqRing = mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+
+    _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    if (_cqRing != MAP_FAILED)
+        _sqes = static_cast<io_uring_sqe *>(mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES));
+
+    if (_sqRing == MAP_FAILED || _cqRing == MAP_FAILED || _sqes == MAP_FAILED) {
+        int mapErrno = errno;
+        _unmap();
+        ::close(_ringFd);
+        throw std::runtime_error(std::string("Failed to map io_uring queues: ") + strerror(mapErrno));
+    }
+
+    char *sq = static_cast<char *>(_sqRing);
+    _sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    _sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    _sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    _sqEntries = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_entries);
+    _sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    char *cq = static_cast<char *>(_cqRing);
+    _cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    _cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    _cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    _epollEvents.resize(_sqEntries);
+    DEBUG("io_uring created, fd: " << _ringFd << ", sq entries: " << _sqEntries << ", cq entries: " << params.cq_entries);
+}
+
+IOUring::~IOUring() {
+    if (_pendingSubmissions > 0)
+        submit();
+    _unmap();
+    if (_ringFd != -1)
+        ::close(_ringFd);
+}
+
+void IOUring::_unmap() {
+    if (_sqes != MAP_FAILED)
+        munmap(_sqes, _sqesSize);
+    if (_cqRing != MAP_FAILED && _cqRing != _sqRing)
+        munmap(_cqRing, _cqRingSize);
+    if (_sqRing != MAP_FAILED)
+        munmap(_sqRing, _sqRingSize);
+    _sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    _sqRing = _cqRing = MAP_FAILED;
+}
+
+/// @brief Reserve the next submission queue entry, flushing the queue first if it is full.
+/// @param index Set to the ring index of the returned entry.
+/// @return A zeroed entry, or nullptr if the queue stays full.
+io_uring_sqe *IOUring::_getSubmissionEntry(unsigned &index) {
+    unsigned head = std::atomic_ref<unsigned>(*_sqHead).load(std::memory_order_acquire);
+    unsigned tail = *_sqTail + _pendingSubmissions;
+
+    if (tail - head >= _sqEntries) {
+        if (submit() <= 0)
+            return (nullptr);
+        head = std::atomic_ref<unsigned>(*_sqHead).load(std::memory_order_acquire);
+        tail = *_sqTail;
+        if (tail - head >= _sqEntries)
+            return (nullptr);
+    }
+
+    index = tail & _sqMask;
+    io_uring_sqe *sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    _sqArray[index] = index;
+    ++_pendingSubmissions;
+    return (sqe);
+}
+
+/// @brief Queue an epoll_ctl call for the given epoll instance.
+/// @details Only a failed call posts a completion, when the kernel supports skipping successful ones.
+/// @return true if the operation was queued.
+bool IOUring::queueEpollCtl(int epollFd, int operation, int fd, uint32_t events) {
+    unsigned index;
+    io_uring_sqe *sqe = _getSubmissionEntry(index);
+    if (!sqe) return (false);
+
+    _epollEvents[index].events = events;
+    _epollEvents[index].data.fd = fd;
+
+    sqe->opcode = IORING_OP_EPOLL_CTL;
+    sqe->fd = epollFd;
+    sqe->off = static_cast<uint64_t>(fd);
+    sqe->len = static_cast<uint32_t>(operation);
+    sqe->addr = reinterpret_cast<uint64_t>(&_epollEvents[index]);
+    sqe->flags = _skipSuccessFlag;
+    sqe->user_data = encode_user_data(IOUringOperation::EpollCtl, fd);
+    return (true);
+}
+
+/// @brief Queue a close of the given descriptor.
+/// @param epollFd If set, the descriptor is first removed from this epoll instance.
+/// Both steps are hard-linked, so the close runs even if the removal fails.
+/// Like epoll_ctl, only failures post a completion.
+/// @return true if the operation was queued.
+bool IOUring::queueClose(int fd, int epollFd) {
+    if (epollFd != -1) {
+        if (!queueEpollCtl(epollFd, EPOLL_CTL_DEL, fd, 0)) return (false);
+        _sqes[(*_sqTail + _pendingSubmissions - 1) & _sqMask].flags |= IOSQE_IO_HARDLINK;
+    }
+
+    unsigned index;
+    io_uring_sqe *sqe = _getSubmissionEntry(index);
+    if (!sqe) {
+        // The epoll removal was already submitted on its own, the link got nothing to hold on to
+        return (false);
+    }
+
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->flags = _skipSuccessFlag;
+    sqe->user_data = encode_user_data(IOUringOperation::Close, fd);
+    return (true);
+}
+
+/// @brief Queue a multishot accept on a listening socket.
+/// @details Accepted sockets are created non-blocking and reported one completion each,
+/// until a completion arrives without IORING_CQE_F_MORE and the accept has to be queued again.
+/// @return true if the operation was queued.
+bool IOUring::queueMultishotAccept(int listenFd) {
+    unsigned index;
+    io_uring_sqe *sqe = _getSubmissionEntry(index);
+    if (!sqe) return (false);
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = encode_user_data(IOUringOperation::Accept, listenFd);
+    return (true);
+}
+
+/// @brief Hand all queued operations to the kernel in a single io_uring_enter call.
+/// @return The amount of submitted operations, or -1 on failure.
+int IOUring::submit() {
+    if (_pendingSubmissions == 0)
+        return (0);
+
+    std::atomic_ref<unsigned>(*_sqTail).store(*_sqTail + _pendingSubmissions, std::memory_order_release);
+    unsigned toSubmit = _pendingSubmissions;
+    _pendingSubmissions = 0;
+
+    int submitted;
+    do {
+        submitted = io_uring_enter(_ringFd, toSubmit, 0, 0);
+    } while (submitted == -1 && errno == EINTR);
+
+    if (submitted == -1)
+        ERROR("io_uring_enter failed: " << strerror(errno));
+    return (submitted);
+}
+
+/// @brief Reap every available completion.
+/// @param handler Called once per completion, in the order the kernel posted them.
+/// @return The amount of processed completions.
+size_t IOUring::processCompletions(const std::function<void(const Completion&)> &handler) {
+    std::atomic_ref<unsigned> cqHead(*_cqHead);
+    unsigned head = cqHead.load(std::memory_order_relaxed);
+    unsigned tail = std::atomic_ref<unsigned>(*_cqTail).load(std::memory_order_acquire);
+    size_t processed = 0;
+
+    while (head != tail) {
+        const io_uring_cqe &cqe = _cqes[head & _cqMask];
+        Completion completion{
+            static_cast<IOUringOperation>(cqe.user_data >> 32),
+            static_cast<int>(static_cast<uint32_t>(cqe.user_data)),
+            cqe.res,
+            cqe.flags
+        };
+
+        // Release the entry before running the handler, it may queue and submit new work
+        cqHead.store(++head, std::memory_order_release);
+        handler(completion);
+        ++processed;
+
+        if (head == tail)
+            tail = std::atomic_ref<unsigned>(*_cqTail).load(std::memory_order_acquire);
+    }
+
+    return (processed);
+}
@@ -7,6 +7,8 @@
 #include <map>
 #include <unistd.h>
 
+#include "workerManager.hpp"
+#include "byteScan.hpp"
 #include "print.hpp"
 #include "server.hpp"
 #include "config/config.hpp"
@@ -50,17 +52,17 @@ int main(int argc, const char* const argv[]) {
     signal(SIGPIPE, signalPipeShit);
 
     PRINT("Configuration loaded successfully from " << configPath);
-	try{
-    	Server server(configs);
-		while (!g_quit)
-        	server.runOnce();
-    	server.cleanUp();
-	}
-	catch (const std::exception &e)
-	{
-		std::cout << e.what() << std::endl;
-		return (1);
-	}
+    DEBUG("Delimiter scans use the " << ByteScan::getImplementationName() << " implementation");
+    int exitCode;
+    if (configs.workerProcesses.getWorkerCount() > 1) {
+        WorkerManager workerManager(configs);
+        exitCode = workerManager.run();
+    } else {
+        exitCode = WorkerManager::runWorker(configs);
+    }
+
+    if (exitCode != 0)
+        return (exitCode);
 
     PRINT("Server shutting down gracefully - how nice ^^");
     return (0);
@@ -0,0 +1,130 @@
+#include "config/types/consts.hpp"
+#include "memoryCache.hpp"
+#include "response.hpp"
+#include "Utils.hpp"
+#include "print.hpp"
+
+#include <unistd.h>
+#include <cerrno>
+
+bool CachedFile::matches(const OpenFile &file) const {
+    return (inode == file.inode && size == file.size
+        && modificationTime.tv_sec == file.modificationTime.tv_sec
+        && modificationTime.tv_nsec == file.modificationTime.tv_nsec);
+}
+
+MemoryCache::MemoryCache() :
+    _maxMemory(0), _maxFileSize(0), _usedMemory(0), _entries(), _lru(), _hits(0), _misses(0), _evictions(0) {}
+
+/// @brief Set the memory budget, 0 disables the cache, and the size above which files are never cached.
+void MemoryCache::configure(size_t maxMemory, size_t maxFileSize) {
+    clear();
+    _maxMemory = maxMemory;
+    _maxFileSize = maxFileSize;
+}
+
+/// @brief Get the cached copy of a regular file, loading it on a miss.
+/// @param file The current state of the file. Its descriptor is used to load it, if it has none the path is opened.
+/// @param encoding The content coding of the copy, compressed copies are made with `level`.
+/// @return The cached file, or nullptr if it doesn't qualify for the cache (or couldn't be read).
+std::shared_ptr<const CachedFile> MemoryCache::lookup(const std::string &path, const OpenFile &file, ContentEncoding encoding, int level) {
+    if (!isEnabled() || !file.isRegular || static_cast<size_t>(file.size) > _maxFileSize)
+        return (nullptr);
+
+    std::string key = path;
+    if (encoding != ContentEncoding::Identity)
+        key.append(1, '\0').append(ContentEncoder::getName(encoding)).append(std::to_string(level));
+
+    auto it = _entries.find(key);
+    if (it != _entries.end()) {
+        if (it->second.file->matches(file)) {
+            ++_hits;
+            _lru.splice(_lru.begin(), _lru, it->second.lruPosition);
+            return (it->second.file);
+        }
+        _erase(it);
+    }
+
+    ++_misses;
+    std::shared_ptr<const CachedFile> cached = _load(path, file, encoding, level);
+    if (!cached)
+        return (nullptr);
+
+    size_t cost = cached->head.size() + cached->body.size() + key.size();
+    if (cost > _maxMemory)
+        return (cached);
+
+    while (_usedMemory + cost > _maxMemory) {
+        _erase(_entries.find(_lru.back()));
+        ++_evictions;
+    }
+
+    _lru.push_front(key);
+    _entries.emplace(key, Entry{cached, _lru.begin(), cost});
+    _usedMemory += cost;
+    DEBUG("Memory cached file: " << path << " (" << ContentEncoder::getName(encoding) << "), using " << _usedMemory << " of " << _maxMemory << " bytes");
+    return (cached);
+}
+
+/// @brief Read a whole file, compress it if asked to, and build the start of its response.
+/// @return nullptr if the file could not be read in full, e.g. because it shrunk in the meantime.
+std::shared_ptr<const CachedFile> MemoryCache::_load(const std::string &path, const OpenFile &file, ContentEncoding encoding, int level) {
+    std::shared_ptr<CachedFile> cached = std::make_shared<CachedFile>();
+    cached->inode = file.inode;
+    cached->size = file.size;
+    cached->modificationTime = file.modificationTime;
+    cached->body.resize(static_cast<size_t>(file.size));
+
+    // A file that was only stat()ed is opened for the load and closed along with `opened`
+    std::shared_ptr<const OpenFile> opened;
+    int fd = file.fd;
+    if (fd == -1) {
+        opened = OpenFile::open(path);
+        fd = opened->fd;
+    }
+    if (fd == -1)
+        return (nullptr);
+
+    size_t offset = 0;
+    while (offset < cached->body.size()) {
+        ssize_t bytesRead = pread(fd, cached->body.data() + offset, cached->body.size() - offset, static_cast<off_t>(offset));
+        if (bytesRead == -1 && errno == EINTR)
+            continue ;
+        if (bytesRead <= 0) {
+            ERROR_IF(bytesRead == -1, "Failed to read file for the memory cache: " << path);
+            return (nullptr);
+        }
+        offset += static_cast<size_t>(bytesRead);
+    }
+
+    if (encoding != ContentEncoding::Identity) {
+        std::unique_ptr<ContentEncoder> encoder = ContentEncoder::create(encoding, level);
+        std::string compressed;
+        if (!encoder || !encoder->write(cached->body, compressed, EncoderFlush::Finish))
+            return (nullptr);
+        cached->body.swap(compressed);
+    }
+
+    cached->head.append(Response::protocol).append("/").append(Response::tlsVersion).append(" ")
+        .append(std::to_string(static_cast<int>(HttpStatusCode::OK))).append(" ")
+        .append(getStatusCodeAsStr(HttpStatusCode::OK)).append("\r\n");
+    cached->head.append(headerKeyToString(HeaderKey::ContentType)).append(": ").append(Utils::getMimeType(path)).append("\r\n");
+    cached->head.append(headerKeyToString(HeaderKey::ContentLength)).append(": ").append(std::to_string(cached->body.size())).append("\r\n");
+    cached->head.append(headerKeyToString(HeaderKey::ETag)).append(": ").append(ContentEncoder::getVariantETag(file.getETag(), encoding)).append("\r\n");
+    cached->head.append(headerKeyToString(HeaderKey::LastModified)).append(": ").append(file.getLastModified()).append("\r\n");
+    if (encoding != ContentEncoding::Identity)
+        cached->head.append(headerKeyToString(HeaderKey::ContentEncoding)).append(": ").append(ContentEncoder::getName(encoding)).append("\r\n");
+    return (cached);
+}
+
+void MemoryCache::_erase(std::unordered_map<std::string, Entry>::iterator it) {
+    _usedMemory -= it->second.cost;
+    _lru.erase(it->second.lruPosition);
+    _entries.erase(it);
+}
+
+void MemoryCache::clear() {
+    _entries.clear();
+    _lru.clear();
+    _usedMemory = 0;
+}
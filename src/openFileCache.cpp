@@ -0,0 +1,249 @@
+#include "openFileCache.hpp"
+#include "print.hpp"
+#include "Utils.hpp"
+
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <cerrno>
+
+#define OPEN_FILE_CACHE_NOTIFY_MASK (IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE \
+    | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+/// @brief Everything up to and including the last slash of a path, empty for a bare filename.
+static std::string parent_directory_prefix(const std::string &path) {
+    size_t lastSlash = path.find_last_of('/');
+    if (lastSlash == std::string::npos)
+        return ("");
+    return (path.substr(0, lastSlash + 1));
+}
+
+static void set_metadata(OpenFile &file, const struct stat &fileStat) {
+    file.exists = true;
+    file.isDirectory = S_ISDIR(fileStat.st_mode);
+    file.isRegular = S_ISREG(fileStat.st_mode);
+    file.size = fileStat.st_size;
+    file.inode = fileStat.st_ino;
+    file.modificationTime = fileStat.st_mtim;
+}
+
+OpenFile::OpenFile() : fd(-1), exists(false), isDirectory(false), isRegular(false), size(0), inode(0), modificationTime{} {}
+
+OpenFile::~OpenFile() {
+    if (fd != -1)
+        ::close(fd);
+}
+
+/// @brief Open a path and record what it is.
+/// @details Only regular files keep their descriptor. Paths that exist but can't be opened
+/// (e.g. missing read permission) are still reported as existing, with their metadata.
+std::shared_ptr<const OpenFile> OpenFile::open(const std::string &path) {
+    std::shared_ptr<OpenFile> file = std::make_shared<OpenFile>();
+    struct stat fileStat;
+
+    // O_NONBLOCK keeps opening a FIFO from stalling the event loop, regular files ignore it
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd != -1 ? fstat(fd, &fileStat) == -1 : ::stat(path.c_str(), &fileStat) == -1) {
+        if (fd != -1)
+            ::close(fd);
+        return (file);
+    }
+    set_metadata(*file, fileStat);
+
+    if (fd != -1 && file->isRegular)
+        file->fd = fd;
+    else if (fd != -1)
+        ::close(fd);
+
+    return (file);
+}
+
+/// @brief Record what a path is without opening it, the result holds no descriptor.
+std::shared_ptr<const OpenFile> OpenFile::stat(const std::string &path) {
+    std::shared_ptr<OpenFile> file = std::make_shared<OpenFile>();
+    struct stat fileStat;
+
+    if (::stat(path.c_str(), &fileStat) == 0)
+        set_metadata(*file, fileStat);
+    return (file);
+}
+
+/// @brief Get a regular file with its descriptor, opening the path now if `file` only came from stat().
+/// @return `file` itself if it already holds a descriptor or isn't a regular file.
+std::shared_ptr<const OpenFile> OpenFile::withDescriptor(const std::string &path, const std::shared_ptr<const OpenFile> &file) {
+    if (file->fd != -1 || !file->isRegular)
+        return (file);
+    return (open(path));
+}
+
+/// @brief Validator for the current version of the file, built from its modification time and size.
+std::string OpenFile::getETag() const {
+    char buffer[48];
+    int length = std::snprintf(buffer, sizeof(buffer), "\"%llx-%llx\"",
+        static_cast<unsigned long long>(modificationTime.tv_sec), static_cast<unsigned long long>(size));
+    return (std::string(buffer, static_cast<size_t>(length)));
+}
+
+/// @brief Modification time of the file as an HTTP date, for Last-Modified.
+std::string OpenFile::getLastModified() const {
+    return (Utils::formatHttpDate(modificationTime.tv_sec));
+}
+
+OpenFileCache::OpenFileCache() :
+    _maxEntries(0), _validity(), _entries(), _lru(), _notifyFd(-1), _watches(), _directoryWatches() {}
+
+OpenFileCache::~OpenFileCache() {
+    clear();
+    if (_notifyFd != -1)
+        ::close(_notifyFd);
+}
+
+/// @brief Set the cache limits, 0 entries disables it. Creates the inotify instance on first use.
+/// @details Without inotify the cache still works, but only expiry catches changes on disk.
+void OpenFileCache::configure(size_t maxEntries, std::chrono::steady_clock::duration validity) {
+    clear();
+    _maxEntries = maxEntries;
+    _validity = validity;
+
+    if (!isEnabled() || _notifyFd != -1)
+        return ;
+
+    _notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    ERROR_IF(_notifyFd == -1, "Failed to create inotify instance, cached files are only refreshed on expiry: " << strerror(errno));
+}
+
+/// @brief Get the OpenFile for a path, from the cache if a valid entry exists.
+/// @details The parent directory is watched before the path is opened, so a change that races
+/// with the open is reported afterwards and drops the fresh entry instead of going unnoticed.
+std::shared_ptr<const OpenFile> OpenFileCache::lookup(const std::string &path) {
+    if (!isEnabled())
+        return (OpenFile::stat(path));
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    auto it = _entries.find(path);
+    if (it != _entries.end()) {
+        if (now < it->second.validUntil) {
+            _lru.splice(_lru.begin(), _lru, it->second.lruPosition);
+            return (it->second.file);
+        }
+        _erase(it);
+    }
+
+    while (_entries.size() >= _maxEntries)
+        _erase(_entries.find(_lru.back()));
+
+    int watch = _watchParentDirectory(path);
+    std::shared_ptr<const OpenFile> file = OpenFile::open(path);
+    _lru.push_front(path);
+    _entries.emplace(path, Entry{file, now + _validity, _lru.begin(), watch});
+    DEBUG("Cached " << (file->exists ? "" : "missing ") << "path: " << path << ", cache size: " << _entries.size());
+    return (file);
+}
+
+/// @brief Take a reference on the watch of the directory containing `path`, adding it if needed.
+/// @return The watch descriptor, or -1 if the entry has to rely on expiry alone.
+int OpenFileCache::_watchParentDirectory(const std::string &path) {
+    if (_notifyFd == -1)
+        return (-1);
+
+    std::string directory = parent_directory_prefix(path);
+    int watch;
+
+    auto known = _directoryWatches.find(directory);
+    if (known != _directoryWatches.end()) {
+        watch = known->second;
+    } else {
+        watch = inotify_add_watch(_notifyFd, directory.empty() ? "." : directory.c_str(), OPEN_FILE_CACHE_NOTIFY_MASK);
+        if (watch == -1)
+            return (-1);
+
+        // The same directory reached through another spelling reports its events under the first one
+        if (!_watches.emplace(watch, Watch{directory, 0}).second)
+            return (-1);
+        _directoryWatches.emplace(directory, watch);
+    }
+
+    ++_watches[watch].entries;
+    return (watch);
+}
+
+void OpenFileCache::_releaseWatch(int watch) {
+    auto it = _watches.find(watch);
+    if (it == _watches.end() || --it->second.entries > 0)
+        return ;
+
+    // Fails harmlessly if the kernel already dropped the watch along with its directory
+    inotify_rm_watch(_notifyFd, watch);
+    _directoryWatches.erase(it->second.directory);
+    _watches.erase(it);
+}
+
+void OpenFileCache::_erase(std::unordered_map<std::string, Entry>::iterator it) {
+    _releaseWatch(it->second.watch);
+    _lru.erase(it->second.lruPosition);
+    _entries.erase(it);
+}
+
+void OpenFileCache::_invalidate(const std::string &path) {
+    auto it = _entries.find(path);
+    if (it != _entries.end()) {
+        DEBUG("Invalidated cached path: " << path);
+        _erase(it);
+    }
+}
+
+/// @brief Drop every entry below a watched directory that was deleted or moved away.
+/// @details Subdirectories don't see their parent move, so their entries go as well.
+void OpenFileCache::_invalidateDirectory(int watch) {
+    std::string prefix = _watches.at(watch).directory;
+    DEBUG("Invalidated cached directory: " << (prefix.empty() ? "." : prefix));
+
+    // Bare filenames are watched through "." with an empty prefix, which would match every path
+    for (auto it = _entries.begin(); it != _entries.end(); ) {
+        auto next = std::next(it);
+        if (it->second.watch == watch || (!prefix.empty() && it->first.compare(0, prefix.size(), prefix) == 0))
+            _erase(it);
+        it = next;
+    }
+}
+
+/// @brief Drain the inotify queue and drop the entries it reports as changed.
+void OpenFileCache::handleNotifications() {
+    alignas(inotify_event) char buffer[OPEN_FILE_CACHE_NOTIFY_BUFFER_SIZE];
+
+    while (true) {
+        ssize_t length = read(_notifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            ERROR_IF(length == -1 && errno != EAGAIN && errno != EINTR, "Failed to read inotify events: " << strerror(errno));
+            return ;
+        }
+
+        for (ssize_t offset = 0; offset < length; ) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                ERROR("inotify queue overflowed, dropping the whole open file cache");
+                clear();
+                continue ;
+            }
+
+            auto watch = _watches.find(event->wd);
+            if (watch == _watches.end())
+                continue ;
+
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT | IN_IGNORED))
+                _invalidateDirectory(event->wd);
+            else if (event->len > 0)
+                _invalidate(watch->second.directory + event->name);
+        }
+    }
+}
+
+void OpenFileCache::clear() {
+    while (!_entries.empty())
+        _erase(_entries.begin());
+}
@@ -0,0 +1,87 @@
+#include "readBuffer.hpp"
+#include "byteScan.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+ReadBuffer::ReadBuffer() : _data(), _readPos(0), _writePos(0), _scanDelimiter(), _scanned(0) {}
+
+/// @brief View of at most `maxSize` unread bytes, valid until the next write or consume.
+std::string_view ReadBuffer::view(size_t maxSize) const {
+    return std::string_view(_data.data() + _readPos, std::min(size(), maxSize));
+}
+
+/// @brief Find a sequence in the unread bytes.
+/// @return The offset relative to the read cursor, or std::string_view::npos.
+size_t ReadBuffer::find(std::string_view needle, size_t from) const {
+    return (ByteScan::find(view(), needle, from));
+}
+
+/// @brief Find a delimiter in the unread bytes, skipping what earlier searches for it already covered.
+/// @details Bytes only get appended until the next consume, so a search that failed (or found the
+/// delimiter) stays valid for the prefix it covered. This keeps a message trickling in byte by byte
+/// from being rescanned from the start on every read. `delimiter` has to outlive the buffer, e.g. a literal.
+/// @return The offset relative to the read cursor, or std::string_view::npos.
+size_t ReadBuffer::scan(std::string_view delimiter) {
+    if (delimiter != _scanDelimiter) {
+        _scanDelimiter = delimiter;
+        _scanned = 0;
+    }
+
+    // A delimiter may straddle the end of the previous search
+    size_t from = _scanned >= delimiter.size() ? _scanned - (delimiter.size() - 1) : 0;
+    size_t pos = ByteScan::find(view(), delimiter, from);
+    _scanned = (pos == std::string_view::npos ? size() : pos);
+    return (pos);
+}
+
+/// @brief Move the unread bytes to the front of the storage.
+void ReadBuffer::_compact() {
+    size_t unread = size();
+    if (unread > 0 && _readPos > 0)
+        std::memmove(_data.data(), _data.data() + _readPos, unread);
+    _readPos = 0;
+    _writePos = unread;
+}
+
+/// @brief Make room for `size` bytes after the write cursor.
+/// @return Pointer to the writable region, to be followed by commitWrite().
+char *ReadBuffer::prepareWrite(size_t size) {
+    if (_data.size() - _writePos >= size)
+        return (_data.data() + _writePos);
+
+    // Compact only once the consumed prefix outweighs the unread data or fills half the storage,
+    // so every move is paid for by at least as many consumed bytes; otherwise grow
+    if (_readPos >= this->size() || _readPos >= _data.size() / 2)
+        _compact();
+
+    if (_data.size() - _writePos < size)
+        _data.resize(std::max(_data.size() * 2, _writePos + size));
+
+    return (_data.data() + _writePos);
+}
+
+/// @brief Mark `size` bytes of the region returned by prepareWrite() as written.
+void ReadBuffer::commitWrite(size_t size) {
+    _writePos = std::min(_writePos + size, _data.size());
+}
+
+void ReadBuffer::append(std::string_view data) {
+    if (data.empty()) return ;
+    std::memcpy(prepareWrite(data.size()), data.data(), data.size());
+    commitWrite(data.size());
+}
+
+/// @brief Drop `size` bytes from the front of the unread data.
+void ReadBuffer::consume(size_t size) {
+    size = std::min(size, this->size());
+    _scanned -= std::min(_scanned, size);
+    _readPos += size;
+    if (_readPos == _writePos)
+        _readPos = _writePos = 0;
+}
+
+void ReadBuffer::clear() {
+    _scanned = 0;
+    _readPos = _writePos = 0;
+}
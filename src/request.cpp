@@ -3,6 +3,7 @@
 #include "fd.hpp"
 
 #include <sys/socket.h>
+#include <charconv>
 
 /// @brief Extracts the most relevant configuration settings from the request headers
 /// for reading the request body. Other headers are ignored; and up to the rest of
@@ -10,12 +11,11 @@
 void Request::_fetch_config_from_headers() {
     if (headers.getHeader(HeaderKey::TransferEncoding, "") == "chunked")
         receivingBodyMode = ReceivingBodyMode::Chunked;
-    else if (headers.getHeader(HeaderKey::ContentLength, "") != "") {
+    else if (std::string_view value = headers.getHeader(HeaderKey::ContentLength, ""); !value.empty()) {
         receivingBodyMode = ReceivingBodyMode::ContentLength;
 
-        try { contentLength = std::stoul(headers.getHeader(HeaderKey::ContentLength, "")); }
-        catch (...) {
-            DEBUG_IF(receivingBodyMode == ReceivingBodyMode::ContentLength, "Invalid Content-Length header value, defaulting to 0");
+        if (std::from_chars(value.data(), value.data() + value.size(), contentLength).ec != std::errc()) {
+            DEBUG("Invalid Content-Length header value, defaulting to 0");
             contentLength = 0;
         }
     } else {
@@ -27,17 +27,28 @@ void Request::_fetch_config_from_headers() {
     cookies = Cookie::createAllFromHeader(headers.getHeader(HeaderKey::Cookie, ""));
 }
 
-/// @brief Parses the request headers from the buffer.
-/// @return Returns true if the headers are (already) parsed, false otherwise.
-Request::Request(std::string &buffer) :
-    metadata(), headers(), contentLength(0), headerPartLength(buffer.size()), cookies(), session(nullptr), receivingBodyMode(ReceivingBodyMode::NotSet)
-{
-    std::istringstream stream(buffer);
-    metadata = RequestLine(stream);
-    headers = Headers(stream);
+Request::Request() :
+    metadata(), headers(), contentLength(0), headerPartLength(0), cookies(), session(nullptr), receivingBodyMode(ReceivingBodyMode::NotSet) {}
 
+/// @brief Build the request from a head the parser completed.
+/// @param buffer The buffer the parser ran on, it has to be unchanged since.
+Request::Request(const RequestParser &parser, std::string_view buffer) :
+    metadata(parser.getMethod(buffer), parser.getTarget(buffer), parser.getVersion(buffer)),
+    headers(parser, buffer), contentLength(0), headerPartLength(parser.getHeadLength()),
+    cookies(), session(nullptr), receivingBodyMode(ReceivingBodyMode::NotSet)
+{
     _fetch_config_from_headers();
     DEBUG("Request created with metadata: " << metadata);
 	DEBUG("Headers are: '''" << headers << "'''\n");
 }
 
+/// @brief Whether a body follows the headers, it has to be read before a pipelined request after it can start.
+bool Request::hasBody() const {
+    return (receivingBodyMode == ReceivingBodyMode::Chunked || contentLength > 0);
+}
+
+/// @brief How many bytes of a Content-Length body are still to come once `receivedBytes` of it arrived.
+/// @details Anything in the socket buffer past this belongs to the next request on the connection.
+size_t Request::getRemainingBodyLength(size_t receivedBytes) const {
+    return (receivedBytes >= contentLength ? 0 : contentLength - receivedBytes);
+}
@@ -0,0 +1,130 @@
+#include "requestParser.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+/// @brief Whether a character may appear in a method or a field name (a "tchar" of RFC 9110).
+static bool is_token_char(char c) {
+    if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9'))
+        return (true);
+    return (c != '\0' && std::strchr("!#$%&'*+-.^_`|~", c) != nullptr);
+}
+
+static bool is_token(std::string_view token) {
+    return (!token.empty() && std::all_of(token.begin(), token.end(), is_token_char));
+}
+
+static bool is_whitespace(char c) {
+    return (c == ' ' || c == '\t');
+}
+
+RequestParser::RequestParser(size_t maxSize) :
+    _state(State::RequestLine), _status(RequestParserStatus::Incomplete), _maxSize(maxSize),
+    _lineStart(0), _scanPos(0), _method{0, 0}, _target{0, 0}, _version{0, 0}, _fields() {}
+
+/// @brief Forget the previous head, to parse the next one from the (consumed) buffer.
+/// @details Keeps the capacity of the field list, so a connection stops allocating after its first request.
+void RequestParser::reset() {
+    _state = State::RequestLine;
+    _status = RequestParserStatus::Incomplete;
+    _lineStart = 0;
+    _scanPos = 0;
+    _method = _target = _version = ParserSpan{0, 0};
+    _fields.clear();
+}
+
+RequestParserStatus RequestParser::_fail(RequestParserStatus status) {
+    _status = status;
+    return (_status);
+}
+
+/// @brief Continue parsing the head at the start of `buffer`.
+/// @param buffer All unread bytes of the connection, starting with the same byte on every call.
+/// @return Complete once the empty line ending the head is found, Incomplete if more data is needed.
+/// Invalid and TooLarge are final, they stay the result of every call until reset().
+RequestParserStatus RequestParser::parse(std::string_view buffer) {
+    if (_state == State::Done || hasFailed())
+        return (_status);
+
+    while (true) {
+        size_t limit = std::min(buffer.size(), _maxSize);
+        const char *newline = nullptr;
+        if (_scanPos < limit)
+            newline = static_cast<const char *>(std::memchr(buffer.data() + _scanPos, '\n', limit - _scanPos));
+
+        if (!newline) {
+            _scanPos = limit;
+            if (buffer.size() >= _maxSize)
+                return (_fail(RequestParserStatus::TooLarge));
+            return (RequestParserStatus::Incomplete);
+        }
+
+        // Lines end in CRLF, a bare LF is accepted as well (RFC 9112 section 2.2)
+        size_t lineEnd = static_cast<size_t>(newline - buffer.data());
+        size_t lineStart = _lineStart;
+        _lineStart = _scanPos = lineEnd + 1;
+        if (lineEnd > lineStart && buffer[lineEnd - 1] == '\r')
+            --lineEnd;
+        std::string_view line = buffer.substr(lineStart, lineEnd - lineStart);
+
+        if (_state == State::RequestLine) {
+            // Empty lines ahead of the request line are leftovers of a previous message, not an error
+            if (line.empty())
+                continue ;
+            if (!_parseRequestLine(line, lineStart))
+                return (_fail(RequestParserStatus::Invalid));
+            _state = State::HeaderLine;
+            continue ;
+        }
+
+        if (line.empty()) {
+            _state = State::Done;
+            return (_status = RequestParserStatus::Complete);
+        }
+
+        if (_fields.size() >= REQUEST_PARSER_MAX_FIELDS)
+            return (_fail(RequestParserStatus::TooLarge));
+        if (!_parseHeaderLine(line, lineStart))
+            return (_fail(RequestParserStatus::Invalid));
+    }
+}
+
+/// @brief Split "<method> <target> HTTP/<version>", separated by single spaces.
+bool RequestParser::_parseRequestLine(std::string_view line, size_t offset) {
+    size_t methodEnd = line.find(' ');
+    if (methodEnd == std::string_view::npos || !is_token(line.substr(0, methodEnd)))
+        return (false);
+
+    size_t targetStart = methodEnd + 1;
+    size_t targetEnd = line.find(' ', targetStart);
+    if (targetEnd == std::string_view::npos || targetEnd == targetStart)
+        return (false);
+
+    size_t versionStart = targetEnd + 1;
+    std::string_view version = line.substr(versionStart);
+    if (version.size() <= 5 || version.compare(0, 5, "HTTP/") != 0 || version.find(' ') != std::string_view::npos)
+        return (false);
+
+    _method = ParserSpan{offset, methodEnd};
+    _target = ParserSpan{offset + targetStart, targetEnd - targetStart};
+    _version = ParserSpan{offset + versionStart, version.size()};
+    return (true);
+}
+
+/// @brief Split "<name>:<value>", dropping the whitespace around the value.
+/// @details Whitespace before the colon, and so obsolete line folding as well, is rejected (RFC 9112 section 5).
+bool RequestParser::_parseHeaderLine(std::string_view line, size_t offset) {
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos || !is_token(line.substr(0, colon)))
+        return (false);
+
+    size_t valueStart = colon + 1;
+    size_t valueEnd = line.size();
+    while (valueStart < valueEnd && is_whitespace(line[valueStart]))
+        ++valueStart;
+    while (valueEnd > valueStart && is_whitespace(line[valueEnd - 1]))
+        --valueEnd;
+
+    _fields.push_back(Field{ParserSpan{offset, colon}, ParserSpan{offset + valueStart, valueEnd - valueStart}});
+    return (true);
+}
@@ -2,7 +2,6 @@
 #include "print.hpp"
 #include "Utils.hpp"
 
-#include <sys/stat.h>
 #include <sstream>
 
 static int hexCharToInt(char c) {
@@ -12,8 +11,9 @@ static int hexCharToInt(char c) {
     return -1; // invalid hex char
 }
 
-static std::string urlDecode(const std::string& str) {
+static std::string urlDecode(std::string_view str) {
     std::string result;
+    result.reserve(str.length());
     for (std::size_t i = 0; i < str.length(); ++i) {
         if (str[i] == '%' && i + 2 < str.length()) {
             int high = hexCharToInt(str[i + 1]);
@@ -34,20 +34,15 @@ static std::string urlDecode(const std::string& str) {
     return result;
 }
 
-RequestLine::RequestLine() : _method(UNKNOWN_METHOD), _url(), _version("HTTP/1.1"), _path(), _serverAbsolutePath(Path::createDummy()), _pathIsDirectory(false) {}
+RequestLine::RequestLine() : _method(UNKNOWN_METHOD), _url(), _version("HTTP/1.1"), _path(), _serverAbsolutePath(Path::createDummy()), _pathIsDirectory(false), _file(), _precompressedFile() {}
 
-RequestLine::RequestLine(std::istringstream &source) 
-    : _path(), _serverAbsolutePath(Path::createDummy()), _pathIsDirectory(false) {
-    std::string method_str;
-    source >> method_str >> _url >> _version;
-
-    _url = urlDecode(Utils::trim(_url));
-    _version = Utils::trim(_version);
-    _method = stringToMethod(Utils::trim(method_str));
-}
+/// @brief Build the request line from the tokens found by the RequestParser.
+RequestLine::RequestLine(std::string_view method, std::string_view target, std::string_view version)
+    : _method(stringToMethod(method)), _url(urlDecode(target)), _version(version),
+    _path(), _serverAbsolutePath(Path::createDummy()), _pathIsDirectory(false), _file(), _precompressedFile() {}
 
 RequestLine::RequestLine(const RequestLine &other)
-    : _method(other._method), _url(other._url), _version(other._version), _path(other._path), _serverAbsolutePath(other._serverAbsolutePath), _pathIsDirectory(other._pathIsDirectory) {}
+    : _method(other._method), _url(other._url), _version(other._version), _path(other._path), _serverAbsolutePath(other._serverAbsolutePath), _pathIsDirectory(other._pathIsDirectory), _file(other._file), _precompressedFile(other._precompressedFile) {}
 
 RequestLine &RequestLine::operator=(const RequestLine &other) {
     if (this != &other) {
@@ -57,6 +52,8 @@ RequestLine &RequestLine::operator=(const RequestLine &other) {
         _path = other._path;
         _serverAbsolutePath = other._serverAbsolutePath;
         _pathIsDirectory = other._pathIsDirectory;
+        _file = other._file;
+        _precompressedFile = other._precompressedFile;
     }
     return *this;
 }
@@ -65,17 +62,18 @@ RequestLine::~RequestLine() {}
 
 /// @brief Fetches the correct path from the index rule.
 /// @param rule The index rule containing the list of index pages.
+/// @param fileCache The cache the index candidates are looked up in, missing ones included.
 /// @return Returns true if a valid index file was found and set as the path, false otherwise.
-bool RequestLine::_fetchCorrectPathFromIndexRule(const IndexRule &rule) {
-    PathStat pathStat{};
-
+bool RequestLine::_fetchCorrectPathFromIndexRule(const IndexRule &rule, OpenFileCache &fileCache) {
     for (const auto &indexPage : rule.getIndexFiles()) {
         Path indexPath = _path;
         indexPath.append(indexPage);
 
-        if (stat(indexPath.str().c_str(), &pathStat) == 0) {
-            DEBUG("Using index file: " << _path.str());
+        std::shared_ptr<const OpenFile> indexFile = fileCache.lookup(indexPath.str());
+        if (indexFile->exists) {
+            DEBUG("Using index file: " << indexPath.str());
             _path = indexPath;
+            _file = indexFile;
             return (true);
         }
     }
@@ -86,17 +84,39 @@ bool RequestLine::_fetchCorrectPathFromIndexRule(const IndexRule &rule) {
 /// @brief Translates the URL of the request line to a Path object based on the given route. If the path is a directory
 /// and the index rule is set, it will try to fetch the correct path from the index rule.
 /// @param route The location rule that contains the routing information for the request.
-void RequestLine::translateUrl(const std::string &serverRelativePath, const LocationRule &route) {
+/// @param fileCache The cache the resolved path is looked up in, see getFile() and getPrecompressedFile().
+void RequestLine::translateUrl(const std::string &serverRelativePath, const LocationRule &route, OpenFileCache &fileCache) {
     _path = Path(serverRelativePath);
     _path.append(Path::createFromUrl(_url, route).str());
     _serverAbsolutePath = Path(serverRelativePath);
 
-    PathStat pathStat{};
-    if (stat(_path.str().c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode)) {
-        _pathIsDirectory = !(route.index.isSet() && _fetchCorrectPathFromIndexRule(route.index));
+    _file = fileCache.lookup(_path.str());
+    if (_file->isDirectory) {
+        _pathIsDirectory = !(route.index.isSet() && _fetchCorrectPathFromIndexRule(route.index, fileCache));
     } else {
         _pathIsDirectory = false;
     }
+
+    _precompressedFile = nullptr;
+    if (route.gzipStatic.isEnabled() && _file->isRegular)
+        _fetchPrecompressedFile(fileCache);
+}
+
+/// @brief Look for a gzip sidecar ("<file>.gz") of the resolved file, see getPrecompressedFile().
+/// @details A sidecar older than the file it was made from is stale and ignored.
+void RequestLine::_fetchPrecompressedFile(OpenFileCache &fileCache) {
+    std::shared_ptr<const OpenFile> sidecar = fileCache.lookup(_path.str() + ".gz");
+    if (!sidecar->isRegular)
+        return ;
+
+    const timespec &original = _file->modificationTime;
+    const timespec &compressed = sidecar->modificationTime;
+    if (compressed.tv_sec < original.tv_sec || (compressed.tv_sec == original.tv_sec && compressed.tv_nsec < original.tv_nsec)) {
+        DEBUG("Ignoring stale precompressed file: " << _path.str() << ".gz");
+        return ;
+    }
+
+    _precompressedFile = sidecar;
 }
 
 /// @brief Checks if the request line is valid.
@@ -139,6 +159,17 @@ bool RequestLine::pathIsDirectory() const {
     return _pathIsDirectory;
 }
 
+/// @brief Returns the gzip sidecar of the resolved file when gzip_static is on, nullptr if there is none.
+const std::shared_ptr<const OpenFile> &RequestLine::getPrecompressedFile() const {
+    return _precompressedFile;
+}
+
+/// @brief Returns what was found at the local path when the URL was translated.
+/// @details For a directory resolved through its index rule, this is the index file.
+const std::shared_ptr<const OpenFile> &RequestLine::getFile() const {
+    return _file;
+}
+
 std::ostream &operator<<(std::ostream &os, const RequestLine &request_line) {
     os << request_line.getMethod() << " " << request_line.getRawUrl() << " " << request_line.getVersion();
     return os;
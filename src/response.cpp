@@ -4,20 +4,28 @@
 #include "response.hpp"
 #include "headers.hpp"
 #include "print.hpp"
+#include "Utils.hpp"
 
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <random>
+#include <cerrno>
 #include <ctime>
 
-/// @brief Returns the current time as a formatted string in GMT.
-static std::string get_time_as_readable_string() {
-    std::time_t now = std::time(nullptr);
-    char buffer[150];
-    std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", std::gmtime(&now));
-    return std::string(buffer);
+/// @brief Random delimiter for multipart bodies, long enough to practically never appear in a file.
+static std::string generate_multipart_boundary() {
+    static std::mt19937_64 generator(std::random_device{}());
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(generator()));
+    return (std::string("webserv-") + std::string(buffer, static_cast<size_t>(length)));
 }
 
-Response::Response(Client *client) : _statusCode(HttpStatusCode::OK), _sentHeaders(false), _bodyWriter(), _request(nullptr), _client(client) {}
+Response::Response(Client *client) : _statusCode(HttpStatusCode::OK), _sentHeaders(false), _bodyWriter(), _request(nullptr), _client(client), _encoder() {}
 
 /// @brief Sets the status code for the response.
 /// @param code The HTTP status code to set for the response.
@@ -33,7 +41,7 @@ void Response::setStatusCode(StatusCode code) {
 /// @brief Sets default headers for the response, including Content-Type and Date.
 void Response::setDefaultHeaders() {
     headers.replace(HeaderKey::CacheControl, "no-cache, no-store, must-revalidate");
-    headers.replace(HeaderKey::Date, get_time_as_readable_string());
+    headers.replace(HeaderKey::Date, Utils::formatHttpDate(std::time(nullptr)));
     headers.replace(HeaderKey::RetryAfter, "0");
 }
 
@@ -49,24 +57,42 @@ bool Response::shouldDirectlySendResponse() const {
     return (false);
 }
 
-void Response::sendHeaders(SocketFD &fd) {
+/// @brief Whether the response moves the request body off the socket on its own, instead of from the read buffer.
+bool Response::isReadingSocketDirectly() const {
+    return (false);
+}
+
+/// @brief Serialize the status line and the headers and queue them on the body writer.
+/// @details Nothing is written here: the head goes out with the first body bytes in one writev, or on
+/// its own with the next tick of the body writer, which also keeps whatever part the socket didn't take.
+void Response::sendHeaders() {
     if (headersBeenSent())
         return ;
 
     _sentHeaders = true;
-    std::ostringstream headerStream;
-    headerStream << Response::protocol << "/" << Response::tlsVersion << " "
-       << static_cast<int>(getStatusCode()) << " "
-       << getStatusCodeAsStr(getStatusCode()) << "\r\n"
-       << headers << "\r\n";
-
-    DEBUG("Sending headers: " << headerStream.str());
-    fd.writeAsString(headerStream.str());
+    std::string code = std::to_string(static_cast<int>(getStatusCode()));
+    std::string reason = getStatusCodeAsStr(getStatusCode());
+
+    // "HTTP/1.1 <code> <reason>\r\n", the headers and the empty line, sized up front to fill it in one go
+    std::string head;
+    head.reserve(std::strlen(Response::protocol) + 1 + std::strlen(Response::tlsVersion) + 1 + code.size() + 1
+        + reason.size() + 2 + headers.getSerializedLength() + 2);
+    head.append(Response::protocol).append("/").append(Response::tlsVersion).append(" ")
+        .append(code).append(" ").append(reason).append("\r\n");
+    headers.appendTo(head);
+    head.append("\r\n");
+
+    DEBUG("Sending headers: " << head);
+    _bodyWriter.queue(head);
 }
 
+/// @brief Send the last chunk, ending a chunked body. Any queued bytes go out in the same write.
 ssize_t Response::sendBodyAsChunk(SocketFD &fd, const std::string &body) {
-	if (_request && _request->metadata.getMethod() == Method::HEAD) return static_cast<ssize_t>(body.length());
-	return fd.writeAsString("0\r\n\r\n");
+	if (_request && _request->metadata.getMethod() == Method::HEAD) {
+        _bodyWriter.tick(fd);
+        return static_cast<ssize_t>(body.length());
+    }
+	return _bodyWriter.sendBodyAsHTTPChunk(std::string_view(), fd, true);
 }
 
 ssize_t Response::sendBodyAsString(SocketFD &fd, const std::string &body) {
@@ -83,15 +109,121 @@ HttpStatusCode Response::getFailedResponseStatusCode() const {
     return (HttpStatusCode::OK);
 }
 
+/// @brief Check if a body would be compressed for clients that accept it, which makes the response vary on Accept-Encoding.
+/// @param contentLength Length of the uncompressed body, -1 if it isn't known up front.
+bool Response::isCompressible(const LocationRule *route, std::string_view contentType, ssize_t contentLength) {
+    if (!route || !route->gzip.isEnabled())
+        return (false);
+    if (contentLength >= 0 && static_cast<size_t>(contentLength) < route->gzipMinLength.getMinLength())
+        return (false);
+    return (route->gzipTypes.matches(contentType));
+}
+
+/// @brief Negotiate the content coding right before the headers go out and start the encoder.
+/// @details Content-Length is dropped when the body gets compressed, the caller either frames
+/// the body in chunks or sets the compressed length itself.
+/// @return true if the body has to be sent through `_encoder`.
+bool Response::_setupCompression(ssize_t contentLength) {
+    if (!_request || !_client || !headers.getHeader(HeaderKey::ContentEncoding, "").empty()
+        || !isCompressible(_client->route, headers.getHeader(HeaderKey::ContentType, ""), contentLength))
+        return (false);
+
+    headers.replace(HeaderKey::Vary, "Accept-Encoding");
+    ContentEncoding encoding = ContentEncoder::negotiate(std::string(_request->headers.getHeader(HeaderKey::AcceptEncoding, "")));
+    _encoder = ContentEncoder::create(encoding, _client->route->gzipCompLevel.getLevel());
+    if (!_encoder)
+        return (false);
+
+    headers.remove(HeaderKey::ContentLength);
+    headers.replace(HeaderKey::ContentEncoding, ContentEncoder::getName(encoding));
+    if (!headers.getHeader(HeaderKey::ETag, "").empty())
+        headers.replace(HeaderKey::ETag, ContentEncoder::getVariantETag(std::string(headers.getHeader(HeaderKey::ETag)), encoding));
+    DEBUG("Compressing response body with " << ContentEncoder::getName(encoding));
+    return (true);
+}
+
+/// @brief Compress the next piece of the body and send it as an HTTP chunk, ending the body on a Finish flush.
+/// @return false if the encoder broke, the body can't be completed and the connection gets closed after it.
+bool Response::_sendEncodedChunk(SocketFD &fd, std::string_view data, EncoderFlush flush) {
+    std::string compressed;
+    if (!_encoder->write(data, compressed, flush)) {
+        if (_request)
+            _request->headers.replace(HeaderKey::Connection, "close");
+        return (false);
+    }
+
+    _bodyWriter.sendBodyAsHTTPChunk(compressed, fd, flush == EncoderFlush::Finish);
+    return (true);
+}
+
 FileResponse::FileResponse(Client *client, ReadableFD fileFD, Request *request) :
-    Response(client), _fileFD(std::move(fileFD)), _isFinalChunkSent(false) {
+    Response(client), _fileFD(std::move(fileFD)), _cachedFile(), _isFinalChunkSent(false),
+    _isSendingWithSendfile(false), _isRangeResponse(false), _fileSize(0), _segments(), _segmentIndex(0) {
 	_request = request;
-    headers.replace(HeaderKey::TransferEncoding, "chunked");
-    DEBUG("FileResponse created with file FD: " << _fileFD.get());
+
+    struct stat fileStat;
+    if (fstat(_fileFD.get(), &fileStat) == 0 && S_ISREG(fileStat.st_mode)) {
+        _isSendingWithSendfile = true;
+        _fileSize = fileStat.st_size;
+        _segments.push_back(FileSegment{"", 0, _fileSize});
+        headers.replace(HeaderKey::ContentLength, std::to_string(_fileSize));
+    } else
+        headers.replace(HeaderKey::TransferEncoding, "chunked");
+
+    DEBUG("FileResponse created with file FD: " << _fileFD.get() << (_isSendingWithSendfile ? " (sendfile)" : " (chunked)"));
+}
+
+/// @brief Send a regular file from the open file cache. Its descriptor and size are shared
+/// with the cache, so the file is neither opened nor stat'ed again and is not closed here.
+FileResponse::FileResponse(Client *client, std::shared_ptr<const OpenFile> file, Request *request) :
+    Response(client), _fileFD(), _cachedFile(std::move(file)), _isFinalChunkSent(false),
+    _isSendingWithSendfile(true), _isRangeResponse(false), _fileSize(_cachedFile->size), _segments(), _segmentIndex(0) {
+	_request = request;
+
+    _segments.push_back(FileSegment{"", 0, _fileSize});
+    headers.replace(HeaderKey::ContentLength, std::to_string(_fileSize));
+    DEBUG("FileResponse created with cached file FD: " << _cachedFile->fd << " (sendfile)");
+}
+
+/// @brief Only send parts of a regular file, for a 206 response. A single range is described by
+/// Content-Range, several ones are sent as multipart/byteranges with one part per range.
+/// @param contentType The type of the file, repeated in every part of a multipart body.
+void FileResponse::setRanges(const std::vector<ByteRange> &ranges, const std::string &contentType) {
+    if (!_isSendingWithSendfile || ranges.empty())
+        return ;
+
+    _isRangeResponse = true;
+    _segments.clear();
+    _segmentIndex = 0;
+
+    if (ranges.size() == 1) {
+        _segments.push_back(FileSegment{"", ranges[0].first, ranges[0].last + 1});
+        headers.replace(HeaderKey::ContentRange, ranges[0].toContentRange(_fileSize));
+        headers.replace(HeaderKey::ContentLength, std::to_string(ranges[0].length()));
+        return ;
+    }
+
+    std::string boundary = generate_multipart_boundary();
+    off_t contentLength = 0;
+    for (const ByteRange &range : ranges) {
+        std::string prefix = "\r\n--" + boundary + "\r\n";
+        prefix.append(headerKeyToString(HeaderKey::ContentType)).append(": ").append(contentType).append("\r\n");
+        prefix.append(headerKeyToString(HeaderKey::ContentRange)).append(": ").append(range.toContentRange(_fileSize)).append("\r\n\r\n");
+
+        contentLength += static_cast<off_t>(prefix.size()) + range.length();
+        _segments.push_back(FileSegment{std::move(prefix), range.first, range.last + 1});
+    }
+
+    std::string closingDelimiter = "\r\n--" + boundary + "--\r\n";
+    contentLength += static_cast<off_t>(closingDelimiter.size());
+    _segments.push_back(FileSegment{std::move(closingDelimiter), 0, 0});
+
+    headers.replace(HeaderKey::ContentType, "multipart/byteranges; boundary=" + boundary);
+    headers.replace(HeaderKey::ContentLength, std::to_string(contentLength));
 }
 
 bool FileResponse::isFullResponseSent() const {
-    return (_isFinalChunkSent && headersBeenSent());
+    return (_isFinalChunkSent && headersBeenSent() && _bodyWriter.isEmpty());
 }
 
 bool FileResponse::shouldDirectlySendResponse() const {
@@ -99,9 +231,15 @@ bool FileResponse::shouldDirectlySendResponse() const {
 }
 
 void FileResponse::handleRequestBody(SocketFD &fd, const Request &request) {
+    _discardRequestBody(fd, request);
+}
+
+/// @brief Drop whatever part of the request body has arrived, for responses that don't use it.
+/// @details Stops at the end of the body, bytes after it are the next pipelined request.
+void Response::_discardRequestBody(SocketFD &fd, const Request &request) {
     switch (request.receivingBodyMode) {
         case ReceivingBodyMode::Chunked: {
-            while (true) {
+            while (!fd.isFinalChunkRead()) {
                 FDReader::HTTPChunk chunk = fd.extractHTTPChunkFromReadBuffer();
                 if (chunk.size == FDReader::HTTPChunk::noChunk) break ;
             }
@@ -110,7 +248,7 @@ void FileResponse::handleRequestBody(SocketFD &fd, const Request &request) {
 
         case ReceivingBodyMode::NotSet:
         case ReceivingBodyMode::ContentLength: {
-            fd.clearReadBuffer();
+            fd.consumeReadBuffer(request.getRemainingBodyLength(static_cast<size_t>(fd.getTotalBodyBytes())));
             return ;
         }
     }
@@ -119,15 +257,30 @@ void FileResponse::handleRequestBody(SocketFD &fd, const Request &request) {
 void FileResponse::handleSocketWriteTick(SocketFD &fd) {
     DEBUG("Handling socket write tick for FileResponse, fd: " << fd.get());
     if (!headersBeenSent()) {
-        sendHeaders(fd);
+        if (!_isRangeResponse && _setupCompression(_isSendingWithSendfile ? static_cast<ssize_t>(_fileSize) : -1))
+            headers.replace(HeaderKey::TransferEncoding, "chunked");
+        // Queued only, the first body bytes of this same tick take the head along
+        sendHeaders();
+    }
+
+    // A HEAD carries the same head as the GET, and ends with it
+    if (_request && _request->metadata.getMethod() == Method::HEAD) {
+        _bodyWriter.tick(fd);
+        _isFinalChunkSent = true;
         return ;
     }
 
+    if (_encoder)
+        return (_sendCompressedFileTick(fd));
+
+    if (_isSendingWithSendfile)
+        return (_sendFileTick(fd));
+
     if (_fileFD.getReaderFDState() != FDState::Closed)
         _fileFD.read();
 
     if (_fileFD.getReaderFDState() == FDState::Closed) {
-        if (_fileFD.getReadBufferSize() == 0 && _bodyWriter.isEmpty() && !_isFinalChunkSent) {
+        if (_fileFD.getReadBufferSize() == 0 && !_bodyWriter.isStalled() && !_isFinalChunkSent) {
             _isFinalChunkSent = true;
             sendBodyAsChunk(fd, "");
             return ;
@@ -137,6 +290,98 @@ void FileResponse::handleSocketWriteTick(SocketFD &fd) {
     _bodyWriter.sendBodyAsHTTPChunk(_fileFD, fd);
 }
 
+int FileResponse::_getFileDescriptor() const {
+    return (_cachedFile ? _cachedFile->fd : _fileFD.get());
+}
+
+/// @brief Move past the segments that are fully sent, the body is complete once none are left.
+void FileResponse::_skipSentSegments() {
+    while (_segmentIndex < _segments.size()
+        && _segments[_segmentIndex].prefix.empty() && _segments[_segmentIndex].start >= _segments[_segmentIndex].end)
+        ++_segmentIndex;
+
+    if (_segmentIndex >= _segments.size() && _bodyWriter.isEmpty())
+        _isFinalChunkSent = true;
+}
+
+/// @brief Send the next piece of a regular file straight from the page cache, or the
+/// multipart delimiter in front of it.
+void FileResponse::_sendFileTick(SocketFD &fd) {
+    _skipSentSegments();
+
+    // The queued head is held back (MSG_MORE) to share its segment with the start of the file,
+    // which is sent right after it in this same tick
+    if (!_bodyWriter.isEmpty())
+        _bodyWriter.tick(fd, _segmentIndex < _segments.size());
+
+    if (_bodyWriter.isEmpty() && _segmentIndex < _segments.size()) {
+        FileSegment &segment = _segments[_segmentIndex];
+
+        if (!segment.prefix.empty()) {
+            std::string prefix;
+            prefix.swap(segment.prefix);
+            _bodyWriter.sendBodyAsString(prefix, fd, segment.start < segment.end);
+        } else {
+            size_t bytesToSend = std::min(static_cast<size_t>(segment.end - segment.start), static_cast<size_t>(SENDFILE_CHUNK_SIZE));
+            ssize_t bytesSent = fd.writeFromFile(_getFileDescriptor(), segment.start, bytesToSend);
+            if (bytesSent < 0)
+                return ;
+
+            if (bytesSent == 0) {
+                // The file shrunk after its size was announced, the connection can't be reused anymore
+                ERROR("File fd: " << _getFileDescriptor() << " ended " << (segment.end - segment.start) << " bytes before its Content-Length");
+                if (_request)
+                    _request->headers.replace(HeaderKey::Connection, "close");
+                _segmentIndex = _segments.size();
+            }
+        }
+    }
+
+    _skipSentSegments();
+}
+
+/// @brief Compress the next slice of the file and send it as a chunk.
+/// @details Regular files are read at explicit offsets, so a shared descriptor from the open file
+/// cache is never moved. A file that shrunk simply ends the chunked body early.
+void FileResponse::_sendCompressedFileTick(SocketFD &fd) {
+    if (_bodyWriter.isStalled())
+        return (_bodyWriter.tick(fd), void());
+    if (_isFinalChunkSent)
+        return ;
+
+    std::string slice;
+    std::string_view data;
+    bool isLast;
+
+    if (_isSendingWithSendfile) {
+        FileSegment &segment = _segments.front();
+        slice.resize(std::min(static_cast<size_t>(segment.end - segment.start), static_cast<size_t>(COMPRESSION_READ_SIZE)));
+        ssize_t bytesRead = pread(_getFileDescriptor(), slice.data(), slice.size(), segment.start);
+        if (bytesRead == -1 && errno == EINTR)
+            return ;
+        ERROR_IF(bytesRead == -1, "Failed to read file fd: " << _getFileDescriptor() << " for compression");
+
+        slice.resize(static_cast<size_t>(std::max(bytesRead, static_cast<ssize_t>(0))));
+        segment.start += static_cast<off_t>(slice.size());
+        isLast = bytesRead <= 0 || segment.start >= segment.end;
+        data = slice;
+    } else {
+        if (_fileFD.getReaderFDState() != FDState::Closed)
+            _fileFD.read();
+
+        data = _fileFD.peekReadBuffer(COMPRESSION_READ_SIZE);
+        isLast = _fileFD.getReaderFDState() == FDState::Closed && data.size() == _fileFD.getReadBufferSize();
+        if (data.empty() && !isLast)
+            return (_bodyWriter.tick(fd), void());
+    }
+
+    if (!_sendEncodedChunk(fd, data, isLast ? EncoderFlush::Finish : EncoderFlush::None))
+        isLast = true;
+    if (!_isSendingWithSendfile)
+        _fileFD.consumeReadBuffer(data.size());
+    _isFinalChunkSent = isLast;
+}
+
 void FileResponse::terminateResponse() {
     _fileFD.close();
 }
@@ -147,6 +392,69 @@ FileResponse::~FileResponse() {
 }
 
 
+MemoryResponse::MemoryResponse(Client *client, std::shared_ptr<const CachedFile> file, Request *request) :
+    Response(client), _file(std::move(file)), _responseHeaders(), _bytesSent(0), _isFullResponseSent(false) {
+	_request = request;
+    DEBUG("MemoryResponse created with content size: " << _file->body.size());
+}
+
+bool MemoryResponse::isFullResponseSent() const {
+    return (_isFullResponseSent);
+}
+
+bool MemoryResponse::shouldDirectlySendResponse() const {
+    return (true);
+}
+
+void MemoryResponse::handleRequestBody(SocketFD &fd, const Request &request) {
+    _discardRequestBody(fd, request);
+}
+
+/// @brief Send as much of the cached head, the response headers and the body as the socket takes.
+/// @details The response headers are only serialized on the first tick, once the client has
+/// added everything it wants (Connection, cookies) to them.
+void MemoryResponse::handleSocketWriteTick(SocketFD &fd) {
+    if (_isFullResponseSent)
+        return ;
+
+    if (_bytesSent == 0 && _responseHeaders.empty()) {
+        headers.appendTo(_responseHeaders);
+        _responseHeaders.append("\r\n");
+    }
+
+    bool isHead = _request && _request->metadata.getMethod() == Method::HEAD;
+    std::string_view parts[] = {_file->head, _responseHeaders, isHead ? std::string_view() : std::string_view(_file->body)};
+
+    iovec vectors[3];
+    int count = 0;
+    size_t skip = _bytesSent;
+    size_t remaining = 0;
+    for (std::string_view part : parts) {
+        if (skip >= part.size()) {
+            skip -= part.size();
+            continue ;
+        }
+        vectors[count].iov_base = const_cast<char *>(part.data() + skip);
+        vectors[count].iov_len = part.size() - skip;
+        remaining += vectors[count++].iov_len;
+        skip = 0;
+    }
+
+    if (count > 0) {
+        ssize_t bytesWritten = fd.writeAsVector(vectors, count);
+        if (bytesWritten <= 0)
+            return ;
+        _bytesSent += static_cast<size_t>(bytesWritten);
+        if (static_cast<size_t>(bytesWritten) < remaining)
+            return ;
+    }
+
+    _isFullResponseSent = true;
+}
+
+void MemoryResponse::terminateResponse() {}
+
+
 
 
 
@@ -154,9 +462,8 @@ FileResponse::~FileResponse() {
 StaticResponse::StaticResponse(Client *client, const std::string &content, Request *request) :
     Response(client), _content(content) {
 	_request = request;
-	if (_request->metadata.getMethod() != Method::HEAD)
-    	headers.replace(HeaderKey::ContentLength, std::to_string(_content.size()));
-	else headers.replace(HeaderKey::ContentLength, "0");
+	// A HEAD announces the length the GET would send
+	headers.replace(HeaderKey::ContentLength, std::to_string(_content.size()));
     DEBUG("StaticResponse created with content size: " << _content.size());
 }
 
@@ -165,7 +472,7 @@ StaticResponse::~StaticResponse() {
 }
 
 bool StaticResponse::isFullResponseSent() const {
-    return (headersBeenSent() && _content.empty());
+    return (headersBeenSent() && _content.empty() && _bodyWriter.isEmpty());
 }
 
 bool StaticResponse::shouldDirectlySendResponse() const {
@@ -173,29 +480,37 @@ bool StaticResponse::shouldDirectlySendResponse() const {
 }
 
 void StaticResponse::handleRequestBody(SocketFD &fd, const Request &request) {
-    switch (request.receivingBodyMode) {
-        case ReceivingBodyMode::Chunked: {
-            while (true) {
-                FDReader::HTTPChunk chunk = fd.extractHTTPChunkFromReadBuffer();
-                if (chunk.size == FDReader::HTTPChunk::noChunk) break ;
-            }
-            return ;
-        }
-
-        case ReceivingBodyMode::NotSet:
-        case ReceivingBodyMode::ContentLength: {
-            fd.clearReadBuffer();
-            return ;
-        }
-    }
+    _discardRequestBody(fd, request);
 }
 
 void StaticResponse::handleSocketWriteTick(SocketFD &fd) {
     DEBUG("Handling socket write tick for StaticResponse, fd: " << fd.get());
-    if (!headersBeenSent())
-        sendHeaders(fd);
-    if (!_content.empty())
+    if (!headersBeenSent()) {
+        if (_setupCompression(static_cast<ssize_t>(_content.size())))
+            _compressContent();
+        sendHeaders();
+    }
+
+    // The body writer keeps whatever the socket didn't take, so the content is handed over only once,
+    // along with the queued head
+    if (!_content.empty() && _request->metadata.getMethod() != Method::HEAD)
         _bodyWriter.sendBodyAsString(_content, fd);
+    else
+        _bodyWriter.tick(fd);
+    _content.clear();
+}
+
+/// @brief Replace the content with its compressed form, which is known in full, so it keeps a Content-Length.
+void StaticResponse::_compressContent() {
+    std::string compressed;
+    if (!_encoder->write(_content, compressed, EncoderFlush::Finish)) {
+        headers.remove(HeaderKey::ContentEncoding);
+        compressed = _content;
+    }
+
+    _content.swap(compressed);
+    headers.replace(HeaderKey::ContentLength, std::to_string(_content.size()));
+    _encoder.reset();
 }
 
 void StaticResponse::terminateResponse() {
@@ -10,6 +10,7 @@
 
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <sys/timerfd.h>
 #include <sys/epoll.h>
 #include <sys/types.h>
 #include <sys/types.h>
@@ -68,14 +69,29 @@ public:
 ServerClientInfo::ServerClientInfo(SocketFD fd, Client *client)
     : fd(std::move(fd)), client(client) {}
 
+void FDSlot::reset() {
+    type = FDSlotType::Empty;
+    client.reset();
+    readable.reset();
+    writable.reset();
+}
+
 Server::Server(HTTPRule &http) :
     _portToConfigs(),
     _sessionManager("sessions"),
     _server_fd(-1),
     _epoll_fd(-1),
+    _timer_fd(-1),
+    _timerFdDeadline(std::chrono::steady_clock::time_point::min()),
     _timer(),
+    _openFileCache(),
+    _memoryCache(),
+    _fastCGIPool(*this),
+    _cgiPool(*this),
+    _cgiEnvironments(),
     _httpRule(http),
-    _clientDescriptors(),
+    _fdSlots(),
+    _ring(),
     _serverAddress(),
     _serverExecutablePath(std::filesystem::current_path().string())
 {
@@ -83,6 +99,8 @@ Server::Server(HTTPRule &http) :
     try {
         for (const auto &pair : listeningPortsToConfigs)
             this->_setupSocket(pair.first, pair.second);
+        if (http.ioEngine.getEngine() == IOEngine::IOUring)
+            this->_setupIOUring();
         this->_setupEpoll();
     } catch (const ServerCreationException &e) {
         for (const auto &pair : _portToConfigs) {
@@ -91,94 +109,81 @@ Server::Server(HTTPRule &http) :
         throw;
     }
 
+    _memoryCache.configure(http.memoryCache.getMaxMemory(), http.memoryCache.getMaxFileSize());
+    _cgiPool.configure(http.cgiPrefork.getMaxIdle(), http.cgiPrefork.getSpawnRate());
+
     _timer.addEvent(std::chrono::seconds(SESSION_CLEANUP_INTERVAL), [this]() {
         _sessionManager.cleanUpExpiredSessions();
     }, true);
-    _timer.addEvent(std::chrono::seconds(1), [this]() {
-        _checkHangingConnections();
-    }, true);
-}
-
-Server::Server(const Server &other) :
-    _portToConfigs(other._portToConfigs),
-    _sessionManager(other._sessionManager),
-    _server_fd(other._server_fd),
-    _epoll_fd(other._epoll_fd),
-    _timer(other._timer),
-    _httpRule(other._httpRule),
-    _clientDescriptors(other._clientDescriptors),
-    _serverAddress(other._serverAddress),
-    _serverExecutablePath(other._serverExecutablePath) {}
-
-Server &Server::operator=(const Server &other) {
-    if (this != &other) {
-        _portToConfigs = other._portToConfigs;
-        _sessionManager = other._sessionManager;
-        _server_fd = other._server_fd;
-        _epoll_fd = other._epoll_fd;
-        _timer = other._timer;
-        _httpRule = other._httpRule;
-        _clientDescriptors = other._clientDescriptors;
-        _serverAddress = other._serverAddress;
-        _serverExecutablePath = other._serverExecutablePath;
-    }
-    return *this;
 }
 
 Server::~Server() {
     DEBUG("Server destructor called, cleaning up resources");
     _timer.clear();
+    if (_ring)
+        FD::useSubmissionRing(nullptr);
 }
 
 /// @brief Clean up the server resources, closing sockets and cleaning up sessions.
 void Server::cleanUp() {
-    for (auto &clientPair : _clientDescriptors) {
-        clientPair.second.fd.close();
-        delete clientPair.second.client;
+    for (FDSlot &slot : _fdSlots) {
+        if (slot.type == FDSlotType::Client) {
+            slot.client->fd.close();
+            delete slot.client->client;
+        }
+    }
+    _fastCGIPool.clear();
+    _cgiPool.clear();
+    _fdSlots.clear();
+
+    // Flush the queued closes while the epoll instance they refer to is still open
+    if (_ring) {
+        _ring->submit();
+        FD::useSubmissionRing(nullptr);
     }
-    _clientDescriptors.clear();
-    _readableDescriptors.clear();
-    _writableDescriptors.clear();
 
     for (const auto &[serverFd, configs] : _portToConfigs) {
         if (serverFd == -1) continue;
         close(serverFd);
     }
 
+    if (_timer_fd != -1)
+        close(_timer_fd);
+
+    _openFileCache.clear();
+
+    if (_memoryCache.isEnabled()) {
+        PRINT("Memory cache: " << _memoryCache.getHits() << " hits, " << _memoryCache.getMisses() << " misses, "
+            << _memoryCache.getEvictions() << " evictions, " << _memoryCache.getUsedMemory() << " bytes in use");
+        _memoryCache.clear();
+    }
+
     if (_epoll_fd != -1)
         close(_epoll_fd);
 
     _sessionManager.shutdown();
 }
 
-void Server::_checkHangingConnections() {
-    DEBUG("Checking for hanging connections");
-	std::vector<int> fdsToDelete;
-
-    for (auto &[fd, clientInfo] : _clientDescriptors) {
-        if (clientInfo.client->isTimedOut(_httpRule, clientInfo.fd)) {
-            DEBUG("Client " << clientInfo.client->getClientIP() << ":" << clientInfo.client->getClientPort()
-                  << " has timed out, returning RequestTimeout response");
-            clientInfo.client->switchResponseToErrorResponse(HttpStatusCode::RequestTimeout, clientInfo.fd);
-        }
-
-        if (clientInfo.client->shouldBeClosed(_httpRule, clientInfo.fd)) {
-            DEBUG("Client " << clientInfo.client->getClientIP() << ":" << clientInfo.client->getClientPort()
-                  << " should be closed, closing connection");
-			clientInfo.fd.close();
-			delete clientInfo.client;
-			fdsToDelete.push_back(fd); 
-        }
-    }
+/// @brief Fetch the dispatch slot for a file descriptor, growing the table if needed.
+FDSlot &Server::_slotAt(int fd) {
+    if (static_cast<size_t>(fd) >= _fdSlots.size())
+        _fdSlots.resize(std::max(static_cast<size_t>(fd) + 1, _fdSlots.size() * 2));
+    return _fdSlots[fd];
+}
 
-	for (int fd : fdsToDelete)
-        _clientDescriptors.erase(fd);
+/// @brief Look up the dispatch slot of a file descriptor if it holds a handler of the given type.
+/// @return A pointer to the slot, or nullptr if the fd is untracked or of another type.
+FDSlot *Server::_findSlot(int fd, FDSlotType type) {
+    if (fd < 0 || static_cast<size_t>(fd) >= _fdSlots.size())
+        return (nullptr);
+    FDSlot &slot = _fdSlots[fd];
+    return (slot.type == type ? &slot : nullptr);
 }
 
 /// @brief Set up the server socket
 /// @throws ServerCreationException if socket creation, binding, or listening fails
 void Server::_setupSocket(int listenPort, const std::vector<ServerConfig> &configs) {
-	int serverFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	int serverFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
 	if (serverFd == -1)
 		throw ServerCreationException("Failed to create socket");
 
@@ -186,6 +191,11 @@ void Server::_setupSocket(int listenPort, const std::vector<ServerConfig> &confi
 	if (setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) == -1)
 		throw ServerCreationException("Failed to set socket options");
 
+	// Every worker binds its own listening socket; the kernel balances connections between them
+	if (_httpRule.workerProcesses.getWorkerCount() > 1
+		&& setsockopt(serverFd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == -1)
+		throw ServerCreationException("Failed to set SO_REUSEPORT on socket");
+
 	sockaddr_in address{};
 	address.sin_family = AF_INET;
 	address.sin_addr.s_addr = INADDR_ANY;
@@ -203,14 +213,46 @@ void Server::_setupSocket(int listenPort, const std::vector<ServerConfig> &confi
     PRINT("Server " << configs[0].serverName.getServerName() << " is listening on port " << listenPort);
 }
 
+/// @brief Try to create the io_uring used by the io_uring engine, staying on plain epoll if that fails.
+/// @details The ring only takes accepts, epoll_ctl calls and closes, socket reads and writes stay on epoll.
+void Server::_setupIOUring() {
+    try {
+        _ring = std::make_unique<IOUring>();
+        PRINT("io_uring engine: accepts, epoll updates and closes are batched on the ring, reads and writes stay on epoll");
+    } catch (const std::exception &e) {
+        ERROR("io_uring engine unavailable, falling back to epoll: " << e.what());
+        _ring.reset();
+    }
+}
+
 /// @brief Set up the epoll instance and add the server socket to it
+/// @details With the io_uring engine the listeners get a multishot accept instead,
+/// and the ring itself is watched by epoll to pick up its completions.
 /// @throws ServerCreationException if epoll creation or adding the server socket fails
 void Server::_setupEpoll() {
-	_epoll_fd = epoll_create1(0);
+	_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
 	if (_epoll_fd == -1)
 		throw ServerCreationException("Failed to create epoll instance");
 
+    if (_ring) {
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = _ring->getFd();
+
+		if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _ring->getFd(), &event) == -1)
+			throw ServerCreationException("Failed to add io_uring to epoll");
+		_slotAt(_ring->getFd()).type = FDSlotType::Ring;
+		FD::useSubmissionRing(_ring.get());
+    }
+
     for (const auto &[serverFd, configs] : _portToConfigs) {
+		if (_ring) {
+			if (!_ring->queueMultishotAccept(serverFd))
+				throw ServerCreationException("Failed to queue accept on io_uring");
+			_slotAt(serverFd).type = FDSlotType::Listener;
+			continue ;
+		}
+
 		epoll_event event{};
 		event.events = EPOLLIN | EPOLLET;
 		event.data.fd = serverFd;
@@ -219,42 +261,162 @@ void Server::_setupEpoll() {
 			perror("epoll_ctl");
 			throw ServerCreationException("Failed to add socket to epoll");
 		}
+		_slotAt(serverFd).type = FDSlotType::Listener;
+    }
+
+    this->_setupTimerFd();
+    this->_setupOpenFileCache();
+}
+
+/// @brief Create a timerfd in the epoll set, so timer deadlines wake the event loop like any other event.
+/// @details Without it, runOnce falls back to passing the next deadline as the epoll_wait timeout.
+void Server::_setupTimerFd() {
+    _timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (_timer_fd == -1) {
+        ERROR("Failed to create timerfd, falling back to epoll_wait timeouts: " << strerror(errno));
+        return ;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = _timer_fd;
+
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _timer_fd, &event) == -1) {
+        ERROR("Failed to add timerfd to epoll, falling back to epoll_wait timeouts: " << strerror(errno));
+        close(_timer_fd);
+        _timer_fd = -1;
+        return ;
+    }
+    _slotAt(_timer_fd).type = FDSlotType::Timer;
+}
+
+/// @brief Size the open file cache from the config and have epoll report its inotify events.
+void Server::_setupOpenFileCache() {
+    auto validity = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(_httpRule.openFileCache.validity.getSeconds()));
+    _openFileCache.configure(_httpRule.openFileCache.getMaxEntries(), validity);
+    if (_openFileCache.getNotifyFd() == -1)
+        return ;
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = _openFileCache.getNotifyFd();
+
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _openFileCache.getNotifyFd(), &event) == -1) {
+        ERROR("Failed to add inotify to epoll, cached files are only refreshed on expiry: " << strerror(errno));
+        return ;
+    }
+    _slotAt(_openFileCache.getNotifyFd()).type = FDSlotType::FileNotify;
+}
+
+/// @brief Point the timerfd at the next timer deadline, rounded up to the configured timer resolution.
+/// @details The syscall is skipped while the deadline stays the same, which it does for most loop iterations.
+void Server::_armTimerFd() {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    if (_timer.getNextEventTime(deadline)) {
+        auto resolution = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(_httpRule.timerResolution.resolution.getSeconds()));
+        if (resolution > std::chrono::steady_clock::duration::zero()) {
+            auto sinceEpoch = deadline.time_since_epoch();
+            deadline = std::chrono::steady_clock::time_point((sinceEpoch + resolution - std::chrono::steady_clock::duration(1)) / resolution * resolution);
+        }
+    }
+
+    if (deadline == _timerFdDeadline)
+        return ;
+
+    // An all-zero value disarms the timer
+    itimerspec spec{};
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+        auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+        spec.it_value.tv_sec = sinceEpoch.count() / 1000000000;
+        spec.it_value.tv_nsec = std::max<long>(sinceEpoch.count() % 1000000000, spec.it_value.tv_sec == 0);
+    }
+
+    if (timerfd_settime(_timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr) == -1) {
+        ERROR("Failed to arm timerfd: " << strerror(errno));
+        return ;
     }
+    _timerFdDeadline = deadline;
 }
 
 /// @brief Handle a new client connection by accepting it and adding it to the epoll instance.
-/// @throws ClientConnectionException if accepting the connection or setting it to non-blocking fails
+/// @details Sockets are accepted non-blocking and close-on-exec, so CGI scripts never inherit them.
 void Server::_handleNewConnection(int sourceFd) {
     sockaddr_in client_address{};
     socklen_t client_len = sizeof(client_address);
 
     while (true) {
-        int fd = accept(sourceFd, reinterpret_cast<sockaddr *>(&client_address), &client_len);
+        int fd = accept4(sourceFd, reinterpret_cast<sockaddr *>(&client_address), &client_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
         SocketFD clientFD(fd, DEFAULT_MAX_BUFFER_SIZE);
         if (!clientFD)
             return ;
 
-        if (clientFD.setNonBlocking() == -1) {
-            clientFD.close();
-            return ;
-        }
-
-        if (clientFD.connectToEpoll(_epoll_fd, DEFAULT_EPOLLIN_EVENTS) == -1) {
-            clientFD.close();
+        if (!_registerClient(clientFD, sourceFd, client_address))
             return ;
-        }
+    }
+}
 
-        Client *client = new Client(*this, sourceFd, inet_ntoa(client_address.sin_addr), ntohs(client_address.sin_port));
-        auto it = _clientDescriptors.emplace(clientFD, ServerClientInfo(std::move(clientFD), client));
-        if (it.second == false) {
-            clientFD.close();
-            delete client;
-            return ;
-        }
+/// @brief Start tracking an accepted (non-blocking) client socket.
+/// @return false if the client could not be registered, in which case the socket is closed.
+bool Server::_registerClient(SocketFD &clientFD, int sourceFd, const sockaddr_in &client_address) {
+    if (clientFD.connectToEpoll(_epoll_fd, DEFAULT_EPOLLIN_EVENTS) == -1) {
+        clientFD.close();
+        return (false);
+    }
 
-        DEBUG("New client connected: " << inet_ntoa(client_address.sin_addr) << ":" << ntohs(client_address.sin_port));
-        DEBUG("Client FD: " << it.first->second.fd.get() << ", Server FD: " << sourceFd);
+    FDSlot &slot = _slotAt(clientFD);
+    if (slot.type != FDSlotType::Empty) {
+        ERROR("Accepted fd " << clientFD.get() << " is still tracked, dropping connection");
+        clientFD.close();
+        return (false);
     }
+
+    Client *client = new Client(*this, sourceFd, inet_ntoa(client_address.sin_addr), ntohs(client_address.sin_port));
+    slot.type = FDSlotType::Client;
+    slot.client = std::make_unique<ServerClientInfo>(std::move(clientFD), client);
+
+    client->armTimeout(slot.client->fd);
+
+    DEBUG("New client connected: " << inet_ntoa(client_address.sin_addr) << ":" << ntohs(client_address.sin_port));
+    DEBUG("Client FD: " << slot.client->fd.get() << ", Server FD: " << sourceFd);
+    return (true);
+}
+
+/// @brief Handle the completions posted by the io_uring engine.
+void Server::_handleRingCompletions() {
+    _ring->processCompletions([this](const IOUring::Completion &completion) {
+        switch (completion.operation) {
+            case IOUringOperation::Accept: {
+                if (completion.result >= 0) {
+                    SocketFD clientFD(completion.result, DEFAULT_MAX_BUFFER_SIZE);
+                    sockaddr_in client_address{};
+                    socklen_t client_len = sizeof(client_address);
+
+                    if (getpeername(clientFD, reinterpret_cast<sockaddr *>(&client_address), &client_len) == -1)
+                        clientFD.close();
+                    else
+                        _registerClient(clientFD, completion.fd, client_address);
+                } else
+                    ERROR("io_uring accept failed on fd: " << completion.fd << ": " << strerror(-completion.result));
+
+                // The kernel ended the multishot accept, arm it again
+                if (!(completion.flags & IORING_CQE_F_MORE) && _findSlot(completion.fd, FDSlotType::Listener))
+                    ERROR_IF(!_ring->queueMultishotAccept(completion.fd), "Failed to re-arm accept on fd: " << completion.fd);
+                return ;
+            }
+
+            case IOUringOperation::EpollCtl: {
+                ERROR_IF(completion.result < 0, "io_uring epoll_ctl failed for fd: " << completion.fd << ": " << strerror(-completion.result));
+                return ;
+            }
+
+            case IOUringOperation::Close: {
+                ERROR_IF(completion.result < 0, "io_uring close failed for fd: " << completion.fd << ": " << strerror(-completion.result));
+                return ;
+            }
+        }
+    });
 }
 
 /// @brief Fetch the server configuration for a request based on the Host header
@@ -305,42 +467,49 @@ std::shared_ptr<SessionMetaData> Server::fetchUserSession(Request &request, Resp
 }
 
 void Server::trackCallbackFD(ReadableFD &fd, std::function<void(ReadableFD&, short)> callback) {
-    _readableDescriptors.insert({fd.get(), FDEvent<ReadableFD&>{fd, callback}});
+    FDSlot &slot = _slotAt(fd.get());
+    if (slot.type != FDSlotType::Empty) {
+        ERROR("Failed to track ReadableFD: " << fd.get() << ", fd is already tracked");
+        return ;
+    }
+    slot.type = FDSlotType::Readable;
+    slot.readable = std::make_unique<FDEvent<ReadableFD&>>(FDEvent<ReadableFD&>{fd, std::move(callback)});
     DEBUG("Tracking ReadableFD: " << fd.get());
 }
 
 void Server::trackCallbackFD(WritableFD &fd, std::function<void(WritableFD&, short)> callback) {
-    _writableDescriptors.insert({fd.get(), FDEvent<WritableFD&>{fd, callback}});
+    FDSlot &slot = _slotAt(fd.get());
+    if (slot.type != FDSlotType::Empty) {
+        ERROR("Failed to track WritableFD: " << fd.get() << ", fd is already tracked");
+        return ;
+    }
+    slot.type = FDSlotType::Writable;
+    slot.writable = std::make_unique<FDEvent<WritableFD&>>(FDEvent<WritableFD&>{fd, std::move(callback)});
     DEBUG("Tracking WritableFD: " << fd.get());
 }
 
 void Server::untrackCallbackFD(int fd) {
-    auto readableIt = _readableDescriptors.find(fd);
-    if (readableIt != _readableDescriptors.end()) {
-        _readableDescriptors.erase(readableIt);
-        DEBUG("Untracked ReadableFD: " << fd);
-        return ;
-    }
-
-    auto writableIt = _writableDescriptors.find(fd);
-    if (writableIt != _writableDescriptors.end()) {
-        _writableDescriptors.erase(writableIt);
-        DEBUG("Untracked WritableFD: " << fd);
+    FDSlot *slot = _findSlot(fd, FDSlotType::Readable);
+    if (!slot)
+        slot = _findSlot(fd, FDSlotType::Writable);
+    if (!slot) {
+        ERROR("Failed to untrack FD: " << fd << ", not found in tracked descriptors");
         return ;
     }
 
-    ERROR("Failed to untrack FD: " << fd << ", not found in tracked descriptors");
+    DEBUG("Untracked " << (slot->type == FDSlotType::Readable ? "ReadableFD: " : "WritableFD: ") << fd);
+    slot->reset();
 }
 
 /// @brief Untrack and close a file descriptor.
 /// @details This function removes the file descriptor from the server's descriptor map and closes it.
 /// @param fd The file descriptor to untrack and close.
 void Server::untrackClient(int fd) {
-    auto it = _clientDescriptors.find(fd);
-    if (it != _clientDescriptors.end()) {
-        it->second.fd.close();
-        delete it->second.client;
-        _clientDescriptors.erase(it);
+    FDSlot *slot = _findSlot(fd, FDSlotType::Client);
+    if (slot) {
+        slot->client->fd.close();
+        delete slot->client->client;
+        slot->reset();
         DEBUG("Untracked and closed descriptor for fd: " << fd);
     }
     else
@@ -355,21 +524,22 @@ void Server::_handleClientFD(ServerClientInfo &clientInfo, short revents) {
         int fd = clientInfo.fd.get();
         clientInfo.fd.close();
         delete clientInfo.client;
-        _clientDescriptors.erase(fd);
+        _fdSlots[fd].reset();
         return ;
     }
 
     if (revents & EPOLLIN) {
         clientInfo.fd.setWriterFDState(FDState::OtherFunctionality);
         clientInfo.fd.setReaderFDState(FDState::Ready);
-        ssize_t readerRet = clientInfo.fd.read();
+        // A response splicing the request body takes it off the socket itself
+        ssize_t readerRet = clientInfo.client->isReadingSocketDirectly() ? 0 : clientInfo.fd.read();
 
         if (clientInfo.fd.getReaderFDState() == FDState::Closed) {
             DEBUG("Client disconnected: " << clientInfo.fd.get());
             int fd = clientInfo.fd.get();
             clientInfo.fd.close();
             delete clientInfo.client;
-            _clientDescriptors.erase(fd);
+            _fdSlots[fd].reset();
             return ;
         }
 
@@ -385,12 +555,25 @@ void Server::_handleClientFD(ServerClientInfo &clientInfo, short revents) {
 }
 
 /// @brief Entry point for the server, running it's event loop once.
-void Server::runOnce() {
+/// @param waitMask Signal mask while waiting for events, so signals blocked otherwise can only interrupt the wait.
+void Server::runOnce(const sigset_t *waitMask) {
     epoll_event events[EPOLL_MAX_EVENTS];
 
-    int event_count = epoll_wait(_epoll_fd, events, EPOLL_MAX_EVENTS, std::min(1, _timer.getNextEventTimeoutMS()));
+    // Hand every epoll update and close queued during the last tick to the kernel at once
+    if (_ring)
+        _ring->submit();
+
+    // Block until an event or the next timer deadline, never poll
+    int timeout = -1;
+    if (_timer_fd != -1)
+        _armTimerFd();
+    else
+        timeout = _timer.getNextEventTimeoutMS();
+
+    int event_count = epoll_pwait(_epoll_fd, events, EPOLL_MAX_EVENTS, timeout, waitMask);
     if (event_count == -1) {
-        ERROR("epoll_wait failed: " << strerror(errno));
+        // Signals and io_uring task work both interrupt the wait, neither is a failure
+        ERROR_IF(errno != EINTR, "epoll_wait failed: " << strerror(errno));
         return ;
     }
 
@@ -402,35 +585,58 @@ void Server::runOnce() {
         DEBUG_IF(events[i].events & EPOLLHUP, "EPOLLHUP event detected for fd: " << fd);
         DEBUG_IF_NOT(events[i].events & (EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP), "Unexpected event for fd: " << fd);
 
-        auto it = _portToConfigs.find(fd);
-        if (it != _portToConfigs.end()) {
-            DEBUG("New connection on listening socket fd: " << fd);
-            _handleNewConnection(it->first);
-            continue ;
-        }
-
-        auto clientIt = _clientDescriptors.find(fd);
-        if (clientIt != _clientDescriptors.end()) {
-            _handleClientFD(clientIt->second, events[i].events);
-            continue ;
-        }
-
-        auto readableIt = _readableDescriptors.find(fd);
-        if (readableIt != _readableDescriptors.end()) {
-            DEBUG("Handling ReadableFD: " << fd);
-            if (events[i].events & EPOLLIN) readableIt->second.fd.setReaderFDState(FDState::Ready);
-            else readableIt->second.fd.setReaderFDState(FDState::Awaiting);
-            readableIt->second.callback(readableIt->second.fd, events[i].events);
-            continue ;
-        }
-
-        auto writableIt = _writableDescriptors.find(fd);
-        if (writableIt != _writableDescriptors.end()) {
-            DEBUG("Handling WritableFD: " << fd);
-            if (events[i].events & EPOLLOUT) writableIt->second.fd.setWriterFDState(FDState::Ready);
-            else writableIt->second.fd.setWriterFDState(FDState::Awaiting);
-            writableIt->second.callback(writableIt->second.fd, events[i].events);
-            continue ;
+        FDSlot *slot = (fd >= 0 && static_cast<size_t>(fd) < _fdSlots.size()) ? &_fdSlots[fd] : nullptr;
+        switch (slot ? slot->type : FDSlotType::Empty) {
+            case FDSlotType::Listener: {
+                DEBUG("New connection on listening socket fd: " << fd);
+                _handleNewConnection(fd);
+                continue ;
+            }
+
+            case FDSlotType::Client: {
+                _handleClientFD(*slot->client, events[i].events);
+                continue ;
+            }
+
+            case FDSlotType::Readable: {
+                DEBUG("Handling ReadableFD: " << fd);
+                FDEvent<ReadableFD&> &event = *slot->readable;
+                if (events[i].events & EPOLLIN) event.fd.setReaderFDState(FDState::Ready);
+                else event.fd.setReaderFDState(FDState::Awaiting);
+                event.callback(event.fd, events[i].events);
+                continue ;
+            }
+
+            case FDSlotType::Writable: {
+                DEBUG("Handling WritableFD: " << fd);
+                FDEvent<WritableFD&> &event = *slot->writable;
+                if (events[i].events & EPOLLOUT) event.fd.setWriterFDState(FDState::Ready);
+                else event.fd.setWriterFDState(FDState::Awaiting);
+                event.callback(event.fd, events[i].events);
+                continue ;
+            }
+
+            case FDSlotType::Ring: {
+                _handleRingCompletions();
+                continue ;
+            }
+
+            case FDSlotType::Timer: {
+                // Drain the expiration count, the due events are processed after this loop
+                uint64_t expirations;
+                ERROR_IF(read(_timer_fd, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN,
+                    "Failed to read timerfd: " << strerror(errno));
+                _timerFdDeadline = std::chrono::steady_clock::time_point::min();
+                continue ;
+            }
+
+            case FDSlotType::FileNotify: {
+                _openFileCache.handleNotifications();
+                continue ;
+            }
+
+            case FDSlotType::Empty:
+                break ;
         }
 
         ERROR("No handler found for fd: " << fd << ", ignoring event (probably because of it being closed previously)");
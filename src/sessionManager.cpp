@@ -1,7 +1,12 @@
 #include "sessionManager.hpp"
 #include "print.hpp"
 
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <filesystem>
+#include <cstring>
 #include <algorithm>
 #include <iostream>
 #include <sstream>
@@ -51,22 +56,51 @@ UserSessionManager::UserSessionManager(const std::string &storagePath) :
 	DEBUG("UserSessionManager initialized with storage path: " << _storagePath);
 
 	std::string managerFile = _storagePath + SESSION_MANAGER_FILE;
-	std::ifstream inFile(managerFile, std::ios::binary);
-	if (inFile.is_open()) {
-		std::vector<char> buffer((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
-		size_t offset = 0;
-		while (offset + SESSION_ID_LENGTH + sizeof(time_t) <= buffer.size()) {
-			std::string sessionId(buffer.data() + offset, SESSION_ID_LENGTH);
-			offset += SESSION_ID_LENGTH;
-			time_t lastAccessTime = *reinterpret_cast<const time_t *>(buffer.data() + offset);
-			offset += sizeof(time_t);
-			_currentSessions[sessionId] = std::make_shared<SessionMetaData>(lastAccessTime, sessionId, getAbsoluteStoragePath(sessionId));
-		}
-		DEBUG("Loaded " << _currentSessions.size() << " sessions from session manager file: " << managerFile);
-		inFile.close();
-	} else {
-		DEBUG("No session manager file found at " << managerFile << " | starting with empty session map");
+	for (const auto &[sessionId, lastAccessTime] : _readManagerFile(managerFile))
+		_currentSessions[sessionId] = std::make_shared<SessionMetaData>(lastAccessTime, sessionId, getAbsoluteStoragePath(sessionId));
+	DEBUG("Loaded " << _currentSessions.size() << " sessions from session manager file: " << managerFile);
+}
+
+/// @brief Reads the session IDs and their last access times stored by a previous shutdown.
+std::map<std::string, time_t> UserSessionManager::_readManagerFile(const std::string &path) {
+	std::map<std::string, time_t> sessions;
+	std::ifstream inFile(path, std::ios::binary);
+	if (!inFile.is_open()) {
+		DEBUG("No session manager file found at " << path);
+		return (sessions);
 	}
+
+	std::vector<char> buffer((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+	size_t offset = 0;
+	while (offset + SESSION_ID_LENGTH + sizeof(time_t) <= buffer.size()) {
+		std::string sessionId(buffer.data() + offset, SESSION_ID_LENGTH);
+		offset += SESSION_ID_LENGTH;
+		time_t lastAccessTime;
+		std::memcpy(&lastAccessTime, buffer.data() + offset, sizeof(time_t));
+		offset += sizeof(time_t);
+		sessions[sessionId] = lastAccessTime;
+	}
+	return (sessions);
+}
+
+/// @brief Refreshes the modification time of the session file, which is what tells other worker processes the session is in use.
+/// @details Done at most once per cleanup interval, well within the age a session file is kept for.
+void UserSessionManager::_touchSessionFile(SessionMetaData &session, time_t now) const {
+	if (session.lastAccessTime + SESSION_CLEANUP_INTERVAL > now)
+		return ;
+	if (utimensat(AT_FDCWD, session.absoluteFilePath.c_str(), nullptr, 0) == -1 && errno != ENOENT)
+		ERROR("Failed to refresh session file: " << session.absoluteFilePath << ": " << strerror(errno));
+}
+
+/// @brief Whether another worker process used the session since this one last did, according to the session file.
+/// @details Takes the later access time over, so the session is only expired once no worker used it for long enough.
+bool UserSessionManager::_isSessionFileInUse(SessionMetaData &session, time_t now) const {
+	struct stat fileStat;
+	if (stat(session.absoluteFilePath.c_str(), &fileStat) == -1)
+		return (false);
+
+	session.lastAccessTime = std::max(session.lastAccessTime, fileStat.st_mtime);
+	return (session.lastAccessTime + SESSION_MAX_STORAGE_AGE >= now);
 }
 
 /// @brief Creates a new UserSession with a unique session ID.
@@ -91,13 +125,18 @@ std::shared_ptr<SessionMetaData> UserSessionManager::createNewSession() {
 /// @param sessionId The session ID to look for or create a new session with.
 /// @return A reference to the UserSession associated with the given session ID.
 std::shared_ptr<SessionMetaData> UserSessionManager::getOrCreateNewSession(const std::string &sessionId) {
+	time_t now = time(nullptr);
 	auto it = _currentSessions.find(sessionId);
 	if (it != _currentSessions.end()) {
-		it->second->lastAccessTime = time(nullptr);
+		_touchSessionFile(*it->second, now);
+		it->second->lastAccessTime = now;
 		return (it->second);
 	}
 
-	std::shared_ptr<SessionMetaData> newSession = std::make_shared<SessionMetaData>(time(nullptr), sessionId, getAbsoluteStoragePath(sessionId));
+	// The session may be one another worker process created, it's in use from here on as well
+	std::shared_ptr<SessionMetaData> newSession = std::make_shared<SessionMetaData>(0, sessionId, getAbsoluteStoragePath(sessionId));
+	_touchSessionFile(*newSession, now);
+	newSession->lastAccessTime = now;
 
 	_currentSessions[sessionId] = newSession;
 	return (newSession);
@@ -110,7 +149,8 @@ bool UserSessionManager::_deleteSession(std::map<std::string, std::shared_ptr<Se
 		return (false);
 	}
 
-	if (it->second.use_count() > 0) {
+	// The map holds one reference itself
+	if (it->second.use_count() > 1) {
 		ERROR("Cannot delete session " << it->first << " with current references");
 		return (false);
 	}
@@ -133,8 +173,8 @@ bool UserSessionManager::sessionHasCurrentReferences(const std::string &sessionI
 	if (it == _currentSessions.end())
 		return (false);
 
-	DEBUG("Session " << sessionId << " has " << it->second.use_count() << " current references");
-	return (it->second.use_count() > 0);
+	DEBUG("Session " << sessionId << " has " << it->second.use_count() - 1 << " current references");
+	return (it->second.use_count() > 1);
 }
 
 /// @brief Cleans up expired sessions from the session manager.
@@ -144,12 +184,13 @@ void UserSessionManager::cleanUpExpiredSessions() {
 	DEBUG("Cleaning up expired sessions");
 
     for (auto it = _currentSessions.begin(); it != _currentSessions.end(); ) {
-		if (it->second.use_count() > 0) {
+		if (it->second.use_count() > 1) {
 			++it;
 			continue;
 		}
 
-        if (it->second->lastAccessTime + SESSION_MAX_STORAGE_AGE < currentTime) {
+		// Other worker processes keep their own map, the session file tells whether one of them still uses it
+        if (it->second->lastAccessTime + SESSION_MAX_STORAGE_AGE < currentTime && !_isSessionFileInUse(*it->second, currentTime)) {
 			DEBUG("Session " << it->first << " has expired and will be removed");
 			DEBUG("Session last access time: " << it->second->lastAccessTime << ", current time: " << currentTime);
             DEBUG((it->second->lastAccessTime + SESSION_MAX_STORAGE_AGE) << " < " << currentTime);
@@ -163,24 +204,48 @@ void UserSessionManager::cleanUpExpiredSessions() {
 }
 
 /// @brief Cleans up all sessions and releases resources. Stores session metadata to a file for future use.
+/// @details Every worker process stores its sessions on exit, so the file is merged into under a lock rather than
+/// overwritten, and replaced at once so a reader never sees it half written.
 void UserSessionManager::shutdown() {
 	DEBUG("Shutting down session manager and cleaning up all sessions");
 
+	std::string lockPath = _storagePath + SESSION_MANAGER_LOCK_FILE;
+	int lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (lockFd == -1 || flock(lockFd, LOCK_EX) == -1)
+		ERROR("Failed to lock session manager file: " << lockPath << ": " << strerror(errno));
+
 	std::string storagePath = _storagePath + SESSION_MANAGER_FILE;
-	std::ofstream outFile(storagePath, std::ios::trunc | std::ios::binary);
+	std::map<std::string, time_t> sessions = _readManagerFile(storagePath);
+	for (const auto &pair : _currentSessions) {
+		time_t &lastAccessTime = sessions[pair.first];
+		lastAccessTime = std::max(lastAccessTime, pair.second->lastAccessTime);
+	}
+
+	time_t currentTime = time(nullptr);
+	std::string tempPath = storagePath + "." + std::to_string(getpid());
+	std::ofstream outFile(tempPath, std::ios::trunc | std::ios::binary);
 	if (outFile.is_open()) {
 		std::vector<char> buffer;
 
-		for (const auto &pair : _currentSessions) {
+		for (const auto &pair : sessions) {
+			// Expired by whichever worker process cleaned it up last
+			if (pair.second + SESSION_MAX_STORAGE_AGE < currentTime)
+				continue ;
 			buffer.insert(buffer.end(), pair.first.begin(), pair.first.end());
-			BUFFER_INSERT(buffer, pair.second->lastAccessTime);
+			BUFFER_INSERT(buffer, pair.second);
 		}
 		outFile.write(buffer.data(), buffer.size());
 		outFile.close();
+		if (!outFile || std::rename(tempPath.c_str(), storagePath.c_str()) != 0) {
+			ERROR("Failed to write session manager file: " << storagePath);
+			std::remove(tempPath.c_str());
+		}
 	} else {
-		ERROR("Failed to open session manager file for writing: " << storagePath);
+		ERROR("Failed to open session manager file for writing: " << tempPath);
 	}
 
+	if (lockFd != -1)
+		close(lockFd);
 	_currentSessions.clear();
 }
 
@@ -2,69 +2,318 @@
 #include "print.hpp"
 
 #include <functional>
+#include <algorithm>
+#include <climits>
 #include <chrono>
-#include <set>
+#include <bit>
 
-int Timer::nextId = 1;
+#define TIMER_NO_INDEX UINT32_MAX
+#define TIMER_FREE_BUCKET (UINT32_MAX - 1)
+#define TIMER_OVERFLOW_BUCKET (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+#define TIMER_FIRING_BUCKET (TIMER_OVERFLOW_BUCKET + 1)
+#define TIMER_MAX_GENERATION ((1u << (31 - TIMER_ID_INDEX_BITS)) - 1)
 
-bool TimerEvent::operator<(const TimerEvent &other) const {
-	return time < other.time;
+static inline int make_event_id(uint32_t index, uint32_t generation) {
+	return static_cast<int>((generation << TIMER_ID_INDEX_BITS) | index);
+}
+
+static inline uint64_t level_mask(unsigned level) {
+	return ((uint64_t(1) << (level * TIMER_WHEEL_SLOT_BITS)) - 1);
+}
+
+static std::chrono::steady_clock::time_point steady_clock_now() {
+	return (std::chrono::steady_clock::now());
+}
+
+Timer::Timer() :
+	Timer(steady_clock_now) {}
+
+Timer::Timer(TimerClock clock) :
+	_clock(clock), _origin(clock()), _currentTick(0),
+	_events(), _freeList(TIMER_NO_INDEX), _activeEvents(0),
+	_buckets(), _occupied()
+{
+	_buckets.fill(TIMER_NO_INDEX);
+	_occupied.fill(0);
+}
+
+/// @brief Convert a point in time to a wheel tick.
+/// @param roundUp Round partial ticks up, so an event never fires before its time.
+uint64_t Timer::_toTick(std::chrono::steady_clock::time_point time, bool roundUp) const {
+	if (time <= _origin) return (0);
+	auto elapsed = time - _origin;
+	auto ticks = roundUp ? std::chrono::ceil<std::chrono::milliseconds>(elapsed) : std::chrono::floor<std::chrono::milliseconds>(elapsed);
+	return (static_cast<uint64_t>(ticks.count()));
+}
+
+/// @brief Resolve an event ID, rejecting IDs of events that were deleted or already fired.
+TimerEvent *Timer::_getEvent(int eventId) {
+	if (eventId <= 0) return (nullptr);
+
+	uint32_t index = static_cast<uint32_t>(eventId) & (TIMER_ID_MAX_EVENTS - 1);
+	uint32_t generation = static_cast<uint32_t>(eventId) >> TIMER_ID_INDEX_BITS;
+	if (index >= _events.size()) return (nullptr);
+
+	TimerEvent &event = _events[index];
+	if (event.generation != generation || event.bucket == TIMER_FREE_BUCKET)
+		return (nullptr);
+	return (&event);
+}
+
+uint32_t Timer::_allocate() {
+	uint32_t index = _freeList;
+	if (index != TIMER_NO_INDEX) {
+		_freeList = _events[index].next;
+	} else {
+		if (_events.size() >= TIMER_ID_MAX_EVENTS)
+			return (TIMER_NO_INDEX);
+		index = static_cast<uint32_t>(_events.size());
+		_events.push_back(TimerEvent{std::chrono::steady_clock::duration::zero(), 0, nullptr, 1, TIMER_FREE_BUCKET, TIMER_NO_INDEX, TIMER_NO_INDEX});
+	}
+
+	++_activeEvents;
+	_events[index].bucket = TIMER_NO_INDEX;
+	return (index);
+}
+
+/// @brief Return an unlinked event to the free list, invalidating its ID.
+void Timer::_release(uint32_t index) {
+	TimerEvent &event = _events[index];
+	event.callback = nullptr;
+	event.generation = event.generation % TIMER_MAX_GENERATION + 1;
+	event.bucket = TIMER_FREE_BUCKET;
+	event.prev = TIMER_NO_INDEX;
+	event.next = _freeList;
+	_freeList = index;
+	--_activeEvents;
+}
+
+void Timer::_link(uint32_t index, uint32_t bucket) {
+	TimerEvent &event = _events[index];
+	event.bucket = bucket;
+	event.prev = TIMER_NO_INDEX;
+	event.next = _buckets[bucket];
+	if (event.next != TIMER_NO_INDEX)
+		_events[event.next].prev = index;
+	_buckets[bucket] = index;
+
+	if (bucket < TIMER_OVERFLOW_BUCKET)
+		_occupied[bucket / TIMER_WHEEL_SLOTS] |= uint64_t(1) << (bucket % TIMER_WHEEL_SLOTS);
+}
+
+void Timer::_unlink(uint32_t index) {
+	TimerEvent &event = _events[index];
+	uint32_t bucket = event.bucket;
+
+	if (event.prev != TIMER_NO_INDEX)
+		_events[event.prev].next = event.next;
+	else
+		_buckets[bucket] = event.next;
+	if (event.next != TIMER_NO_INDEX)
+		_events[event.next].prev = event.prev;
+
+	if (bucket < TIMER_OVERFLOW_BUCKET && _buckets[bucket] == TIMER_NO_INDEX)
+		_occupied[bucket / TIMER_WHEEL_SLOTS] &= ~(uint64_t(1) << (bucket % TIMER_WHEEL_SLOTS));
+
+	event.bucket = TIMER_NO_INDEX;
+	event.prev = event.next = TIMER_NO_INDEX;
+}
+
+/// @brief Put an event in the bucket of the highest tick digit in which its expiry differs from the current tick.
+void Timer::_schedule(uint32_t index) {
+	TimerEvent &event = _events[index];
+	event.expiryTick = std::max(event.expiryTick, _currentTick);
+
+	uint64_t difference = event.expiryTick ^ _currentTick;
+	unsigned level = difference == 0 ? 0 : (std::bit_width(difference) - 1) / TIMER_WHEEL_SLOT_BITS;
+	if (level >= TIMER_WHEEL_LEVELS)
+		return (_link(index, TIMER_OVERFLOW_BUCKET));
+
+	uint32_t slot = (event.expiryTick >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+	_link(index, level * TIMER_WHEEL_SLOTS + slot);
+}
+
+/// @brief Redistribute the events of a bucket over the lower levels.
+void Timer::_cascade(uint32_t bucket) {
+	uint32_t index = _buckets[bucket];
+	_buckets[bucket] = TIMER_NO_INDEX;
+	if (bucket < TIMER_OVERFLOW_BUCKET)
+		_occupied[bucket / TIMER_WHEEL_SLOTS] &= ~(uint64_t(1) << (bucket % TIMER_WHEEL_SLOTS));
+
+	while (index != TIMER_NO_INDEX) {
+		uint32_t next = _events[index].next;
+		_schedule(index);
+		index = next;
+	}
+}
+
+/// @brief Move the wheel forward to a later tick.
+/// @details Every event has to be due at or after the new tick. Higher level events sit in the bucket
+/// of the digit they differ in, so any of them found in the bucket of the new tick's digit now share
+/// that digit and are cascaded, top level first so they can keep falling through the lower levels.
+void Timer::_advance(uint64_t tick) {
+	uint64_t previous = _currentTick;
+	_currentTick = tick;
+
+	if ((previous >> (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) != (tick >> (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)))
+		_cascade(TIMER_OVERFLOW_BUCKET);
+	for (unsigned level = TIMER_WHEEL_LEVELS - 1; level > 0; --level) {
+		uint32_t bucket = level * TIMER_WHEEL_SLOTS + ((tick >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1));
+		if (_buckets[bucket] != TIMER_NO_INDEX)
+			_cascade(bucket);
+	}
+}
+
+/// @brief Find the next tick at which a bucket has to be fired or cascaded.
+/// @return false if no events are scheduled.
+bool Timer::_nextTick(uint64_t &tick) const {
+	for (unsigned level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+		unsigned shift = level * TIMER_WHEEL_SLOT_BITS;
+		unsigned digit = (_currentTick >> shift) & (TIMER_WHEEL_SLOTS - 1);
+		uint64_t pending = _occupied[level] & (~uint64_t(0) << digit);
+		if (pending == 0) continue;
+
+		// Buckets below the current digit are empty, so the first one found is also the earliest
+		uint64_t blockStart = _currentTick & ~level_mask(level + 1);
+		tick = std::max(blockStart + (uint64_t(std::countr_zero(pending)) << shift), _currentTick);
+		return (true);
+	}
+
+	if (_buckets[TIMER_OVERFLOW_BUCKET] == TIMER_NO_INDEX)
+		return (false);
+	tick = (_currentTick | level_mask(TIMER_WHEEL_LEVELS)) + 1;
+	return (true);
 }
 
 /// @brief Add a new event to the timer.
 /// @param delay The delay after which the event should be triggered
 /// @param callback The function to call when the event is triggered
 /// @param isRecurring If true, the event will be repeated at the specified interval; otherwise, it will only be triggered once
-/// @return Returns the ID of the added event
+/// @return Returns the ID of the added event, or -1 if the timer is full
 int Timer::addEvent(std::chrono::steady_clock::duration delay, std::function<void()> callback, bool isRecurring) {
-	std::chrono::steady_clock::duration interval = isRecurring ? delay : std::chrono::steady_clock::duration::max();
-	std::chrono::steady_clock::time_point eventTime = std::chrono::steady_clock::now() + delay;
-	auto it = _events.insert(TimerEvent{interval, eventTime, callback, nextId++});
-	return (it->id);
+	uint32_t index = _allocate();
+	if (index == TIMER_NO_INDEX) {
+		ERROR("Timer is full, cannot add more than " << TIMER_ID_MAX_EVENTS << " events");
+		return (-1);
+	}
+
+	TimerEvent &event = _events[index];
+	event.interval = isRecurring ? delay : std::chrono::steady_clock::duration::max();
+	event.expiryTick = _toTick(_clock() + delay, true);
+	event.callback = std::move(callback);
+	_schedule(index);
+	return (make_event_id(index, event.generation));
+}
+
+/// @brief Move an event to a new deadline, counted from now.
+/// @param eventId The ID of the event to move
+/// @param delay The new delay after which the event should be triggered
+/// @return Returns 0 if the event was moved, -1 if the event was not found
+int Timer::rescheduleEvent(int eventId, std::chrono::steady_clock::duration delay) {
+	TimerEvent *event = _getEvent(eventId);
+	if (!event) return (-1);
+
+	uint32_t index = static_cast<uint32_t>(event - _events.data());
+	if (event->bucket != TIMER_NO_INDEX)
+		_unlink(index);
+	event->expiryTick = _toTick(_clock() + delay, true);
+	_schedule(index);
+	return (0);
 }
 
 /// @brief Delete an event by its ID
 /// @param eventId The ID of the event to delete
 /// @return Returns 0 if the event was deleted successfully, -1 if the event was not found
 int Timer::deleteEvent(int eventId) {
-	for (auto it = _events.begin(); it != _events.end(); ++it) {
-		if (it->id == eventId) {
-			_events.erase(it);
-			return (0);
-		}
-	}
+	TimerEvent *event = _getEvent(eventId);
+	if (!event) return (-1);
+
+	uint32_t index = static_cast<uint32_t>(event - _events.data());
+	if (event->bucket != TIMER_NO_INDEX)
+		_unlink(index);
+	_release(index);
+	return (0);
+}
+
+/// @brief Get the point in time at which processEvents() has work to do next
+/// @param time Set to the next deadline; it may be slightly early when higher levels have to be cascaded first
+/// @return Returns false if no events are scheduled
+bool Timer::getNextEventTime(std::chrono::steady_clock::time_point &time) const {
+	uint64_t tick;
+	if (!_nextTick(tick)) return (false);
 
-	return (-1);
+	time = _origin + std::chrono::milliseconds(tick);
+	return (true);
 }
 
 /// @brief Get the time until the next scheduled event
-/// @return Returns the duration until the next event, or max() if no events are scheduled
+/// @return Returns the amount of milliseconds until the next event, or -1 if no events are scheduled
 int Timer::getNextEventTimeoutMS() const {
-	if (_events.empty()) return (-1);
-	auto now = std::chrono::steady_clock::now();
-    auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(_events.begin()->time - now);
-    return diff.count() < 0 ? 0 : static_cast<int>(diff.count());
+	std::chrono::steady_clock::time_point time;
+	if (!getNextEventTime(time)) return (-1);
+
+	auto wait = time - _clock();
+	auto diff = std::chrono::ceil<std::chrono::milliseconds>(wait);
+	if (diff.count() <= 0) return (0);
+	return (static_cast<int>(std::min<decltype(diff.count())>(diff.count(), INT_MAX)));
 }
 
 /// @brief Process all events that are due
-/// This function checks the current time against the scheduled event times
-/// and calls the callback functions for events that are due.
+/// This function advances the wheel up to the current time, cascading higher levels
+/// on the way and calling the callback functions for events that are due.
 void Timer::processEvents() {
-	auto now = std::chrono::steady_clock::now();
-	while (!_events.empty() && _events.begin()->time <= now) {
-		auto event = *_events.begin();
-		_events.erase(_events.begin());
-		event.callback();
-
-		if (event.interval != std::chrono::steady_clock::duration::max()) {
-			event.time = std::max(event.time + event.interval, now);
-			_events.insert(event);
+	uint64_t nowTick = _toTick(_clock(), false);
+	uint64_t tick;
+
+	while (_nextTick(tick) && tick <= nowTick) {
+		_advance(tick);
+
+		// Move the due bucket aside, callbacks may add, move or delete any event, including these
+		uint32_t dueBucket = tick & (TIMER_WHEEL_SLOTS - 1);
+		while (_buckets[dueBucket] != TIMER_NO_INDEX) {
+			uint32_t index = _buckets[dueBucket];
+			_unlink(index);
+			_link(index, TIMER_FIRING_BUCKET);
+		}
+		_advance(tick + 1);
+
+		while (_buckets[TIMER_FIRING_BUCKET] != TIMER_NO_INDEX) {
+			uint32_t index = _buckets[TIMER_FIRING_BUCKET];
+			_unlink(index);
+
+			TimerEvent &event = _events[index];
+			std::function<void()> callback = std::move(event.callback);
+			std::chrono::steady_clock::duration interval = event.interval;
+			int eventId = make_event_id(index, event.generation);
+			if (interval == std::chrono::steady_clock::duration::max())
+				_release(index);
+
+			callback();
+
+			// Recurring events stay allocated while running, unless the callback deleted or moved them
+			TimerEvent *recurring = interval != std::chrono::steady_clock::duration::max() ? _getEvent(eventId) : nullptr;
+			if (recurring && recurring->bucket == TIMER_NO_INDEX) {
+				uint64_t intervalTicks = std::max<uint64_t>(std::chrono::ceil<std::chrono::milliseconds>(interval).count(), 1);
+				recurring->callback = std::move(callback);
+				recurring->expiryTick = tick + intervalTicks;
+				_schedule(index);
+			} else if (recurring) {
+				recurring->callback = std::move(callback);
+			}
 		}
 	}
+
+	// Nothing is due before nowTick + 1, skipping there still has to cascade whatever the skip reaches
+	if (_currentTick <= nowTick)
+		_advance(nowTick + 1);
 }
 
 /// @brief Clear all events from the timer
 /// This function removes all scheduled events from the timer.
 void Timer::clear() {
 	_events.clear();
+	_freeList = TIMER_NO_INDEX;
+	_activeEvents = 0;
+	_buckets.fill(TIMER_NO_INDEX);
+	_occupied.fill(0);
 }
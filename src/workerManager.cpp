@@ -0,0 +1,169 @@
+#include "workerManager.hpp"
+#include "server.hpp"
+#include "print.hpp"
+
+#include <sys/wait.h>
+#include <exception>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+#include <cstring>
+
+extern bool g_quit;
+
+WorkerManager::WorkerManager(HTTPRule &http) :
+    _httpRule(http),
+    _workers(http.workerProcesses.getWorkerCount(), -1),
+    _originalSignalMask() {}
+
+/// @brief Run a single reactor (event loop) until the process is asked to quit.
+/// @return The exit code of the worker.
+int WorkerManager::runWorker(HTTPRule &http) {
+    // Quit signals are only let through while the loop waits for events. One arriving
+    // between the g_quit check and the wait would leave it blocked until the next event.
+    sigset_t quitSignals, waitMask;
+    sigemptyset(&quitSignals);
+    sigaddset(&quitSignals, SIGINT);
+    sigaddset(&quitSignals, SIGTERM);
+    sigaddset(&quitSignals, SIGQUIT);
+    sigprocmask(SIG_BLOCK, &quitSignals, &waitMask);
+
+    int exitCode = 0;
+    try {
+        Server server(http);
+        while (!g_quit)
+            server.runOnce(&waitMask);
+        server.cleanUp();
+    } catch (const std::exception &e) {
+        std::cout << e.what() << std::endl;
+        exitCode = 1;
+    }
+    sigprocmask(SIG_SETMASK, &waitMask, nullptr);
+    return (exitCode);
+}
+
+/// @brief Pin the calling process to one of the CPU cores it is allowed to run on.
+/// @param index The index of the worker, used to pick a core in a round-robin fashion.
+void WorkerManager::_pinToCpu(size_t index) const {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+        ERROR("Failed to fetch cpu affinity: " << strerror(errno));
+        return ;
+    }
+
+    size_t allowedCount = CPU_COUNT(&allowed);
+    if (allowedCount == 0)
+        return ;
+
+    size_t target = index % allowedCount;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed) || target-- != 0)
+            continue ;
+
+        cpu_set_t pinned;
+        CPU_ZERO(&pinned);
+        CPU_SET(cpu, &pinned);
+        ERROR_IF(sched_setaffinity(0, sizeof(pinned), &pinned) == -1, "Failed to pin worker " << index << " to cpu " << cpu << ": " << strerror(errno));
+        DEBUG("Pinned worker " << index << " to cpu " << cpu);
+        return ;
+    }
+}
+
+/// @brief Fork a new worker process that runs its own reactor.
+/// @param index The index of the worker slot that is being (re)filled.
+/// @return The pid of the worker, or -1 if forking failed.
+pid_t WorkerManager::_spawnWorker(size_t index) {
+    pid_t pid = fork();
+    if (pid == -1) {
+        ERROR("Failed to fork worker " << index << ": " << strerror(errno));
+        return (-1);
+    }
+
+    if (pid == 0) {
+        sigprocmask(SIG_SETMASK, &_originalSignalMask, nullptr);
+        if (_httpRule.workerCpuAffinity.isEnabled())
+            _pinToCpu(index);
+        exit(runWorker(_httpRule));
+    }
+
+    PRINT("Started worker " << index << " with pid " << pid);
+    return (pid);
+}
+
+/// @brief Collect all exited workers. Workers that crashed are replaced, workers that
+/// exited on their own (e.g. because the sockets could not be set up) are not.
+void WorkerManager::_reapWorkers() {
+    int status;
+    pid_t pid;
+
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        for (size_t index = 0; index < _workers.size(); ++index) {
+            if (_workers[index] != pid)
+                continue ;
+
+            _workers[index] = -1;
+            if (WIFSIGNALED(status) && !g_quit) {
+                ERROR("Worker " << index << " (pid " << pid << ") was killed by signal " << WTERMSIG(status) << ", restarting it");
+                _workers[index] = _spawnWorker(index);
+            } else if (WIFEXITED(status)) {
+                ERROR_IF(WEXITSTATUS(status) != 0, "Worker " << index << " (pid " << pid << ") exited with status " << WEXITSTATUS(status));
+            }
+        }
+    }
+}
+
+/// @brief Ask all workers to shut down gracefully and wait for them to exit.
+void WorkerManager::_stopWorkers() {
+    for (pid_t pid : _workers)
+        if (pid != -1)
+            kill(pid, SIGTERM);
+
+    for (pid_t &pid : _workers) {
+        if (pid != -1)
+            waitpid(pid, nullptr, 0);
+        pid = -1;
+    }
+}
+
+size_t WorkerManager::_countRunningWorkers() const {
+    size_t count = 0;
+    for (pid_t pid : _workers)
+        if (pid != -1)
+            ++count;
+    return (count);
+}
+
+/// @brief Start all workers and supervise them until a termination signal arrives.
+/// @return The exit code of the master process.
+int WorkerManager::run() {
+    sigset_t waitedSignals;
+    sigemptyset(&waitedSignals);
+    sigaddset(&waitedSignals, SIGCHLD);
+    sigaddset(&waitedSignals, SIGINT);
+    sigaddset(&waitedSignals, SIGTERM);
+    sigaddset(&waitedSignals, SIGQUIT);
+    sigprocmask(SIG_BLOCK, &waitedSignals, &_originalSignalMask);
+
+    for (size_t index = 0; index < _workers.size(); ++index)
+        _workers[index] = _spawnWorker(index);
+
+    while (_countRunningWorkers() > 0) {
+        int signum = sigwaitinfo(&waitedSignals, nullptr);
+        if (signum == SIGCHLD) {
+            _reapWorkers();
+            continue ;
+        }
+
+        if (signum != -1) {
+            DEBUG("Master received signal " << signum << ", stopping workers");
+            g_quit = true;
+            break ;
+        }
+    }
+
+    bool workersFailed = !g_quit;
+    _stopWorkers();
+    sigprocmask(SIG_SETMASK, &_originalSignalMask, nullptr);
+    return (workersFailed ? 1 : 0);
+}
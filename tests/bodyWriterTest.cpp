@@ -0,0 +1,174 @@
+#include "body.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": " << __VA_ARGS__ << std::endl; \
+		++g_failures; \
+	} \
+} while (0)
+
+/// @brief A peer that takes at most the next of `budgets` bytes per write, like a socket whose buffer
+/// is nearly full, and keeps what it took in `wire`.
+struct ShortWriter : public FDWriter {
+	std::vector<size_t> budgets;
+	size_t next = 0;
+	std::string wire;
+
+	explicit ShortWriter(std::vector<size_t> budgets) : FDWriter(0, FDState::Ready), budgets(std::move(budgets)) {}
+
+	ssize_t writeAsVector(const iovec *vectors, int count, bool) {
+		size_t budget = budgets[next++ % budgets.size()];
+		size_t written = 0;
+		for (int i = 0; i < count && written < budget; ++i) {
+			size_t step = std::min(budget - written, vectors[i].iov_len);
+			wire.append(static_cast<const char *>(vectors[i].iov_base), step);
+			written += step;
+		}
+		if (written == 0) {
+			errno = EAGAIN;
+			return (-1);
+		}
+		return (static_cast<ssize_t>(written));
+	}
+};
+
+typedef BodyWriter<FDReader, ShortWriter> Writer;
+
+static std::string chunk(std::string_view data) {
+	char header[HTTP_CHUNK_HEADER_SIZE];
+	return (std::string(header, FDWriter::formatChunkHeader(header, data.size())) + std::string(data) + "\r\n");
+}
+
+static void testChunkHeader() {
+	struct { size_t size; std::string_view header; } cases[] = {
+		{0, "0\r\n"}, {1, "1\r\n"}, {15, "f\r\n"}, {16, "10\r\n"}, {DEFAULT_CHUNK_SIZE, "2000\r\n"},
+		{0xabcdef, "abcdef\r\n"}, {SIZE_MAX, "ffffffffffffffff\r\n"},
+	};
+	for (auto [size, expected] : cases) {
+		char header[HTTP_CHUNK_HEADER_SIZE];
+		std::string_view formatted(header, FDWriter::formatChunkHeader(header, size));
+		CHECK(formatted == expected, "chunk header of " << size << ": " << formatted);
+	}
+}
+
+static std::string body(size_t size) {
+	std::string data(size, '\0');
+	for (size_t i = 0; i < size; ++i)
+		data[i] = static_cast<char>('a' + i % 26);
+	return (data);
+}
+
+/// @brief A head, a body chunked straight out of a reader and a last string chunk, through a peer taking
+/// `budgets` bytes per write. Whatever the peer refuses must go out next, once, in order, and the reader
+/// may only lose the bytes the peer took.
+static void testChunkedFromReader(const std::vector<size_t> &budgets) {
+	const std::string head = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+	const std::string data = body(DEFAULT_CHUNK_SIZE * 2 + 1000);
+	std::string expected = head;
+	for (size_t offset = 0; offset < data.size(); offset += DEFAULT_CHUNK_SIZE)
+		expected += chunk(std::string_view(data).substr(offset, DEFAULT_CHUNK_SIZE));
+	expected += chunk("tail") + "0\r\n\r\n";
+
+	FDReader reader;
+	reader.appendToReadBuffer(data);
+	ShortWriter peer(budgets);
+	Writer writer;
+	writer.queue(head);
+
+	for (int round = 0; reader.getReadBufferSize() > 0 && round < 100000; ++round) {
+		writer.sendBodyAsHTTPChunk(reader, peer);
+		// The chunk is framed around the reader's bytes, they leave it as they go out
+		size_t consumed = data.size() - reader.getReadBufferSize();
+		size_t sentBody = peer.wire.size() > head.size() ? peer.wire.size() - head.size() : 0;
+		CHECK(consumed <= sentBody, "the reader lost " << consumed << " bytes with " << sentBody << " of the body on the wire");
+		CHECK(writer.isStalled() == !writer.isEmpty(), "stalled " << writer.isStalled() << " with bytes left " << !writer.isEmpty());
+	}
+
+	writer.sendBodyAsHTTPChunk("tail", peer, true);
+	for (int round = 0; !writer.isEmpty() && round < 100000; ++round)
+		writer.tick(peer);
+
+	CHECK(writer.isEmpty() && writer.getPendingSize() == 0, "bytes left after the last tick");
+	CHECK(peer.wire == expected, "wire of " << peer.wire.size() << " bytes, expected " << expected.size()
+		<< " with writes of " << budgets[0] << "...");
+	CHECK(writer.amountOfBytesWritten == static_cast<ssize_t>(peer.wire.size()), "counted "
+		<< writer.amountOfBytesWritten << " bytes written of " << peer.wire.size());
+}
+
+/// @brief A new chunk written while the peer still owes part of a reader's chunk: the rest of that
+/// chunk is copied out of the reader and goes out ahead of the new one.
+static void testChunkBehindChunkInFlight() {
+	const std::string data = body(1000);
+	FDReader reader;
+	reader.appendToReadBuffer(data);
+	ShortWriter peer({100, 1000000});
+	Writer writer;
+
+	writer.sendBodyAsHTTPChunk(reader, peer);
+	CHECK(peer.wire.size() == 100 && writer.isStalled(), "first write took " << peer.wire.size());
+	CHECK(reader.getReadBufferSize() == data.size() - (100 - chunk(data).find("\r\n") - 2), "the reader kept "
+		<< reader.getReadBufferSize() << " bytes");
+
+	// The whole rest fits, but a peer taking nothing keeps it all pending
+	peer.budgets = {0};
+	writer.sendBodyAsHTTPChunk("next", peer, true);
+	CHECK(reader.getReadBufferSize() == 0, "the chunk in flight stayed in the reader");
+	CHECK(writer.getPendingSize() == chunk(data).size() - 100 + chunk("next").size() + 5, "pending "
+		<< writer.getPendingSize());
+
+	peer.budgets = {7};
+	for (int round = 0; !writer.isEmpty() && round < 100000; ++round)
+		writer.tick(peer);
+	CHECK(peer.wire == chunk(data) + chunk("next") + "0\r\n\r\n", "wire after the chunk in flight: " << peer.wire.size() << " bytes");
+}
+
+/// @brief Raw bytes out of a reader, bounded by `maxSize`, consumed only as far as the peer took them.
+static void testStringFromReader() {
+	const std::string data = body(DEFAULT_CHUNK_SIZE * 3);
+	FDReader reader;
+	reader.appendToReadBuffer(data);
+	ShortWriter peer({3000, 1, 5000});
+	Writer writer;
+	size_t limit = data.size() - 10;
+
+	for (int round = 0; peer.wire.size() < limit && round < 100000; ++round) {
+		writer.sendBodyAsString(reader, peer, limit - peer.wire.size());
+		CHECK(reader.getReadBufferSize() == data.size() - peer.wire.size(), "the reader kept " << reader.getReadBufferSize()
+			<< " bytes with " << peer.wire.size() << " on the wire");
+		CHECK(writer.getPendingSize() == 0, "raw bytes of the reader were queued");
+	}
+	CHECK(peer.wire == data.substr(0, limit), "wire of " << peer.wire.size() << " bytes, expected " << limit);
+}
+
+int main() {
+	testChunkHeader();
+	testChunkedFromReader({1000000});
+	testChunkedFromReader({1});
+	testChunkedFromReader({3, 0, 5});
+	testChunkedFromReader({DEFAULT_CHUNK_SIZE - 1});
+	testChunkedFromReader({DEFAULT_CHUNK_SIZE + 6});
+	std::mt19937 random(21);
+	for (int round = 0; round < 50; ++round) {
+		std::vector<size_t> budgets;
+		for (int i = 0; i < 16; ++i)
+			budgets.push_back(random() % 3 == 0 ? random() % 4 : random() % (DEFAULT_CHUNK_SIZE * 2));
+		testChunkedFromReader(budgets);
+	}
+	testChunkBehindChunkInFlight();
+	testStringFromReader();
+	if (g_failures != 0) {
+		std::cerr << "bodyWriterTest: " << g_failures << " failure(s)" << std::endl;
+		return (1);
+	}
+	std::cout << "bodyWriterTest: OK" << std::endl;
+	return (0);
+}
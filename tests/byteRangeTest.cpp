@@ -0,0 +1,108 @@
+#include "byteRange.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": " << __VA_ARGS__ << std::endl; \
+		++g_failures; \
+	} \
+} while (0)
+
+static std::string describe(RangeRequest result, const std::vector<ByteRange> &ranges) {
+	std::string text = result == RangeRequest::Ignored ? "ignored"
+		: result == RangeRequest::Unsatisfiable ? "unsatisfiable" : "satisfiable";
+	for (const ByteRange &range : ranges)
+		text += " " + std::to_string(range.first) + "-" + std::to_string(range.last);
+	return (text);
+}
+
+/// @brief Parse `value` against a file of `size` bytes and compare with the expected outcome, written
+/// like describe() prints it, e.g. "satisfiable 0-99 900-999".
+static void checkParse(const std::string &value, off_t size, const std::string &expected) {
+	std::vector<ByteRange> ranges;
+	RangeRequest result = ByteRange::parse(value, size, ranges);
+	std::string got = describe(result, ranges);
+	CHECK(got == expected, "Range: " << value << " of " << size << " bytes: expected " << expected << ", got " << got);
+}
+
+static void testSingleRanges() {
+	checkParse("bytes=0-99", 1000, "satisfiable 0-99");
+	checkParse("bytes=500-", 1000, "satisfiable 500-999");
+	checkParse("bytes=-100", 1000, "satisfiable 900-999");
+	checkParse("bytes=0-0", 1000, "satisfiable 0-0");
+	checkParse("bytes=999-999", 1000, "satisfiable 999-999");
+	// Clamped to the end of the file
+	checkParse("bytes=900-5000", 1000, "satisfiable 900-999");
+	checkParse("bytes=-5000", 1000, "satisfiable 0-999");
+	// The unit is case-insensitive, whitespace around the specs is allowed
+	checkParse("BYTES = 10-19 ", 1000, "satisfiable 10-19");
+}
+
+static void testMultipleRanges() {
+	checkParse("bytes=0-99, 900-999", 1000, "satisfiable 0-99 900-999");
+	// Kept in the order they were requested, overlapping or not
+	checkParse("bytes=500-599,0-99,50-149", 1000, "satisfiable 500-599 0-99 50-149");
+	// Ranges starting past the end are dropped, the others stay
+	checkParse("bytes=2000-2100,0-9", 1000, "satisfiable 0-9");
+	// Empty list elements don't count
+	checkParse("bytes=,0-9,,", 1000, "satisfiable 0-9");
+}
+
+static void testUnsatisfiable() {
+	checkParse("bytes=1000-", 1000, "unsatisfiable");
+	checkParse("bytes=1000-2000,5000-", 1000, "unsatisfiable");
+	checkParse("bytes=-0", 1000, "unsatisfiable");
+	checkParse("bytes=0-10", 0, "unsatisfiable");
+	checkParse("bytes=-10", 0, "unsatisfiable");
+}
+
+static void testIgnored() {
+	checkParse("", 1000, "ignored");
+	checkParse("bytes", 1000, "ignored");
+	checkParse("bytes=", 1000, "ignored");
+	checkParse("bytes=,", 1000, "ignored");
+	checkParse("items=0-9", 1000, "ignored");
+	checkParse("bytes=5", 1000, "ignored");
+	checkParse("bytes=9-5", 1000, "ignored");
+	checkParse("bytes=a-9", 1000, "ignored");
+	checkParse("bytes=0-9x", 1000, "ignored");
+	checkParse("bytes=+1-9", 1000, "ignored");
+	checkParse("bytes=--5", 1000, "ignored");
+	checkParse("bytes=0-9,x", 1000, "ignored");
+	// Offsets that overflow an off_t
+	checkParse("bytes=99999999999999999999-", 1000, "ignored");
+	checkParse("bytes=0-99999999999999999999", 1000, "ignored");
+
+	// One range over the limit makes the whole header be ignored
+	std::string value = "bytes=0-0";
+	for (int i = 1; i < BYTE_RANGE_MAX_RANGES; ++i)
+		value += "," + std::to_string(i) + "-" + std::to_string(i);
+	std::vector<ByteRange> ranges;
+	CHECK(ByteRange::parse(value, 1000, ranges) == RangeRequest::Satisfiable && ranges.size() == BYTE_RANGE_MAX_RANGES,
+		BYTE_RANGE_MAX_RANGES << " ranges should be satisfiable");
+	checkParse(value + ",100-100", 1000, "ignored");
+}
+
+static void testContentRange() {
+	CHECK(ByteRange({0, 99}).toContentRange(1000) == "bytes 0-99/1000", "Content-Range of 0-99");
+	CHECK(ByteRange({5, 5}).length() == 1, "a range of one byte");
+}
+
+int main() {
+	testSingleRanges();
+	testMultipleRanges();
+	testUnsatisfiable();
+	testIgnored();
+	testContentRange();
+	if (g_failures != 0) {
+		std::cerr << "byteRangeTest: " << g_failures << " failure(s)" << std::endl;
+		return (1);
+	}
+	std::cout << "byteRangeTest: OK" << std::endl;
+	return (0);
+}
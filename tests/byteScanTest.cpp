@@ -0,0 +1,79 @@
+#include "byteScan.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": " << __VA_ARGS__ << std::endl; \
+		++g_failures; \
+	} \
+} while (0)
+
+static const std::string_view g_needles[] = { "\r\n", "\r\n\r\n", "\n", "--boundary" };
+
+static void checkFind(std::string_view haystack, std::string_view needle, size_t from) {
+	size_t expected = haystack.find(needle, from);
+	size_t found = ByteScan::find(haystack, needle, from);
+	CHECK(found == expected, "needle of " << needle.size() << " bytes in " << haystack.size()
+		<< " bytes from " << from << ": expected " << expected << ", got " << found);
+}
+
+/// @brief A single needle at every offset of haystacks up to three AVX2 vectors long, searched from
+/// every start: covers matches straddling a 16 and 32 byte boundary, the tails the AVX2 loop hands to
+/// SSE2 and SSE2 to the scalar search, and `from` right before and at the end of the haystack.
+static void testEveryOffset() {
+	for (std::string_view needle : g_needles) {
+		for (size_t length = 0; length <= 96; ++length) {
+			for (size_t offset = 0; offset + needle.size() <= length; ++offset) {
+				std::string haystack(length, 'a');
+				haystack.replace(offset, needle.size(), needle);
+				for (size_t from = 0; from <= length + 1; ++from)
+					checkFind(haystack, needle, from);
+			}
+			checkFind(std::string(length, 'a'), needle, 0);
+		}
+	}
+}
+
+/// @brief Partial matches, a first byte without the last one or both without the middle, are no match.
+static void testPartialMatches() {
+	std::string haystack(64, 'a');
+	haystack.replace(30, 3, "\r\n\r");
+	checkFind(haystack, "\r\n\r\n", 0);
+	haystack.replace(40, 4, "\r\na\n");
+	checkFind(haystack, "\r\n\r\n", 0);
+	haystack.replace(50, 4, "\r\n\r\n");
+	checkFind(haystack, "\r\n\r\n", 0);
+	checkFind(haystack, "\r\n\r\n", 51);
+}
+
+/// @brief Random haystacks over a small alphabet, so that candidates are frequent.
+static void testRandomized() {
+	std::mt19937 random(42);
+	const char alphabet[] = "\r\na-";
+	for (int round = 0; round < 20000; ++round) {
+		std::string haystack(random() % 300, 'a');
+		for (char &c : haystack)
+			c = alphabet[random() % 4];
+		std::string_view needle = g_needles[random() % 3];
+		size_t from = haystack.empty() ? 0 : random() % (haystack.size() + 2);
+		checkFind(haystack, needle, from);
+	}
+}
+
+int main() {
+	testEveryOffset();
+	testPartialMatches();
+	testRandomized();
+	if (g_failures != 0) {
+		std::cerr << "byteScanTest: " << g_failures << " failure(s)" << std::endl;
+		return (1);
+	}
+	std::cout << "byteScanTest: OK (" << ByteScan::getImplementationName() << ")" << std::endl;
+	return (0);
+}
@@ -0,0 +1,112 @@
+#include "fastCGIRecord.hpp"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": " << __VA_ARGS__ << std::endl; \
+		++g_failures; \
+	} \
+} while (0)
+
+static std::string bytes(std::initializer_list<int> values) {
+	std::string text;
+	for (int value : values)
+		text.push_back(static_cast<char>(value));
+	return (text);
+}
+
+static void testPairLengths() {
+	struct { size_t length; std::string encoded; } cases[] = {
+		{0, bytes({0})}, {1, bytes({1})}, {127, bytes({0x7f})},
+		{128, bytes({0x80, 0, 0, 0x80})}, {255, bytes({0x80, 0, 0, 0xff})},
+		{FASTCGI_MAX_CONTENT_LENGTH, bytes({0x80, 0, 0xff, 0xff})},
+		{0x01020304, bytes({0x81, 0x02, 0x03, 0x04})}, {0x7fffffff, bytes({0xff, 0xff, 0xff, 0xff})},
+	};
+	for (const auto &[length, encoded] : cases) {
+		std::string buffer = "x";
+		FastCGIRecord::appendPairLength(buffer, length);
+		CHECK(buffer.substr(1) == encoded, "length " << length << " encoded in " << buffer.size() - 1 << " bytes");
+
+		size_t offset = 1, decoded = 0;
+		CHECK(FastCGIRecord::readPairLength(buffer, offset, decoded) && decoded == length && offset == buffer.size(),
+			"length " << length << " read back as " << decoded << ", offset " << offset);
+
+		// Cut anywhere inside, the length can't be read and the offset stays put
+		for (size_t end = 1; end < buffer.size(); ++end) {
+			offset = 1;
+			CHECK(!FastCGIRecord::readPairLength(std::string_view(buffer).substr(0, end), offset, decoded) && offset == 1,
+				"length " << length << " read out of " << end - 1 << " of its bytes");
+		}
+	}
+}
+
+/// @brief Pairs of every length encoding, read back the way FCGI_GET_VALUES_RESULT is.
+static void testPairs() {
+	std::vector<std::pair<std::string, std::string>> pairs = {
+		{"FCGI_MPXS_CONNS", "1"}, {"EMPTY", ""}, {std::string(127, 'n'), std::string(128, 'v')},
+		{"QUERY_STRING", std::string(70000, 'q')}, {std::string(200, 'N'), "x"},
+	};
+	std::string content;
+	for (const auto &[name, value] : pairs)
+		FastCGIRecord::appendPair(content, name, value);
+
+	size_t offset = 0;
+	for (const auto &[name, value] : pairs) {
+		size_t nameLength = 0, valueLength = 0;
+		bool isRead = FastCGIRecord::readPairLength(content, offset, nameLength)
+			&& FastCGIRecord::readPairLength(content, offset, valueLength);
+		CHECK(isRead && offset + nameLength + valueLength <= content.size(), "pair " << name.substr(0, 16) << " cut short");
+		if (!isRead || offset + nameLength + valueLength > content.size())
+			return ;
+		CHECK(content.substr(offset, nameLength) == name && content.substr(offset + nameLength, valueLength) == value,
+			"pair " << name.substr(0, 16) << " read back as " << nameLength << " and " << valueLength << " bytes");
+		offset += nameLength + valueLength;
+	}
+	CHECK(offset == content.size(), (content.size() - offset) << " bytes left after the pairs");
+}
+
+/// @brief Content of `size` bytes split into records: each no longer than FASTCGI_MAX_CONTENT_LENGTH, with
+/// a header giving the type, the request ID and its length, the parts making up the content in order.
+static void testSplit(size_t size) {
+	std::string content(size, '\0');
+	for (size_t i = 0; i < size; ++i)
+		content[i] = static_cast<char>(i * 7);
+
+	size_t records = 0;
+	std::string joined;
+	FastCGIRecord::split(FastCGIRecordType::Stdin, 0x1234, content, [&](std::string_view header, std::string_view part) {
+		++records;
+		const unsigned char *bytes = reinterpret_cast<const unsigned char *>(header.data());
+		size_t length = (static_cast<size_t>(bytes[4]) << 8) | bytes[5];
+		CHECK(header.size() == FASTCGI_HEADER_SIZE && bytes[0] == FASTCGI_VERSION
+			&& bytes[1] == static_cast<unsigned char>(FastCGIRecordType::Stdin) && bytes[2] == 0x12 && bytes[3] == 0x34
+			&& bytes[6] == 0 && bytes[7] == 0, "header of record " << records << " of " << size << " bytes");
+		CHECK(length == part.size() && part.size() <= FASTCGI_MAX_CONTENT_LENGTH, "record " << records << " of " << size
+			<< " bytes carries " << part.size() << " bytes, its header says " << length);
+		joined.append(part);
+	});
+
+	size_t expected = size == 0 ? 1 : (size + FASTCGI_MAX_CONTENT_LENGTH - 1) / FASTCGI_MAX_CONTENT_LENGTH;
+	CHECK(records == expected, size << " bytes split into " << records << " records, expected " << expected);
+	CHECK(joined == content, size << " bytes split and joined back into " << joined.size() << " different bytes");
+}
+
+int main() {
+	testPairLengths();
+	testPairs();
+	for (size_t size : {0, 1, FASTCGI_MAX_CONTENT_LENGTH - 1, FASTCGI_MAX_CONTENT_LENGTH, FASTCGI_MAX_CONTENT_LENGTH + 1,
+			FASTCGI_MAX_CONTENT_LENGTH * 2, FASTCGI_MAX_CONTENT_LENGTH * 3 + 17})
+		testSplit(size);
+	if (g_failures != 0) {
+		std::cerr << "fastCGIRecordTest: " << g_failures << " failure(s)" << std::endl;
+		return (1);
+	}
+	std::cout << "fastCGIRecordTest: OK" << std::endl;
+	return (0);
+}
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""HEAD requests on the static path: same head as the GET, no body on the wire."""
+
+import os
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+WEBSERV = os.environ.get("WEBSERV", os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "webserv"))
+failures = 0
+
+
+def check(condition, message):
+    global failures
+    if not condition:
+        print(f"headTest: {message}", file=sys.stderr)
+        failures += 1
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def read_response(sock, buffer, is_head):
+    """Read one response off the socket, returns (status, headers, body, rest of the buffer)."""
+    while b"\r\n\r\n" not in buffer:
+        data = sock.recv(65536)
+        if not data:
+            raise ConnectionError("connection closed before the head")
+        buffer += data
+
+    head, buffer = buffer.split(b"\r\n\r\n", 1)
+    lines = head.decode().split("\r\n")
+    status = int(lines[0].split(" ")[1])
+    headers = {}
+    for line in lines[1:]:
+        name, value = line.split(":", 1)
+        headers[name.strip().lower()] = value.strip()
+
+    if is_head:
+        return status, headers, b"", buffer
+
+    if headers.get("transfer-encoding") == "chunked":
+        body = b""
+        while True:
+            while b"\r\n" not in buffer:
+                buffer += sock.recv(65536)
+            size_line, buffer = buffer.split(b"\r\n", 1)
+            size = int(size_line, 16)
+            while len(buffer) < size + 2:
+                buffer += sock.recv(65536)
+            body, buffer = body + buffer[:size], buffer[size + 2:]
+            if size == 0:
+                return status, headers, body, buffer
+
+    length = int(headers.get("content-length", "0"))
+    while len(buffer) < length:
+        buffer += sock.recv(65536)
+    return status, headers, buffer[:length], buffer[length:]
+
+
+def exchange(port, requests):
+    """Pipeline (method, path, extra headers) requests on one connection and read every response."""
+    with socket.create_connection(("127.0.0.1", port), timeout=5) as sock:
+        for method, path, extra in requests:
+            sock.sendall(f"{method} {path} HTTP/1.1\r\nHost: localhost\r\n{extra}\r\n".encode())
+
+        responses, buffer = [], b""
+        for method, _, _ in requests:
+            status, headers, body, buffer = read_response(sock, buffer, method == "HEAD")
+            responses.append((status, headers, body))
+
+        # Whatever is left would be a body the HEAD should not have sent
+        sock.settimeout(0.2)
+        try:
+            buffer += sock.recv(65536)
+        except socket.timeout:
+            pass
+        check(buffer == b"", f"{len(buffer)} unexpected bytes after the responses")
+        return responses
+
+
+def main():
+    with tempfile.TemporaryDirectory() as root:
+        www = os.path.join(root, "www")
+        os.mkdir(www)
+        with open(os.path.join(www, "page.html"), "w") as f:
+            f.write("<html>" + "hello head " * 400 + "</html>")
+        with open(os.path.join(www, "data.bin"), "wb") as f:
+            f.write(os.urandom(200000))
+
+        port = free_port()
+        config = os.path.join(root, "head.conf")
+        with open(config, "w") as f:
+            f.write(f"""http {{
+    gzip on;
+    gzip_types text/html;
+    memory_cache 1mb 64kb;
+    open_file_cache 100 30s;
+
+    server {{
+        listen {port} default;
+        server_name localhost;
+
+        location / {{
+            alias {www};
+            allowed_methods GET;
+        }}
+
+        location /upload {{
+            alias {www};
+            allowed_methods POST;
+        }}
+
+        location /say {{
+            return 200 "said";
+        }}
+    }}
+}}
+""")
+
+        server = subprocess.Popen([WEBSERV, config], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        try:
+            for _ in range(50):
+                try:
+                    socket.create_connection(("127.0.0.1", port), timeout=1).close()
+                    break
+                except OSError:
+                    time.sleep(0.1)
+
+            for path, extra in [("/page.html", ""), ("/page.html", "Accept-Encoding: gzip\r\n"),
+                                ("/data.bin", ""), ("/missing.html", ""), ("/say", "")]:
+                [(head_status, head_headers, _)] = exchange(port, [("HEAD", path, extra)])
+                [(get_status, get_headers, get_body)] = exchange(port, [("GET", path, extra)])
+                check(head_status == get_status, f"HEAD {path} answered {head_status}, GET {get_status}")
+                for name in ("content-length", "content-encoding", "etag", "transfer-encoding"):
+                    check(head_headers.get(name) == get_headers.get(name),
+                          f"HEAD {path} {name}: {head_headers.get(name)!r}, GET: {get_headers.get(name)!r}")
+                if "content-length" in get_headers:
+                    check(int(get_headers["content-length"]) == len(get_body), f"GET {path} body does not match its length")
+
+            # A body sent along with the HEAD would be read as the head of the next response
+            for path in ("/page.html", "/data.bin", "/say"):
+                responses = exchange(port, [("HEAD", path, ""), ("GET", path, ""), ("HEAD", path, "")])
+                check([status for status, _, _ in responses] == [200, 200, 200], f"pipelined HEAD {path} answered {responses}")
+
+            [(status, headers, _)] = exchange(port, [("HEAD", "/data.bin", "Range: bytes=0-99\r\n")])
+            check(status == 200 and headers.get("content-length") == "200000", f"HEAD with a Range answered {status} {headers}")
+
+            [(status, _, _)] = exchange(port, [("HEAD", "/upload/page.html", "")])
+            check(status == 405, f"HEAD on a POST only location answered {status}")
+        finally:
+            server.send_signal(signal.SIGINT)
+            server.wait(timeout=10)
+
+    if failures:
+        print(f"headTest: {failures} failures", file=sys.stderr)
+        return 1
+    print("headTest: OK")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
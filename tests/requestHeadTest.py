@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Request heads read over several reads, and the 431 for heads past the parser's limits."""
+
+import os
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+WEBSERV = os.environ.get("WEBSERV", os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "webserv"))
+MAX_HEAD_SIZE = 16 * 1024
+MAX_FIELDS = 100
+failures = 0
+
+
+def check(condition, message):
+    global failures
+    if not condition:
+        print(f"requestHeadTest: {message}", file=sys.stderr)
+        failures += 1
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def status_of(port, pieces, pause=0.0):
+    """Send the head in `pieces`, pausing between them so each arrives in its own read, returns the status."""
+    with socket.create_connection(("127.0.0.1", port), timeout=5) as sock:
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        try:
+            for piece in pieces:
+                sock.sendall(piece)
+                time.sleep(pause)
+        except (BrokenPipeError, ConnectionResetError):
+            # A head rejected early may be answered before the rest of it is sent
+            pass
+        response = b""
+        while b"\r\n" not in response:
+            data = sock.recv(65536)
+            if not data:
+                break
+            response += data
+    return int(response.split(b" ")[1]) if response else 0
+
+
+def main():
+    with tempfile.TemporaryDirectory() as root:
+        www = os.path.join(root, "www")
+        os.mkdir(www)
+        with open(os.path.join(www, "page.html"), "w") as f:
+            f.write("<html>hello head</html>")
+
+        port = free_port()
+        config = os.path.join(root, "requestHead.conf")
+        with open(config, "w") as f:
+            f.write(f"""http {{
+    server {{
+        listen {port} default;
+        server_name localhost;
+
+        location / {{
+            alias {www};
+            allowed_methods GET;
+        }}
+    }}
+}}
+""")
+
+        server = subprocess.Popen([WEBSERV, config], cwd=root, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        try:
+            for _ in range(50):
+                try:
+                    socket.create_connection(("127.0.0.1", port), timeout=1).close()
+                    break
+                except OSError:
+                    time.sleep(0.1)
+
+            head = b"GET /page.html HTTP/1.1\r\nHost: localhost\r\nAccept: */*\r\nConnection: close\r\n\r\n"
+            check(status_of(port, [head]) == 200, "a head in one read")
+
+            # Every split point, the CRLFs between two reads included
+            for split in range(1, len(head)):
+                status = status_of(port, [head[:split], head[split:]], 0.02)
+                check(status == 200, f"a head split at {split} answered {status}")
+
+            status = status_of(port, [bytes([byte]) for byte in head], 0.002)
+            check(status == 200, f"a head sent byte by byte answered {status}")
+
+            big = b"GET /page.html HTTP/1.1\r\nHost: localhost\r\nX-Big: " + b"a" * MAX_HEAD_SIZE + b"\r\n\r\n"
+            status = status_of(port, [big])
+            check(status == 431, f"a head past {MAX_HEAD_SIZE} bytes answered {status}")
+
+            # Rejected once the limit is reached, without the end of the head ever arriving
+            status = status_of(port, [big[i:i + 1024] for i in range(0, MAX_HEAD_SIZE, 1024)], 0.01)
+            check(status == 431, f"an unterminated head past {MAX_HEAD_SIZE} bytes answered {status}")
+
+            fields = b"".join(b"X-%d: v\r\n" % i for i in range(MAX_FIELDS - 1))
+            status = status_of(port, [b"GET /page.html HTTP/1.1\r\nHost: localhost\r\n" + fields + b"\r\n"])
+            check(status == 200, f"a head with {MAX_FIELDS} fields answered {status}")
+            status = status_of(port, [b"GET /page.html HTTP/1.1\r\nHost: localhost\r\n" + fields + b"X-Last: v\r\n\r\n"])
+            check(status == 431, f"a head with {MAX_FIELDS + 1} fields answered {status}")
+        finally:
+            server.send_signal(signal.SIGINT)
+            server.wait(timeout=10)
+
+    if failures:
+        print(f"requestHeadTest: {failures} failures", file=sys.stderr)
+        return 1
+    print("requestHeadTest: OK")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,162 @@
+#include "requestParser.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": " << __VA_ARGS__ << std::endl; \
+		++g_failures; \
+	} \
+} while (0)
+
+static const std::string g_head =
+	"POST /upload/file.txt?name=a%20b HTTP/1.1\r\n"
+	"Host: localhost:8080\r\n"
+	"Content-Type:text/plain\r\n"
+	"Content-Length: 11 \r\n"
+	"X-Empty:\r\n"
+	"X-Tabs:\t value with  spaces\t\r\n"
+	"\r\n";
+
+/// @brief The tokens of a parsed head, joined, to compare two parses with each other.
+static std::string describe(const RequestParser &parser, std::string_view buffer) {
+	std::string text = std::string(parser.getMethod(buffer)) + "|" + std::string(parser.getTarget(buffer))
+		+ "|" + std::string(parser.getVersion(buffer));
+	for (const RequestParser::Field &field : parser.getFields())
+		text += "|" + std::string(field.name.in(buffer)) + "=" + std::string(field.value.in(buffer));
+	return (text);
+}
+
+/// @brief Feed `buffer` in pieces ending at `ends`, each call seeing everything received so far.
+static RequestParserStatus parseInPieces(RequestParser &parser, std::string_view buffer, const std::vector<size_t> &ends) {
+	RequestParserStatus status = RequestParserStatus::Incomplete;
+	for (size_t end : ends) {
+		status = parser.parse(buffer.substr(0, end));
+		if (status != RequestParserStatus::Incomplete)
+			break ;
+	}
+	return (status);
+}
+
+static void testTokens() {
+	RequestParser parser;
+	CHECK(parser.parse(g_head) == RequestParserStatus::Complete, "a complete head");
+	CHECK(parser.getHeadLength() == g_head.size(), "head length " << parser.getHeadLength() << " of " << g_head.size());
+	CHECK(describe(parser, g_head) == "POST|/upload/file.txt?name=a%20b|HTTP/1.1|Host=localhost:8080"
+		"|Content-Type=text/plain|Content-Length=11|X-Empty=|X-Tabs=value with  spaces", "tokens: " << describe(parser, g_head));
+
+	// The body and the next request stay out of the head
+	std::string pipelined = g_head + "hello world" + g_head;
+	parser.reset();
+	CHECK(parser.parse(pipelined) == RequestParserStatus::Complete && parser.getHeadLength() == g_head.size(),
+		"a head followed by a body and another head");
+
+	// Bare LF line endings, and empty lines ahead of the request line
+	std::string bare = "\r\n\nGET / HTTP/1.0\nHost: x\n\n";
+	parser.reset();
+	CHECK(parser.parse(bare) == RequestParserStatus::Complete && describe(parser, bare) == "GET|/|HTTP/1.0|Host=x",
+		"bare LF head: " << describe(parser, bare));
+}
+
+/// @brief Every split of the head into two reads, and a head arriving byte by byte, parse the same as the whole head.
+static void testResumes() {
+	RequestParser whole;
+	whole.parse(g_head);
+	std::string expected = describe(whole, g_head);
+
+	for (size_t split = 0; split <= g_head.size(); ++split) {
+		RequestParser parser;
+		RequestParserStatus status = parseInPieces(parser, g_head, {split, g_head.size()});
+		CHECK(status == RequestParserStatus::Complete && describe(parser, g_head) == expected,
+			"head split at " << split << ": " << describe(parser, g_head));
+	}
+
+	std::vector<size_t> bytes;
+	for (size_t end = 1; end <= g_head.size(); ++end)
+		bytes.push_back(end);
+	RequestParser parser;
+	CHECK(parseInPieces(parser, g_head, bytes) == RequestParserStatus::Complete && describe(parser, g_head) == expected,
+		"head byte by byte: " << describe(parser, g_head));
+	CHECK(parser.parse(g_head) == RequestParserStatus::Complete, "a complete head stays complete");
+
+	// Random reads, and a CRLF split between two of them
+	std::mt19937 random(7);
+	for (int round = 0; round < 1000; ++round) {
+		std::vector<size_t> ends;
+		for (size_t end = 0; end < g_head.size(); )
+			ends.push_back(end = std::min(g_head.size(), end + 1 + random() % 12));
+		RequestParser pieces;
+		CHECK(parseInPieces(pieces, g_head, ends) == RequestParserStatus::Complete && describe(pieces, g_head) == expected,
+			"head in random reads: " << describe(pieces, g_head));
+	}
+}
+
+/// @brief Heads past the size or field limit are TooLarge, answered with a 431, as soon as they outgrow it.
+static void testTooLarge() {
+	std::string huge = "GET / HTTP/1.1\r\nX-Big: " + std::string(REQUEST_PARSER_MAX_HEAD_SIZE, 'a') + "\r\n\r\n";
+	RequestParser parser;
+	CHECK(parser.parse(huge) == RequestParserStatus::TooLarge, "a head past REQUEST_PARSER_MAX_HEAD_SIZE");
+	CHECK(parser.hasFailed() && parser.parse("GET / HTTP/1.1\r\n\r\n") == RequestParserStatus::TooLarge,
+		"TooLarge is final until reset");
+	parser.reset();
+	CHECK(parser.parse("GET / HTTP/1.1\r\n\r\n") == RequestParserStatus::Complete, "reset parses the next head");
+
+	// Rejected while it trickles in, without waiting for the end of the head
+	parser.reset();
+	std::string_view unterminated(huge.data(), REQUEST_PARSER_MAX_HEAD_SIZE - 1);
+	CHECK(parser.parse(unterminated) == RequestParserStatus::Incomplete, "a head one byte under the limit");
+	CHECK(parser.parse(std::string_view(huge.data(), REQUEST_PARSER_MAX_HEAD_SIZE)) == RequestParserStatus::TooLarge,
+		"a head reaching the limit without ending");
+
+	// A head that fits ends within the limit, whatever follows it in the buffer
+	std::string fits = "GET / HTTP/1.1\r\n\r\n" + std::string(REQUEST_PARSER_MAX_HEAD_SIZE * 2, 'b');
+	parser.reset();
+	CHECK(parser.parse(fits) == RequestParserStatus::Complete, "a small head followed by a large body");
+
+	std::string fields = "GET / HTTP/1.1\r\n";
+	for (int i = 0; i < REQUEST_PARSER_MAX_FIELDS; ++i)
+		fields += "X-" + std::to_string(i) + ": v\r\n";
+	parser.reset();
+	CHECK(parser.parse(fields + "\r\n") == RequestParserStatus::Complete, REQUEST_PARSER_MAX_FIELDS << " fields");
+	parser.reset();
+	CHECK(parser.parse(fields + "X-One-Too-Many: v\r\n\r\n") == RequestParserStatus::TooLarge,
+		REQUEST_PARSER_MAX_FIELDS + 1 << " fields");
+}
+
+static void testInvalid() {
+	const char *heads[] = {
+		"GET /\r\n\r\n",
+		"GET  / HTTP/1.1\r\n\r\n",
+		"GET / FTP/1.1\r\n\r\n",
+		"GET / HTTP/\r\n\r\n",
+		"GET / HTTP/1.1 x\r\n\r\n",
+		"G(T / HTTP/1.1\r\n\r\n",
+		"GET / HTTP/1.1\r\nNo colon\r\n\r\n",
+		"GET / HTTP/1.1\r\nName : value\r\n\r\n",
+		"GET / HTTP/1.1\r\nHost: x\r\n folded\r\n\r\n",
+		"GET / HTTP/1.1\r\n: no name\r\n\r\n",
+	};
+	for (const char *head : heads) {
+		RequestParser parser;
+		CHECK(parser.parse(head) == RequestParserStatus::Invalid, "invalid head: " << std::string_view(head));
+	}
+}
+
+int main() {
+	testTokens();
+	testResumes();
+	testTooLarge();
+	testInvalid();
+	if (g_failures != 0) {
+		std::cerr << "requestParserTest: " << g_failures << " failure(s)" << std::endl;
+		return (1);
+	}
+	std::cout << "requestParserTest: OK" << std::endl;
+	return (0);
+}
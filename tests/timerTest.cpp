@@ -0,0 +1,112 @@
+#include "timer.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <cstdint>
+#include <map>
+
+static std::chrono::steady_clock::time_point g_now;
+static int g_failures = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": " << __VA_ARGS__ << std::endl; \
+		++g_failures; \
+	} \
+} while (0)
+
+static std::chrono::steady_clock::time_point fake_clock() {
+	return (g_now);
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point origin) {
+	return (std::chrono::duration<double, std::milli>(g_now - origin).count());
+}
+
+/// @brief An event on level 1 has to be cascaded when skipping past a level 0 wrap,
+/// even if an event added after the skip fires first.
+static void testCascadeAcrossWrap() {
+	Timer timer(fake_clock);
+	auto origin = g_now;
+	double firedA = -1, firedB = -1;
+
+	timer.addEvent(std::chrono::milliseconds(100), [&]() { firedA = elapsed_ms(origin); });
+	g_now = origin + std::chrono::microseconds(63500);
+	timer.processEvents();
+	timer.addEvent(std::chrono::milliseconds(3), [&]() { firedB = elapsed_ms(origin); });
+
+	int zeroTimeouts = 0;
+	while (g_now < origin + std::chrono::milliseconds(400)) {
+		int timeout = timer.getNextEventTimeoutMS();
+		if (timeout == -1) break;
+		if (timeout == 0) ++zeroTimeouts;
+		g_now += timeout == 0 ? std::chrono::steady_clock::duration::zero() : std::chrono::milliseconds(timeout);
+		timer.processEvents();
+		CHECK(zeroTimeouts < 8, "timer keeps asking for a zero timeout at " << elapsed_ms(origin) << "ms");
+		if (zeroTimeouts >= 8) break;
+	}
+
+	CHECK(firedB >= 66.5 && firedB < 68, "3ms event fired at " << firedB << "ms");
+	CHECK(firedA >= 100 && firedA < 101, "100ms event fired at " << firedA << "ms");
+	CHECK(timer.size() == 0, timer.size() << " events left in the timer");
+}
+
+/// @brief Random events and polling intervals spanning several levels, every event has to fire
+/// on the first poll at or after its deadline.
+static void testRandomSchedule() {
+	std::mt19937 random(42);
+	Timer timer(fake_clock);
+	auto origin = g_now;
+	std::map<int, std::chrono::steady_clock::time_point> pending;
+	size_t fired = 0;
+
+	for (int round = 0; round < 20000; ++round) {
+		if (random() % 3 == 0) {
+			// From level 0 up to level 4 of the wheel
+			static const uint64_t maxDelaysMS[] = {50, 3000, 200000, 20000000};
+			auto delay = std::chrono::microseconds(random() % (maxDelaysMS[random() % 4] * 1000));
+			auto deadline = g_now + delay;
+			auto id = std::make_shared<int>(-1);
+			*id = timer.addEvent(delay, [&, id, deadline]() {
+				CHECK(g_now >= deadline, "event fired " << std::chrono::duration<double, std::milli>(deadline - g_now).count() << "ms early");
+				pending.erase(*id);
+				++fired;
+			});
+			pending[*id] = deadline;
+		}
+
+		if (!pending.empty() && random() % 10 == 0) {
+			auto it = pending.begin();
+			std::advance(it, random() % pending.size());
+			CHECK(timer.deleteEvent(it->first) == 0, "failed to delete event " << it->first);
+			pending.erase(it);
+		}
+
+		g_now += std::chrono::microseconds(random() % (random() % 50 == 0 ? 5000000 : 2000));
+		timer.processEvents();
+
+		// Deadlines are rounded up to the next millisecond
+		for (const auto &event : pending)
+			CHECK(event.second + std::chrono::milliseconds(1) > g_now, "event " << event.first << " missed its deadline by "
+				<< std::chrono::duration<double, std::milli>(g_now - event.second).count() << "ms at " << elapsed_ms(origin) << "ms");
+		if (g_failures > 0) return ;
+	}
+
+	CHECK(fired > 0, "no event fired");
+	CHECK(timer.size() == pending.size(), "timer holds " << timer.size() << " events, expected " << pending.size());
+}
+
+int main() {
+	g_now = std::chrono::steady_clock::now();
+	testCascadeAcrossWrap();
+	testRandomSchedule();
+
+	if (g_failures > 0) {
+		std::cerr << "timerTest: " << g_failures << " failures" << std::endl;
+		return (1);
+	}
+	std::cout << "timerTest: OK" << std::endl;
+	return (0);
+}